@@ -0,0 +1,41 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#ifndef BACKGROUNDTASK_H
+#define BACKGROUNDTASK_H
+
+#include <QFutureWatcher>
+#include <QProgressDialog>
+#include <QString>
+#include <QtConcurrent>
+
+// Runs _function on the global thread pool and returns its result. A modal
+// busy dialog runs the event loop meanwhile, so the window keeps repainting
+// during benchmarks and log scans of several seconds.
+template <typename Result, typename Function>
+Result runInBackground(QWidget *_parent, const QString _label, Function _function) {
+    QProgressDialog progress(_label, QString(), 0, 0, _parent);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(0);
+
+    // finished() is always delivered through the event loop of exec()
+    QFutureWatcher<Result> watcher;
+    QObject::connect(&watcher, SIGNAL(finished()), &progress, SLOT(accept()));
+    watcher.setFuture(QtConcurrent::run(_function));
+    progress.exec();
+    return watcher.result();
+}
+
+#endif // BACKGROUNDTASK_H
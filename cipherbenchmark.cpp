@@ -0,0 +1,141 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "cipherbenchmark.h"
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cstring>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define CIPHERBENCHMARK_CPUID
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CIPHERBENCHMARK_CPUID
+#endif
+
+static bool fasterThan(const CipherScore &_a, const CipherScore &_b) {
+    return _a.megabytesPerSecond > _b.megabytesPerSecond;
+}
+
+CipherBenchmark::CipherBenchmark(int _millisecondsPerCipher, int _packetSize)
+    : duration(_millisecondsPerCipher), packetSize(_packetSize) {}
+
+double CipherBenchmark::measure(const QString _cipher, bool _aead) const {
+    const EVP_CIPHER *cipher = EVP_get_cipherbyname(_cipher.toLatin1().constData());
+    if(!cipher) {
+        return 0;
+    }
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    if(!ctx) {
+        return 0;
+    }
+
+    QByteArray key(EVP_CIPHER_key_length(cipher), '\x5a');
+    QByteArray iv(qMax(EVP_CIPHER_iv_length(cipher), 1), '\0');
+    QByteArray hmacKey(20, '\x3c');
+    QByteArray packet(packetSize, '\xa5');
+    QByteArray out(packetSize + EVP_CIPHER_block_size(cipher) + 16, '\0');
+    unsigned char *ivData = reinterpret_cast<unsigned char *>(iv.data());
+    unsigned char *outData = reinterpret_cast<unsigned char *>(out.data());
+    unsigned char tag[EVP_MAX_MD_SIZE];
+    unsigned int tagLength;
+
+    bool ok = EVP_EncryptInit_ex(ctx, cipher, 0,
+                                 reinterpret_cast<const unsigned char *>(key.constData()), 0) == 1;
+    qint64 bytes = 0;
+    quint32 packetId = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while(ok && timer.elapsed() < duration) {
+        // checking the clock every packet would show up in the numbers
+        for(int i = 0; ok && i < 64; ++i) {
+            memcpy(ivData, &++packetId, sizeof(packetId));
+            int length = 0;
+            int finalLength = 0;
+            ok = EVP_EncryptInit_ex(ctx, 0, 0, 0, ivData) == 1 &&
+                 EVP_EncryptUpdate(ctx, outData, &length,
+                                   reinterpret_cast<const unsigned char *>(packet.constData()),
+                                   packet.size()) == 1 &&
+                 EVP_EncryptFinal_ex(ctx, outData + length, &finalLength) == 1;
+            if(ok && _aead) {
+                ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, tag) == 1;
+            }
+            else if(ok) {
+                ok = HMAC(EVP_sha1(), hmacKey.constData(), hmacKey.size(),
+                          outData, length + finalLength, tag, &tagLength) != 0;
+            }
+            bytes += packet.size();
+        }
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+    EVP_CIPHER_CTX_free(ctx);
+
+    if(!ok || elapsed <= 0) {
+        return 0;
+    }
+    return bytes / (elapsed / 1e9) / (1024.0 * 1024.0);
+}
+
+QList<CipherScore> CipherBenchmark::run() const {
+    static const char *const aeadCiphers[] = {"AES-128-GCM", "AES-256-GCM", "CHACHA20-POLY1305"};
+    static const char *const legacyCiphers[] = {"AES-128-CBC", "AES-256-CBC", "BF-CBC"};
+
+    QList<CipherScore> scores;
+    for(int i = 0; i < 6; ++i) {
+        CipherScore score;
+        score.aead = i < 3;
+        score.name = score.aead ? aeadCiphers[i] : legacyCiphers[i - 3];
+        score.megabytesPerSecond = measure(score.name, score.aead);
+        if(score.megabytesPerSecond > 0) {
+            scores << score;
+        }
+    }
+    std::sort(scores.begin(), scores.end(), fasterThan);
+    return scores;
+}
+
+QStringList CipherBenchmark::dataCiphers(const QList<CipherScore> &_scores) {
+    QStringList ciphers;
+    for(QList<CipherScore>::const_iterator score = _scores.constBegin(); score != _scores.constEnd(); ++score) {
+        if(score->aead) {
+            ciphers << score->name;
+        }
+    }
+    return ciphers;
+}
+
+CipherBenchmark::AesSupport CipherBenchmark::aesSupport() {
+#ifdef CIPHERBENCHMARK_CPUID
+    unsigned int ecx;
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    ecx = info[2];
+#else
+    unsigned int eax, ebx, edx;
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return AesUnknown;
+    }
+#endif
+    return (ecx & (1u << 25)) ? AesHardware : AesSoftware;
+#else
+    return AesUnknown;
+#endif
+}
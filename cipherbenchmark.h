@@ -0,0 +1,50 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef CIPHERBENCHMARK_H
+#define CIPHERBENCHMARK_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+struct CipherScore
+{
+    QString name;
+    double megabytesPerSecond;  // single thread, i.e. per core
+    bool aead;                  // only AEAD ciphers can go into data-ciphers
+};
+
+// Encrypts data channel sized packets with every candidate cipher on one
+// thread for a fixed time, the way OpenVPN processes them: a fresh IV and a
+// tag (AEAD) or an HMAC-SHA1 (CBC) per packet.
+class CipherBenchmark
+{
+public:
+    enum AesSupport { AesHardware, AesSoftware, AesUnknown };
+
+    explicit CipherBenchmark(int _millisecondsPerCipher = 150, int _packetSize = 1400);
+
+    QList<CipherScore> run() const;     // fastest first, unsupported ciphers are left out
+    static QStringList dataCiphers(const QList<CipherScore> &_scores);
+    static AesSupport aesSupport();
+
+private:
+    double measure(const QString _cipher, bool _aead) const;
+
+    int duration;
+    int packetSize;
+};
+
+#endif // CIPHERBENCHMARK_H
@@ -0,0 +1,171 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "compressionbenchmark.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+
+#ifdef OPENVPNUI_HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef OPENVPNUI_HAVE_LZO
+#include <lzo/lzo1x.h>
+#endif
+
+CompressionBenchmark::CompressionBenchmark(int _millisecondsPerCodec, int _packetSize)
+    : duration(_millisecondsPerCodec), packetSize(_packetSize) {}
+
+QList<QByteArray> CompressionBenchmark::syntheticSamples() {
+    QList<QByteArray> samples;
+
+    // plain text protocols: markup and logs repeat a lot
+    QByteArray text;
+    for(int i = 0; text.size() < 256 * 1024; ++i) {
+        text += "<tr><td class=\"host\">host-" + QByteArray::number(i % 97) +
+                ".example.org</td><td>GET /index.html HTTP/1.1 200 " +
+                QByteArray::number(i * 7919 % 100000) + "</td></tr>\n";
+    }
+    samples << text;
+
+    // TLS, SSH and media streams are already encrypted or compressed
+    QByteArray random(256 * 1024, '\0');
+    quint32 state = 0x9e3779b9u;
+    for(int i = 0; i < random.size(); ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        random[i] = char(state);
+    }
+    samples << random;
+    return samples;
+}
+
+QList<QByteArray> CompressionBenchmark::loadSamples(const QStringList _files) {
+    QList<QByteArray> samples;
+    for(QStringList::const_iterator fileName = _files.constBegin(); fileName != _files.constEnd(); ++fileName) {
+        QFile file(*fileName);
+        if (!file.open(QIODevice::ReadOnly))
+                continue;
+        // a few megabytes are representative, whole disk images are not needed
+        samples << file.read(4 * 1024 * 1024);
+    }
+    return samples;
+}
+
+int CompressionBenchmark::compress(Codec _codec, const QByteArray &_packet, QByteArray &_out,
+                                   QByteArray &_work) {
+    switch(_codec) {
+    case Lz4:
+#ifdef OPENVPNUI_HAVE_LZ4
+        return LZ4_compress_default(_packet.constData(), _out.data(), _packet.size(), _out.size());
+#else
+        break;
+#endif
+    case Lzo: {
+#ifdef OPENVPNUI_HAVE_LZO
+        lzo_uint length = lzo_uint(_out.size());
+        if(lzo1x_1_compress(reinterpret_cast<const unsigned char *>(_packet.constData()),
+                            lzo_uint(_packet.size()),
+                            reinterpret_cast<unsigned char *>(_out.data()), &length,
+                            _work.data()) != LZO_E_OK) {
+            return 0;
+        }
+        return int(length);
+#else
+        break;
+#endif
+    }
+    case Deflate:
+        // qCompress adds a four byte length prefix that OpenVPN would not send
+        return qCompress(_packet, 1).size() - 4;
+    }
+    Q_UNUSED(_out);
+    Q_UNUSED(_work);
+    return 0;
+}
+
+CompressionScore CompressionBenchmark::measure(Codec _codec, const QList<QByteArray> &_packets) const {
+    CompressionScore score;
+    score.name = _codec == Lz4 ? QString("lz4-v2") : _codec == Lzo ? QString("lzo")
+                                                   : QObject::tr("deflate (reference only)");
+    score.ratio = 1;
+    score.megabytesPerSecond = 0;
+    score.incompressible = 1;
+#ifndef OPENVPNUI_HAVE_LZ4
+    score.available = _codec != Lz4;
+#else
+    score.available = true;
+#endif
+#ifndef OPENVPNUI_HAVE_LZO
+    score.available = score.available && _codec != Lzo;
+#endif
+    if(!score.available || _packets.isEmpty()) {
+        return score;
+    }
+
+    QByteArray out(packetSize + packetSize / 16 + 64 + 3, '\0');
+    QByteArray work;
+#ifdef OPENVPNUI_HAVE_LZO
+    work.resize(LZO1X_1_MEM_COMPRESS);
+#endif
+
+    // the first pass yields the ratio, further passes only add timing samples
+    qint64 bytesIn = 0;
+    qint64 bytesOut = 0;
+    int skipped = 0;
+    for(QList<QByteArray>::const_iterator packet = _packets.constBegin(); packet != _packets.constEnd(); ++packet) {
+        int length = compress(_codec, *packet, out, work);
+        bytesIn += packet->size();
+        if(length <= 0 || length >= packet->size()) {
+            bytesOut += packet->size();
+            ++skipped;
+        }
+        else {
+            bytesOut += length;
+        }
+    }
+    score.ratio = double(bytesOut) / bytesIn;
+    score.incompressible = double(skipped) / _packets.size();
+
+    qint64 processed = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while(timer.elapsed() < duration) {
+        for(QList<QByteArray>::const_iterator packet = _packets.constBegin(); packet != _packets.constEnd(); ++packet) {
+            compress(_codec, *packet, out, work);
+            processed += packet->size();
+        }
+    }
+    score.megabytesPerSecond = processed / (timer.nsecsElapsed() / 1e9) / (1024.0 * 1024.0);
+    return score;
+}
+
+QList<CompressionScore> CompressionBenchmark::run(const QList<QByteArray> &_samples) const {
+#ifdef OPENVPNUI_HAVE_LZO
+    static const bool lzoReady = lzo_init() == LZO_E_OK;
+    Q_UNUSED(lzoReady);
+#endif
+    QList<QByteArray> packets;
+    for(QList<QByteArray>::const_iterator sample = _samples.constBegin(); sample != _samples.constEnd(); ++sample) {
+        for(int offset = 0; offset < sample->size(); offset += packetSize) {
+            packets << sample->mid(offset, packetSize);
+        }
+    }
+
+    QList<CompressionScore> scores;
+    scores << measure(Lz4, packets) << measure(Lzo, packets) << measure(Deflate, packets);
+    return scores;
+}
@@ -0,0 +1,55 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef COMPRESSIONBENCHMARK_H
+#define COMPRESSIONBENCHMARK_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+struct CompressionScore
+{
+    QString name;
+    bool available;             // false when the build has no such codec
+    double ratio;               // bytes sent / bytes in, so lower is better
+    double megabytesPerSecond;  // single thread, i.e. per core
+    double incompressible;      // share of packets sent uncompressed
+};
+
+// Compresses sample payloads one data channel packet at a time, as OpenVPN
+// does, and reports what each codec would save. Packets that do not shrink
+// are counted at full size, like OpenVPN sending them uncompressed.
+// LZ4 and LZO are only measured when the build found the libraries.
+class CompressionBenchmark
+{
+public:
+    explicit CompressionBenchmark(int _millisecondsPerCodec = 150, int _packetSize = 1400);
+
+    static QList<QByteArray> syntheticSamples();
+    static QList<QByteArray> loadSamples(const QStringList _files);
+
+    QList<CompressionScore> run(const QList<QByteArray> &_samples) const;
+
+private:
+    enum Codec { Lz4, Lzo, Deflate };
+    CompressionScore measure(Codec _codec, const QList<QByteArray> &_packets) const;
+    static int compress(Codec _codec, const QByteArray &_packet, QByteArray &_out, QByteArray &_work);
+
+    int duration;
+    int packetSize;
+};
+
+#endif // COMPRESSIONBENCHMARK_H
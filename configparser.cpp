@@ -16,21 +16,43 @@
 #include "defines.h"
 #include "configparser.h"
 #include "vpngui.h"
+#include "profilearchiver.h"
+#include "profileset.h"
+#include "pkiscanner.h"
+#include "statistics.h"
+#include "ccdgenerator.h"
+#include "routeaggregator.h"
+#include "instancegenerator.h"
+#include "loganalyzer.h"
+#include "backgroundtask.h"
 #include <QFile>
-#include <QMap>
 #include <QDebug>
+#include <QDir>
+#include <QApplication>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QLineEdit>
 #include <QMessageBox>
+#include <QStandardPaths>
+#include <QThread>
 
-ConfigParser::ConfigParser() {}
+static QString autosaveDirectory() {
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/autosave";
+}
+
+ConfigParser::ConfigParser()
+    : journal(autosaveDirectory()) {}
 
 void ConfigParser::readConfig() {
     readConfig(true);
 }
 
 void ConfigParser::cleanConfig() {
+    journal.discard();
+    currentFileName.clear();
 
-    fileContents.clear();
+    document.setFileContents(QString());
     updateManual();
 }
 
@@ -51,183 +73,578 @@ void ConfigParser::saveConfig() {
             return;
         }
     }
-    QFile *file = new QFile;
     QString fileName = QFileDialog::getSaveFileName(this,
         "Save OpenVPN Configuration", "", "Open VPN Configuration (*.ovpn)");
-    file->setFileName(fileName);
-    if (!file->open(QIODevice::WriteOnly | QIODevice::Text))
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+            return;
+    ScopedTiming timing("save");
+    QTextStream out(&file);
+
+    out << renderConfig();
+    out.flush();
+    if(out.status() == QTextStream::Ok) {
+        // includes are resolved and the journal is keyed relative to it
+        currentFileName = fileName;
+        journal.discard();
+    }
+
+}
+
+QString ConfigParser::renderConfig() const {
+    return document.render();
+}
+
+bool ConfigParser::selectArchive(QString *_fileName, ProfileArchiver::Format *_format,
+                                 bool *_userDirs) {
+
+    QString tarFilter = "Tar archive (*.tar)";
+    QString tarGzFilter = "Compressed tar archive (*.tar.gz)";
+    QString zipFilter = "Zip archive (*.zip)";
+    QString selectedFilter;
+    *_fileName = QFileDialog::getSaveFileName(this,
+        "Export OpenVPN Profiles", "", tarFilter + ";;" + tarGzFilter + ";;" + zipFilter,
+        &selectedFilter);
+    if(_fileName->isEmpty())
+            return false;
+
+    *_format = ProfileArchiver::Tar;
+    if(selectedFilter == tarGzFilter || _fileName->endsWith(".tar.gz") || _fileName->endsWith(".tgz")) {
+        *_format = ProfileArchiver::TarGz;
+    }
+    else if(selectedFilter == zipFilter || _fileName->endsWith(".zip")) {
+        *_format = ProfileArchiver::Zip;
+    }
+
+    QMessageBox userDirsMsg(
+                QMessageBox::Question,
+                tr("Export"),
+                tr("Put every profile into its own user directory?"),
+                QMessageBox::Yes | QMessageBox::No);
+
+    userDirsMsg.setButtonText(QMessageBox::Yes, tr("Yes"));
+    userDirsMsg.setButtonText(QMessageBox::No, tr("No"));
+    *_userDirs = userDirsMsg.exec() == QMessageBox::Yes;
+    return true;
+}
+
+void ConfigParser::exportProfileSet() {
+
+    QString userListName = QFileDialog::getOpenFileName(this,
+        "Select user list", "", "User list (*.txt *.csv);;All Files (*.*)");
+    if(userListName.isEmpty())
+            return;
+    QFile userList(userListName);
+    if (!userList.open(QIODevice::ReadOnly | QIODevice::Text))
+            return;
+
+    QString archiveName;
+    ProfileArchiver::Format format;
+    bool userDirs;
+    if(!selectArchive(&archiveName, &format, &userDirs))
+            return;
+
+    QFile archive(archiveName);
+    if (!archive.open(QIODevice::WriteOnly))
+            return;
+
+    // the user list is read line by line so only the profiles in flight are
+    // held in memory, however long the list is
+    ProfileArchiver archiver(&archive, format);
+    QString profileTemplate = renderConfig();
+    QTextStream in(&userList);
+    ProfileEntry entry;
+    int exported = 0;
+    bool ok = true;
+    while (ok && !in.atEnd()) {
+        if(ProfileSet::parseUserLine(in.readLine(), &entry)) {
+            ok = archiver.addFile(ProfileSet::profilePath(entry, userDirs),
+                                  ProfileSet::render(profileTemplate, entry).toUtf8());
+            ++exported;
+        }
+    }
+
+    if(!ok || !archiver.finish()) {
+        QMessageBox::warning(this, tr("Export failed"), archiver.errorString());
+        return;
+    }
+    QMessageBox::information(this, tr("Export finished"),
+                             tr("%1 profiles exported to %2.").arg(exported).arg(archiveName));
+}
+
+void ConfigParser::exportPkiProfiles() {
+
+    QString pkiDir = QFileDialog::getExistingDirectory(this, "Select PKI directory");
+    if(pkiDir.isEmpty())
+            return;
+
+    // every file is parsed, a large PKI takes a while
+    PkiScanner scanner;
+    bool scanned = runInBackground<bool>(this, tr("Reading %1...").arg(pkiDir),
+                                         [&scanner, pkiDir] { return scanner.scan(pkiDir); });
+    if(!scanned) {
+        QMessageBox::warning(this, tr("PKI import failed"), scanner.errorString());
+        return;
+    }
+    QList<PkiIdentity> identities = scanner.identities();
+    if(identities.isEmpty()) {
+        QMessageBox::warning(this, tr("PKI import failed"),
+                             tr("No certificate in %1 has a matching private key.").arg(pkiDir));
+        return;
+    }
+
+    QString archiveName;
+    ProfileArchiver::Format format;
+    bool userDirs;
+    if(!selectArchive(&archiveName, &format, &userDirs))
             return;
-    QTextStream out(file);
 
-    QString wholeConfig = "# Config created by OpenVPN UI #\n"
-                          "# https://github.com/vgezer/openvpnui #\n" +
-                          fileContents;
+    QFile archive(archiveName);
+    if (!archive.open(QIODevice::WriteOnly))
+            return;
 
-    out << wholeConfig;
+    ProfileArchiver archiver(&archive, format);
+    ConfigDocument profileTemplate = document;
+    profileTemplate.addTags("ca", scanner.caCertificate());
+    bool ok = true;
+    for(QList<PkiIdentity>::const_iterator identity = identities.constBegin();
+        ok && identity != identities.constEnd(); ++identity) {
+        ConfigDocument profile = profileTemplate;
+        profile.addTags("cert", identity->certificate);
+        profile.addTags("key", identity->key);
+
+        ProfileEntry entry;
+        entry.name = identity->name;
+        ok = archiver.addFile(ProfileSet::profilePath(entry, userDirs),
+                              ProfileSet::render(profile.render(), entry).toUtf8());
+    }
 
+    if(!ok || !archiver.finish()) {
+        QMessageBox::warning(this, tr("Export failed"), archiver.errorString());
+        return;
+    }
+
+    QString summary = tr("%1 profiles exported to %2.").arg(identities.size()).arg(archiveName);
+    QStringList unmatched = scanner.unmatched();
+    if(!unmatched.isEmpty()) {
+        summary += "\n\n" + tr("Skipped server certificates and files without a matching certificate"
+                                " or key:") + "\n" +
+                unmatched.join("\n");
+    }
+    QMessageBox::information(this, tr("Export finished"), summary);
 }
 
 void ConfigParser::createDefaultConfig() {
-    fileContents = "# Config created by OpenVPN UI #\n"
-                   "# https://github.com/vgezer/openvpnui #\n"
-                   "client\ndev tun\nproto udp\nremote example.org 1194\n"
-                   "resolv-retry infinite\nuser nobody\ngroup nogroup\n"
-                   "ns-cert-type server\ncomp-lzo\nnobind\npersist-key\n"
-                   "persist-tun\nverb 3\n";
-                    // do not forget new line at the end
-    emit paramChanged();
+    journal.discard();
+    currentFileName.clear();
+    setFileContents(ConfigDocument::defaultContents());
+    notifyParamChanged();
+    updateManual();
+}
+
+void ConfigParser::createDefaultServerConfig() {
+    journal.discard();
+    currentFileName.clear();
+    setFileContents(ConfigDocument::defaultServerContents());
+    notifyParamChanged();
     updateManual();
 }
 
+void ConfigParser::analyzeLog() {
+    Statistics::instance()->increment("user_actions");
+
+    QString fileName = QFileDialog::getOpenFileName(this,
+        "Select OpenVPN log", "", "OpenVPN log (*.log *.txt);;All Files (*.*)");
+    if(fileName.isEmpty())
+            return;
+
+    LogAnalyzer analyzer;
+    bool ok = runInBackground<bool>(this, tr("Analyzing %1...").arg(QFileInfo(fileName).fileName()),
+                                    [&analyzer, fileName] { return analyzer.analyze(fileName); });
+    if(!ok) {
+        QMessageBox::warning(this, tr("Log analysis"), analyzer.errorString());
+        return;
+    }
+
+    QStringList suggestions = analyzer.suggestions(renderConfig().split('\n'));
+    QMessageBox reportMsg(QMessageBox::Information, tr("Log analysis"),
+                          suggestions.isEmpty()
+                              ? tr("Nothing in the log points at the loaded profile.")
+                              : suggestions.join("\n\n"));
+    reportMsg.setDetailedText(analyzer.report());
+    reportMsg.exec();
+}
+
+void ConfigParser::scaleOutServer() {
+
+    if(!document.isConfigActive("server")) {
+        QMessageBox::warning(this, tr("Scale out server"),
+                             tr("Load or create a server configuration first."));
+        return;
+    }
+
+    bool ok;
+    int instances = QInputDialog::getInt(this, tr("Scale out server"),
+                                         tr("Number of instances (one per core):"),
+                                         QThread::idealThreadCount(), 1, 64, 1, &ok);
+    if(!ok)
+            return;
+    QString remoteHost = QInputDialog::getText(this, tr("Scale out server"),
+                                               tr("Server address for the client profile:"),
+                                               QLineEdit::Normal, "example.org", &ok);
+    if(!ok || remoteHost.trimmed().isEmpty())
+            return;
+
+    InstanceGenerator generator(renderConfig());
+    if(!generator.generate(instances, remoteHost.trimmed())) {
+        QMessageBox::warning(this, tr("Scale out server"), generator.errorString());
+        return;
+    }
+
+    QString outputDir = QFileDialog::getExistingDirectory(this, "Select output directory");
+    if(outputDir.isEmpty())
+            return;
+
+    QList<GeneratedConfig> configs = generator.configs();
+    for(QList<GeneratedConfig>::const_iterator config = configs.constBegin(); config != configs.constEnd(); ++config) {
+        QFile file(QDir(outputDir).filePath(config->fileName));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            QMessageBox::warning(this, tr("Scale out server"),
+                                 tr("Cannot write %1: %2").arg(file.fileName()).arg(file.errorString()));
+            return;
+        }
+        file.write(config->contents.toUtf8());
+    }
+    QString summary = tr("%1 server configurations and a client profile were written to %2.")
+            .arg(instances).arg(outputDir);
+    if(document.isConfigActive("client-config-dir")) {
+        summary += "\n\n" + tr("Every instance reads its own client config dir (%1 ...). Load each "
+                                "server configuration and generate its client config dir, so static "
+                                "addresses fall into the subnet of that instance.")
+                .arg(InstanceGenerator::withSuffix(document.getConfigValue("client-config-dir"), 0));
+    }
+    QMessageBox::information(this, tr("Scale out server"), summary);
+}
+
+void ConfigParser::optimizeRoutes() {
+
+    QStringList routes = document.linesStartingWith("route ");
+    routes << document.linesStartingWith("push \"route ");
+    if(routes.isEmpty()) {
+        QMessageBox::information(this, tr("Optimize routes"),
+                                 tr("The configuration has no route or pushed route lines."));
+        return;
+    }
+
+    bool ok;
+    QString exclusions = QInputDialog::getMultiLineText(this, tr("Optimize routes"),
+        tr("Networks to exclude, one per line (e.g. 10.1.2.0/24):"), QString(), &ok);
+    if(!ok)
+            return;
+
+    QStringList aggregated = RouteAggregator::aggregateDirectives(routes,
+            exclusions.split('\n', QString::SkipEmptyParts));
+
+    QMessageBox confirmationMsg(
+                QMessageBox::Question,
+                tr("Confirmation"),
+                tr("%1 route lines can be replaced by %2. Apply?")
+                    .arg(routes.size()).arg(aggregated.size()),
+                QMessageBox::Yes | QMessageBox::No);
+
+    confirmationMsg.setDetailedText(aggregated.join("\n"));
+    confirmationMsg.setButtonText(QMessageBox::Yes, tr("Yes"));
+    confirmationMsg.setButtonText(QMessageBox::No, tr("No"));
+
+    if (confirmationMsg.exec() == QMessageBox::No) {
+        return;
+    }
+
+    replaceDirectives(QStringList() << "route " << "push \"route ", aggregated);
+}
+
+void ConfigParser::generateClientConfigDir() {
+
+    quint32 network;
+    int prefixLength;
+    // "nopool" may follow the subnet once a pool has been split off
+    QString subnet = document.getConfigValue("server").simplified().section(' ', 0, 1);
+    if(!IpPool::parseSubnet(subnet, &network, &prefixLength)) {
+        QMessageBox::warning(this, tr("Client config dir"),
+                             tr("Set the \"server\" directive to the client subnet first."));
+        return;
+    }
+
+    // OpenVPN hands every free address of the subnet out dynamically, the
+    // static addresses need a range outside of ifconfig-pool
+    IpPool pool(network, prefixLength);
+    if(!pool.isValid()) {
+        QMessageBox::warning(this, tr("Client config dir"),
+                             tr("The server subnet %1 must be a /8 to /30 network.").arg(subnet));
+        return;
+    }
+    QStringList dynamic = document.getConfigValue("ifconfig-pool").simplified().split(' ');
+    bool ok = dynamic.size() >= 2;
+    quint32 first = ok ? IpPool::fromString(dynamic.at(0), &ok) : 0;
+    quint32 last = ok ? IpPool::fromString(dynamic.at(1), &ok) : 0;
+    if(!ok) {
+        // the lower half stays dynamic, the upper half is for ccd files
+        first = pool.network() + 2;
+        last = pool.network() + (quint32(1) << (31 - prefixLength)) - 1;
+    }
+    if(!pool.reserve(first, last)) {
+        QMessageBox::warning(this, tr("Client config dir"),
+                             tr("The dynamic pool %1 - %2 does not fit the server subnet.")
+                             .arg(IpPool::toString(first)).arg(IpPool::toString(last)));
+        return;
+    }
+
+    QString userListName = QFileDialog::getOpenFileName(this,
+        "Select user list", "", "User list (*.txt *.csv);;All Files (*.*)");
+    if(userListName.isEmpty())
+            return;
+    QString ccdDir = QFileDialog::getExistingDirectory(this, "Select client config directory");
+    if(ccdDir.isEmpty())
+            return;
+
+    QMessageBox pruneMsg(
+                QMessageBox::Question,
+                tr("Confirmation"),
+                tr("Remove client config files of users that are not in the list?"),
+                QMessageBox::Yes | QMessageBox::No);
+
+    pruneMsg.setButtonText(QMessageBox::Yes, tr("Yes"));
+    pruneMsg.setButtonText(QMessageBox::No, tr("No"));
+    bool prune = pruneMsg.exec() == QMessageBox::Yes;
+
+    CcdGenerator generator(pool);
+    ok = generator.generate(userListName, ccdDir, prune);
+    QString summary = tr("%1 client config files written, %2 removed.")
+            .arg(generator.written()).arg(generator.released());
+    if(ok) {
+        // an explicit ifconfig-pool is only accepted next to "server ... nopool"
+        QString netmask = IpPool::toString(IpPool::netmask(prefixLength));
+        replaceDirectives(QStringList() << "server " << "ifconfig-pool ",
+                          QStringList() << "server " + IpPool::toString(network) + " " + netmask + " nopool"
+                                        << "ifconfig-pool " + IpPool::toString(first) + " " +
+                                           IpPool::toString(last) + " " + netmask);
+        summary += "\n" + tr("Dynamic clients get %1 - %2.")
+                .arg(IpPool::toString(first)).arg(IpPool::toString(last));
+    }
+    if(!generator.errors().isEmpty()) {
+        summary += "\n\n" + generator.errors().join("\n");
+    }
+    if(ok) {
+        QMessageBox::information(this, tr("Client config dir"), summary);
+    }
+    else {
+        QMessageBox::warning(this, tr("Client config dir"), summary);
+    }
+}
+
 void ConfigParser::updateManual() {
     readConfig(false);
 }
 
 void ConfigParser::readConfig(bool _fromFile) {
-
-    QFile *file = new QFile;
-    QTextStream *in;
-    configFileNoValue->clear();
-    configFilePairs.clear();
-    configFileCaKey.clear();
+    Statistics::instance()->increment("user_actions");
 
     if(_fromFile) {
         QString fileName = QFileDialog::getOpenFileName(this,
             "Select OpenVPN Configuration", "", "Open VPN Configuration (*.ovpn)");
-        file->setFileName(fileName);
-        if (!file->open(QIODevice::ReadOnly | QIODevice::Text))
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
                 return;
-        in = new QTextStream(file);
+        QTextStream in(&file);
+        document.parse(in.readAll());
+        currentFileName = fileName;
+        journal.discard();
     }
     else {
-        in = new QTextStream(new QString(fileContents));
-        fileContents.clear();
+        // "Apply Config" drops comments, replay has to do the same
+        if(journal.isActive()) {
+            journal.append(AutosaveJournal::Parse);
+        }
+        document.parse(document.getFileContents());
     }
 
-        while (!in->atEnd()) {
+    // fragments come from the session cache, only changed ones are re-read
+    ResolvedIncludes resolved = includeResolver.resolve(currentFileName, document.getFileContents());
+    document.setIncluded(resolved.directives, resolved.origins);
+    if(_fromFile && !resolved.errors.isEmpty()) {
+        QMessageBox::warning(this, tr("Included files"), resolved.errors.join("\n"));
+    }
 
-            QString line = in->readLine();
-            if(line.size() > 0) {
-                if(line.at(0) != '#' && line.at(0) != ';') {
+    updateFields();
+}
 
-                    if(line.contains("<ca>") || line.contains("<cert>") || line.contains("<key>")) {
-                        configFileCaKey.insert("ca", line.contains("<ca>"));
-                        configFileCaKey.insert("cert", line.contains("<cert>"));
-                        configFileCaKey.insert("key", line.contains("<key>"));
+void ConfigParser::recoverAutosave() {
+    QList<RecoveredSession> sessions = AutosaveJournal::pending(autosaveDirectory());
+    for(QList<RecoveredSession>::const_iterator session = sessions.constBegin(); session != sessions.constEnd(); ++session) {
+        QMessageBox recoverMsg(
+                    QMessageBox::Question,
+                    tr("Recover unsaved changes"),
+                    tr("Unsaved changes to %1 from %2 were found. Restore them?")
+                        .arg(session->origin.isEmpty() ? tr("an untitled configuration") : session->origin)
+                        .arg(session->modified.toString(Qt::DefaultLocaleShortDate)),
+                    QMessageBox::Yes | QMessageBox::No);
 
-                    }
+        recoverMsg.setButtonText(QMessageBox::Yes, tr("Yes"));
+        recoverMsg.setButtonText(QMessageBox::No, tr("No"));
 
-                    //qDebug() << line;
-                    QMap<QString, QString>::const_iterator i = availablePairs.constBegin();
-                    while (i != availablePairs.constEnd()) {
+        if (recoverMsg.exec() == QMessageBox::No) {
+            AutosaveJournal::discard(*session);
+            continue;
+        }
 
-                        if(line.contains(i.key() + " ")) {
-                            configFilePairs.insert(i.key(), processLine(line));
-                            //qDebug() << "appending: " << i.key() << line;
-                        }
-                        ++i;
-                    }
-                    for(QStringList::iterator config = availableNoValue->begin(); config != availableNoValue->end(); ++config) {
-                        if(line.contains(*config) && !configFileNoValue->contains(*config)) {
+        // the restored text becomes the snapshot of a new session
+        currentFileName = session->origin;
+        document.setFileContents(session->contents);
+        journal.begin(currentFileName, session->contents);
+        updateManual();
+        return;
+    }
+}
 
-                            configFileNoValue->append(*config);
-                            //qDebug() << "appending (single): " << *config;
-                        }
-                    }
-                    fileContents += line + "\n";
-                }
-            }
+bool ConfigParser::prepareJournal() {
+    // the first edit after opening or saving starts a session, later edits
+    // only append; compaction keeps replay bounded by the profile size
+    if(!journal.isActive()) {
+        return journal.begin(currentFileName, document.getFileContents());
+    }
+    if(journal.needsCompaction()) {
+        journal.compact(document.getFileContents());
+    }
+    return journal.isActive();
+}
 
-        }
-        updateFields();
+// registered once, the counters below are updated on every edit
+static Statistics::Metric *signalsEmitted() {
+    static Statistics::Metric *const metric = Statistics::instance()->metric("signals_emitted", Statistics::Counter);
+    return metric;
 }
 
 void ConfigParser::updateFields() {
+    updateMemoryStatistics();
+    signalsEmitted()->increment();
     emit configFileOpened();
 }
 
-void ConfigParser::removeLine(const QString _line) {
-    if(this->isConfigActive(_line)) {
-
-        configFileNoValue->removeOne(_line);
-        configFilePairs.remove(_line.left(_line.indexOf(" ")));
-        QString configKey = _line.left(_line.indexOf(" "));
-        fileContents.remove(fileContents.indexOf(configKey), fileContents.indexOf("\n", fileContents.indexOf(configKey)) -
-                            fileContents.indexOf(configKey) + 1);
+void ConfigParser::notifyParamChanged() {
+    updateMemoryStatistics();
+    signalsEmitted()->increment();
+    emit paramChanged();
+}
 
-        emit paramChanged();
-    }
+void ConfigParser::updateMemoryStatistics() {
+    static Statistics::Metric *const fileContentsBytes =
+            Statistics::instance()->metric("file_contents_bytes", Statistics::Gauge);
+    static Statistics::Metric *const inlineBlockBytes =
+            Statistics::instance()->metric("inline_block_bytes", Statistics::Gauge);
+    static Statistics::Metric *const documentArenaBytes =
+            Statistics::instance()->metric("document_arena_bytes", Statistics::Gauge);
+    fileContentsBytes->setGauge(document.getFileContents().size() * qint64(sizeof(QChar)));
+    inlineBlockBytes->setGauge(document.inlineBlockBytes());
+    documentArenaBytes->setGauge(document.arenaBytes());
 }
 
-void ConfigParser::addLine(const QString _line) {
-    if(this->isConfigActive(_line)) {
-        removeLine(_line);
-    }
-    //qDebug() << "config is not active adding" + _line;
-    if(_line.indexOf(" ") > 0) {
-        configFilePairs.insert(_line.left(_line.indexOf(" ")), processLine(_line));
+void ConfigParser::removeLine(const QString _line) {
+    if(document.isConfigActive(_line) && prepareJournal()) {
+        journal.append(AutosaveJournal::RemoveLine, _line);
     }
-    else {
-        configFileNoValue->append(_line);
+    if(document.removeLine(_line)) {
+        notifyParamChanged();
     }
-    fileContents.append(_line + "\n");
-    emit paramChanged();
 }
 
-void ConfigParser::addTags(const QString _tag, const QString _content) {
-
-    if(!_content.contains("N/A")) {
-        QString toAdd = "\n<" + _tag + ">" + _content + "</" + _tag + ">";
-        removeTags(_tag);
-        addLine(toAdd);
-        configFileCaKey.insert(_tag, true);
-
+void ConfigParser::addLine(const QString _line, bool _replace) {
+    if(prepareJournal()) {
+        journal.append(_replace ? AutosaveJournal::AddLine : AutosaveJournal::AppendLine, _line);
     }
+    document.addLine(_line, _replace);
+    notifyParamChanged();
 }
 
-void ConfigParser::removeTags(const QString _tag) {
+QStringList ConfigParser::linesStartingWith(const QString _prefix) const {
+    return document.linesStartingWith(_prefix);
+}
 
-    int tagStart = fileContents.indexOf("<" + _tag + ">");
-    int tagFinish = fileContents.indexOf("</" + _tag + ">") + _tag.length() + 2;
-    // removal for tags is a bit different
-    fileContents.remove(fileContents.indexOf("<" + _tag + ">"), tagFinish - tagStart + 3);
-    configFileCaKey.insert(_tag, false);
+void ConfigParser::replaceDirectives(const QStringList _prefixes, const QStringList _lines) {
+    // one refresh for the whole batch instead of one per line
+    bool journaled = prepareJournal();
+    for(QStringList::const_iterator prefix = _prefixes.constBegin(); prefix != _prefixes.constEnd(); ++prefix) {
+        if(journaled) {
+            journal.append(AutosaveJournal::RemovePrefix, *prefix);
+        }
+        document.removeLinesStartingWith(*prefix);
+    }
+    for(QStringList::const_iterator line = _lines.constBegin(); line != _lines.constEnd(); ++line) {
+        if(journaled) {
+            journal.append(AutosaveJournal::AppendLine, *line);
+        }
+        document.addLine(*line, false);
+    }
+    updateFields();
 }
 
-QString ConfigParser::processLine(const QString _line) {
-    return _line.mid(_line.indexOf(" ")+1, _line.length());
+void ConfigParser::removeLinesStartingWith(const QString _prefix) {
+    if(!document.linesStartingWith(_prefix).isEmpty() && prepareJournal()) {
+        journal.append(AutosaveJournal::RemovePrefix, _prefix);
+    }
+    if(document.removeLinesStartingWith(_prefix) > 0) {
+        notifyParamChanged();
+    }
+}
 
+void ConfigParser::addTags(const QString _tag, const QString _content) {
+    if(!_content.contains("N/A") && prepareJournal()) {
+        journal.append(AutosaveJournal::AddTags, _tag, _content);
+    }
+    if(document.addTags(_tag, _content)) {
+        notifyParamChanged();
+    }
 }
 
+void ConfigParser::removeTags(const QString _tag) {
+    if(prepareJournal()) {
+        journal.append(AutosaveJournal::RemoveTags, _tag);
+    }
+    document.removeTags(_tag);
+}
 
 QString ConfigParser::getConfigValue(const QString _configKey) {
-    return configFilePairs[_configKey];
+    return document.getConfigValue(_configKey);
 }
 
 QString ConfigParser::getDefaultConfigValue(const QString _configKey) {
-    return availablePairs[_configKey];
+    return document.getDefaultConfigValue(_configKey);
 }
 
 bool ConfigParser::isConfigActive(const QString _configKey) {
-    bool first = configFileNoValue->contains(_configKey);
-    bool second = configFilePairs.contains(_configKey.left(_configKey.indexOf(" ")));
-    return first || second;
+    return document.isConfigActive(_configKey);
+}
+
+QString ConfigParser::directiveOrigin(const QString _configKey) {
+    return document.directiveOrigin(_configKey);
 }
 
 bool ConfigParser::isCaKeyActive(const QString _tag) {
-    return configFileCaKey.value(_tag);
+    return document.isCaKeyActive(_tag);
 }
 
 void ConfigParser::setCaKeyFlag(QString _tag, bool _active) {
-    configFileCaKey.insert(_tag, _active);
+    document.setCaKeyFlag(_tag, _active);
 }
 
 
 void ConfigParser::setFileContents(const QString _newValue) {
-    fileContents = _newValue;
+    // the manual editor calls this per keystroke, only the changed range is logged
+    if(_newValue != document.getFileContents() && prepareJournal()) {
+        journal.appendContents(document.getFileContents(), _newValue);
+    }
+    document.setFileContents(_newValue);
 }
 
 QString ConfigParser::getFileContents() const {
-    return fileContents;
+    return document.getFileContents();
 }
-
@@ -16,12 +16,11 @@
 #define CONFIGPARSER_H
 
 #include <QDialog>
-#include <QMap>
+#include "configdocument.h"
+#include "profilearchiver.h"
+#include "includeresolver.h"
+#include "autosavejournal.h"
 
-QT_BEGIN_NAMESPACE
-
-class QFile;
-QT_END_NAMESPACE
 class ConfigParser : public QDialog
 {
     Q_OBJECT
@@ -32,62 +31,48 @@ public:
     QString getDefaultConfigValue(const QString _configKey);
     QString getConfigValue(const QString _configKey);
     bool isConfigActive(const QString _configKey);
+    QString directiveOrigin(const QString _configKey);
     bool isCaKeyActive(const QString _tag);
     void setCaKeyFlag(QString _tag, bool _active);
-    void setFileName(const QString _fileName);
-    void addLine(QString _line);
+    void addLine(QString _line, bool _replace = true);
+    QStringList linesStartingWith(const QString _prefix) const;
+    void removeLinesStartingWith(const QString _prefix);
+    void replaceDirectives(const QStringList _prefixes, const QStringList _lines);
     void removeLine(QString _line);
     void addTags(const QString _tag, const QString _content);
     void removeTags(const QString _tag);
+    QString renderConfig() const;
 
 public slots:
     void readConfig(bool _fromFile);
     void readConfig();
     void updateManual();
+    void recoverAutosave();
     void createDefaultConfig();
+    void createDefaultServerConfig();
+    void generateClientConfigDir();
+    void optimizeRoutes();
+    void scaleOutServer();
+    void analyzeLog();
     void cleanConfig();
     void saveConfig();
+    void exportProfileSet();
+    void exportPkiProfiles();
 
 signals:
    bool configFileOpened();
    void paramChanged();
 
 private:
-    QMap<QString, QString> availablePairsDefault{{"dev", "tun"}, {"proto", "udp"},
-                                                 {"remote", "my-server-1 1194"},
-                                                 {"resolv-retry", "infinite"},
-                                                 {"user" , "nobody"},
-                                                 {"group", "nogroup"},
-                                                 {"ns-cert-type", "server"},
-                                                 {"verb" ,"3"}};
-
-    QStringList *availableNoValueDefault = new QStringList{"client", "nobind", "persist-key", "persist-tun", "comp-lzo"};
-
-    QMap<QString, QString> availablePairs{{"dev", "tun"}, {"dev-node", "MyTap"},
-                                          {"proto", "udp"}, {"remote", "my-server-1 1194"},
-                                          {"http-proxy","[proxy server] [proxy port #]"},
-                                          {"resolv-retry", "infinite"}, {"user", "nobody"},
-                                          {"group", "nogroup"}, {"ns-cert-type", "server"},
-                                          {"tls-auth","ta.key 1"}, {"cipher","x"}, {"verb","3"},
-                                          {"mute","20"}, {"tun-mtu","1500"},
-                                          {"route-delay","0"}};
-
-    QStringList *availableNoValue = new QStringList{"client", "remote-random",
-            "nobind", "persist-key", "persist-tun",
-            "mute-replay-warnings", "comp-lzo", "redirect-gateway",
-            "auth-user-pass", "auth-nocache", "float"};
-
-    QMap<QString, QString> configFilePairs;
-    QStringList *configFileNoValue = new QStringList();
-    QMap<QString, bool> configFileCaKey{{"ca", false}, {"cert", false}, {"key", false}};
-
-
-
-    QFile *file;
-    QString fileName;
-    QString fileContents;
-    QString processLine(const QString _line);
+    ConfigDocument document;
+    IncludeResolver includeResolver;
+    QString currentFileName;
+    AutosaveJournal journal;
+    bool prepareJournal();
     void updateFields();
+    void notifyParamChanged();
+    void updateMemoryStatistics();
+    bool selectArchive(QString *_fileName, ProfileArchiver::Format *_format, bool *_userDirs);
 };
 
 #endif // CONFIGPARSER_H
@@ -0,0 +1,310 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "autosavejournal.h"
+#include "configdocument.h"
+#include "documentarena.h"
+#include "statistics.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+
+static const quint32 SnapshotMagic = 0x4f564153;   // "OVAS"
+static const quint32 JournalMagic = 0x4f56414a;    // "OVAJ"
+static const int RecordHeaderSize = 6;              // quint32 size, quint16 checksum
+static const qint64 MinCompactionBytes = 64 * 1024;
+
+// a QString the way QDataStream writes it: byte length (0xffffffff for a
+// null string) and UTF-16, both big endian
+static int encodedSize(const QString &_text) {
+    return 4 + (_text.isNull() ? 0 : _text.size() * 2);
+}
+
+static char *encode(char *_out, const QString &_text) {
+    qToBigEndian(_text.isNull() ? quint32(0xffffffff) : quint32(_text.size() * 2),
+                 reinterpret_cast<uchar *>(_out));
+    _out += 4;
+    const QChar *chars = _text.constData();
+    for(int i = 0; i < _text.size(); ++i, _out += 2) {
+        qToBigEndian(chars[i].unicode(), reinterpret_cast<uchar *>(_out));
+    }
+    return _out;
+}
+
+AutosaveJournal::AutosaveJournal(const QString _directory)
+    : directory(_directory), generation(0), snapshotBytes(0) {}
+
+QString AutosaveJournal::baseName(const QString _directory, const QString _origin) {
+    QByteArray key = _origin.isEmpty() ? QByteArray("untitled") : _origin.toUtf8();
+    return QDir(_directory).filePath(
+                QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex().left(16)));
+}
+
+bool AutosaveJournal::isActive() const {
+    return journal.isOpen();
+}
+
+bool AutosaveJournal::begin(const QString _origin, const QString _contents) {
+    discard();
+    if(!QDir().mkpath(directory)) {
+        error = QObject::tr("Cannot create %1").arg(directory);
+        return false;
+    }
+    origin = _origin;
+    base = baseName(directory, _origin);
+    generation = 1;
+    return writeSnapshot(_contents) && openJournal();
+}
+
+bool AutosaveJournal::writeSnapshot(const QString _contents) {
+    // QSaveFile renames over the old snapshot only once everything is on disk
+    QSaveFile file(base + ".snapshot");
+    if(!file.open(QIODevice::WriteOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << SnapshotMagic << generation << origin << _contents;
+    if(!file.commit()) {
+        error = file.errorString();
+        return false;
+    }
+    snapshotBytes = QFileInfo(base + ".snapshot").size();
+    return true;
+}
+
+bool AutosaveJournal::openJournal() {
+    journal.close();
+    journal.setFileName(base + ".journal");
+    // unbuffered, every record reaches the OS before the edit is applied
+    if(!journal.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        error = journal.errorString();
+        return false;
+    }
+    QDataStream out(&journal);
+    out << JournalMagic << generation;
+    return true;
+}
+
+bool AutosaveJournal::append(Operation _operation, const QString _first, const QString _second) {
+    if(!journal.isOpen()) {
+        return false;
+    }
+    static Statistics::Metric *const appendTiming = Statistics::instance()->metric("autosave_append", Statistics::Timing);
+    ScopedTiming timing(appendTiming);
+
+    // encoded in place into a buffer that is reused for every record; it
+    // only grows, counted with the document's allocations, when a record is
+    // larger than all before it
+    const int payloadSize = 1 + encodedSize(_first) + encodedSize(_second);
+    const char *before = record.constData();
+    record.resize(RecordHeaderSize + payloadSize);
+    if(record.constData() != before) {
+        DocumentArena::countAllocation();
+    }
+    char *payload = record.data() + RecordHeaderSize;
+    payload[0] = char(quint8(_operation));
+    encode(encode(payload + 1, _first), _second);
+    qToBigEndian(quint32(payloadSize), reinterpret_cast<uchar *>(record.data()));
+    qToBigEndian(qChecksum(payload, uint(payloadSize)), reinterpret_cast<uchar *>(record.data() + 4));
+
+    // a single write, a crash can only leave a torn last record behind
+    if(journal.write(record) != record.size()) {
+        error = journal.errorString();
+        return false;
+    }
+    timing.setUnits(record.size());
+    static Statistics::Metric *const records = Statistics::instance()->metric("autosave_records", Statistics::Counter);
+    records->increment();
+    return true;
+}
+
+bool AutosaveJournal::appendContents(const QString &_before, const QString &_after) {
+    if(_before == _after) {
+        return true;
+    }
+    // keystrokes in the manual editor only touch a small range
+    int prefix = 0;
+    int shorter = qMin(_before.size(), _after.size());
+    while (prefix < shorter && _before.at(prefix) == _after.at(prefix)) {
+        ++prefix;
+    }
+    int suffix = 0;
+    while (suffix < shorter - prefix &&
+           _before.at(_before.size() - 1 - suffix) == _after.at(_after.size() - 1 - suffix)) {
+        ++suffix;
+    }
+    int removed = _before.size() - prefix - suffix;
+    return append(Splice, QString("%1:%2").arg(prefix).arg(removed),
+                  _after.mid(prefix, _after.size() - prefix - suffix));
+}
+
+bool AutosaveJournal::needsCompaction() const {
+    return journal.isOpen() && journal.size() > qMax(MinCompactionBytes, snapshotBytes);
+}
+
+bool AutosaveJournal::compact(const QString _contents) {
+    if(!journal.isOpen()) {
+        return false;
+    }
+    static Statistics::Metric *const compactTiming = Statistics::instance()->metric("autosave_compact", Statistics::Timing);
+    ScopedTiming timing(compactTiming);
+    // snapshot first: until the journal is rewritten its old generation
+    // keeps it from being replayed on top of the new snapshot
+    ++generation;
+    if(!writeSnapshot(_contents)) {
+        return false;
+    }
+    return openJournal();
+}
+
+void AutosaveJournal::discard() {
+    if(base.isEmpty()) {
+        return;
+    }
+    journal.close();
+    QFile::remove(base + ".journal");
+    QFile::remove(base + ".snapshot");
+    base.clear();
+}
+
+QString AutosaveJournal::errorString() const {
+    return error;
+}
+
+bool AutosaveJournal::replay(ConfigDocument &_document, Operation _operation,
+                             const QString &_first, const QString &_second) {
+    switch (_operation) {
+    case AddLine:
+        _document.addLine(_first, true);
+        return true;
+    case AppendLine:
+        _document.addLine(_first, false);
+        return true;
+    case RemoveLine:
+        _document.removeLine(_first);
+        return true;
+    case RemovePrefix:
+        _document.removeLinesStartingWith(_first);
+        return true;
+    case AddTags:
+        _document.addTags(_first, _second);
+        return true;
+    case RemoveTags:
+        _document.removeTags(_first);
+        return true;
+    case Parse:
+        _document.parse(_document.getFileContents());
+        return true;
+    case Splice: {
+        QString contents = _document.getFileContents();
+        bool posOk, removedOk;
+        int pos = _first.section(':', 0, 0).toInt(&posOk);
+        int removed = _first.section(':', 1, 1).toInt(&removedOk);
+        if(!posOk || !removedOk || pos < 0 || removed < 0 || pos + removed > contents.size()) {
+            return false;
+        }
+        _document.setFileContents(contents.replace(pos, removed, _second));
+        return true;
+    }
+    }
+    return false;
+}
+
+bool AutosaveJournal::recover(const QString _journalFile, RecoveredSession *_session) {
+    QString snapshotFile = _journalFile.left(_journalFile.size() - 8) + ".snapshot";
+    QFile snapshot(snapshotFile);
+    if(!snapshot.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream snapshotIn(&snapshot);
+    snapshotIn.setVersion(QDataStream::Qt_5_0);
+    quint32 magic, snapshotGeneration;
+    QString contents;
+    snapshotIn >> magic >> snapshotGeneration >> _session->origin >> contents;
+    if(snapshotIn.status() != QDataStream::Ok || magic != SnapshotMagic) {
+        return false;
+    }
+
+    // parse for the directive maps, but keep the text exactly as it was
+    ConfigDocument document;
+    document.parse(contents);
+    document.setFileContents(contents);
+    _session->journalFile = _journalFile;
+    _session->records = 0;
+    _session->modified = QFileInfo(snapshotFile).lastModified();
+
+    QFile file(_journalFile);
+    if(file.open(QIODevice::ReadOnly)) {
+        QByteArray data = file.readAll();
+        QDataStream in(data);
+        quint32 journalGeneration;
+        in >> magic >> journalGeneration;
+        // an older generation was already folded into the snapshot
+        if(in.status() == QDataStream::Ok && magic == JournalMagic &&
+                journalGeneration == snapshotGeneration) {
+            int pos = 8;
+            while (data.size() - pos >= RecordHeaderSize) {
+                quint32 size;
+                quint16 checksum;
+                in >> size >> checksum;
+                if(size > quint32(data.size() - pos - RecordHeaderSize)) {
+                    break;
+                }
+                const char *payload = data.constData() + pos + RecordHeaderSize;
+                if(qChecksum(payload, size) != checksum) {
+                    break;
+                }
+                QDataStream payloadIn(QByteArray::fromRawData(payload, int(size)));
+                payloadIn.setVersion(QDataStream::Qt_5_0);
+                quint8 operation;
+                QString first, second;
+                payloadIn >> operation >> first >> second;
+                if(payloadIn.status() != QDataStream::Ok ||
+                        !replay(document, Operation(operation), first, second)) {
+                    break;
+                }
+                ++_session->records;
+                pos += RecordHeaderSize + int(size);
+                in.skipRawData(int(size));
+            }
+            _session->modified = QFileInfo(file).lastModified();
+        }
+    }
+    _session->contents = document.getFileContents();
+    return true;
+}
+
+QList<RecoveredSession> AutosaveJournal::pending(const QString _directory) {
+    QList<RecoveredSession> sessions;
+    QFileInfoList journals = QDir(_directory).entryInfoList(QStringList() << "*.journal", QDir::Files,
+                                                           QDir::Time);
+    for(QFileInfoList::const_iterator info = journals.constBegin(); info != journals.constEnd(); ++info) {
+        RecoveredSession session;
+        if(recover(info->absoluteFilePath(), &session)) {
+            sessions << session;
+        }
+    }
+    return sessions;
+}
+
+void AutosaveJournal::discard(const RecoveredSession &_session) {
+    QFile::remove(_session.journalFile);
+    QFile::remove(_session.journalFile.left(_session.journalFile.size() - 8) + ".snapshot");
+}
@@ -0,0 +1,79 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef AUTOSAVEJOURNAL_H
+#define AUTOSAVEJOURNAL_H
+
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+class ConfigDocument;
+
+struct RecoveredSession
+{
+    QString journalFile;
+    QString origin;         // file the session was editing, empty if untitled
+    QString contents;
+    QDateTime modified;
+    int records;
+};
+
+// Crash-safe autosave for one document. The document is written once as a
+// snapshot, after that every edit is appended as a small checksummed record,
+// so the cost of an edit depends on the edit and not on the profile. When
+// the records outgrow the snapshot they are folded into a new one. Snapshot
+// and journal carry a generation so a crash half way through a compaction
+// never replays records twice. A torn record at the end is ignored.
+class AutosaveJournal
+{
+public:
+    enum Operation { AddLine = 1, AppendLine, RemoveLine, RemovePrefix,
+                     AddTags, RemoveTags, Splice, Parse };
+
+    explicit AutosaveJournal(const QString _directory);
+
+    bool isActive() const;
+    bool begin(const QString _origin, const QString _contents);
+    bool append(Operation _operation, const QString _first = QString(),
+                const QString _second = QString());
+    bool appendContents(const QString &_before, const QString &_after);
+    bool needsCompaction() const;
+    bool compact(const QString _contents);
+    void discard();
+    QString errorString() const;
+
+    static QList<RecoveredSession> pending(const QString _directory);
+    static void discard(const RecoveredSession &_session);
+
+private:
+    static QString baseName(const QString _directory, const QString _origin);
+    static bool replay(ConfigDocument &_document, Operation _operation,
+                       const QString &_first, const QString &_second);
+    static bool recover(const QString _journalFile, RecoveredSession *_session);
+    bool writeSnapshot(const QString _contents);
+    bool openJournal();
+
+    QString directory;
+    QString origin;
+    QString base;
+    QFile journal;
+    QByteArray record;      // reused by append()
+    quint32 generation;
+    qint64 snapshotBytes;
+    QString error;
+};
+
+#endif // AUTOSAVEJOURNAL_H
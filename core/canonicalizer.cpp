@@ -0,0 +1,215 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "canonicalizer.h"
+#include <QFile>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+static const quint64 c1 = Q_UINT64_C(0x87c37b91114253d5);
+static const quint64 c2 = Q_UINT64_C(0x4cf5ad432745937f);
+
+static inline quint64 rotl64(quint64 _x, int _r) {
+    return (_x << _r) | (_x >> (64 - _r));
+}
+
+static inline quint64 fmix64(quint64 _k) {
+    _k ^= _k >> 33;
+    _k *= Q_UINT64_C(0xff51afd7ed558ccd);
+    _k ^= _k >> 33;
+    _k *= Q_UINT64_C(0xc4ceb9fe1a85ec53);
+    _k ^= _k >> 33;
+    return _k;
+}
+
+StreamHash128::StreamHash128(quint64 _seed)
+    : h1(_seed), h2(_seed), tailLength(0), totalLength(0) {}
+
+void StreamHash128::mixBlock(const uchar *_block) {
+    quint64 k1 = qFromLittleEndian<quint64>(_block);
+    quint64 k2 = qFromLittleEndian<quint64>(_block + 8);
+
+    k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+    k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+    h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+}
+
+void StreamHash128::addData(const char *_data, qint64 _length) {
+    const uchar *data = reinterpret_cast<const uchar *>(_data);
+    totalLength += quint64(_length);
+
+    if(tailLength > 0) {
+        int take = int(qMin<qint64>(16 - tailLength, _length));
+        memcpy(tail + tailLength, data, size_t(take));
+        tailLength += take;
+        data += take;
+        _length -= take;
+        if(tailLength < 16) {
+            return;
+        }
+        mixBlock(tail);
+        tailLength = 0;
+    }
+    for(; _length >= 16; _length -= 16, data += 16) {
+        mixBlock(data);
+    }
+    memcpy(tail, data, size_t(_length));
+    tailLength = int(_length);
+}
+
+void StreamHash128::addData(const QByteArray &_data) {
+    addData(_data.constData(), _data.size());
+}
+
+QByteArray StreamHash128::result() const {
+    quint64 r1 = h1;
+    quint64 r2 = h2;
+    quint64 k1 = 0;
+    quint64 k2 = 0;
+
+    for(int i = tailLength - 1; i >= 8; --i) {
+        k2 ^= quint64(tail[i]) << ((i - 8) * 8);
+    }
+    if(tailLength > 8) {
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; r2 ^= k2;
+    }
+    for(int i = qMin(tailLength, 8) - 1; i >= 0; --i) {
+        k1 ^= quint64(tail[i]) << (i * 8);
+    }
+    if(tailLength > 0) {
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; r1 ^= k1;
+    }
+
+    r1 ^= totalLength;
+    r2 ^= totalLength;
+    r1 += r2;
+    r2 += r1;
+    r1 = fmix64(r1);
+    r2 = fmix64(r2);
+    r1 += r2;
+    r2 += r1;
+
+    QByteArray digest(16, '\0');
+    qToBigEndian(r1, reinterpret_cast<uchar *>(digest.data()));
+    qToBigEndian(r2, reinterpret_cast<uchar *>(digest.data()) + 8);
+    return digest;
+}
+
+static QString directiveName(const QString &_entry) {
+    if(_entry.startsWith('<')) {
+        return _entry.mid(1, _entry.indexOf('>') - 1);
+    }
+    int space = _entry.indexOf(' ');
+    return space < 0 ? _entry : _entry.left(space);
+}
+
+static bool byDirectiveName(const QString &_left, const QString &_right) {
+    return directiveName(_left) < directiveName(_right);
+}
+
+QStringList Canonicalizer::canonicalEntries(const QString _contents) {
+    static const QRegularExpression blanks("\\s+");
+    QStringList entries;
+    QString contents = _contents;
+    QTextStream in(&contents, QIODevice::ReadOnly);
+
+    QString blockTag;
+    QString block;
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if(line.isEmpty()) {
+            continue;
+        }
+
+        if(!blockTag.isEmpty()) {
+            if(line == "</" + blockTag + ">") {
+                entries << "<" + blockTag + ">\n" + block + "</" + blockTag + ">";
+                blockTag.clear();
+                block.clear();
+            }
+            else {
+                block += line + "\n";
+            }
+            continue;
+        }
+
+        if(line.at(0) == '#' || line.at(0) == ';') {
+            continue;
+        }
+        if(line.startsWith('<') && line.endsWith('>') && !line.startsWith("</")) {
+            blockTag = line.mid(1, line.length() - 2);
+            continue;
+        }
+        if(line.startsWith("--")) {
+            line = line.mid(2);
+        }
+        entries << line.replace(blanks, " ");
+    }
+    if(!blockTag.isEmpty()) {
+        // unterminated block, keep what was there
+        entries << "<" + blockTag + ">\n" + block;
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), byDirectiveName);
+    return entries;
+}
+
+QString Canonicalizer::canonicalize(const QString _contents) {
+    return canonicalEntries(_contents).join("\n") + "\n";
+}
+
+QByteArray Canonicalizer::canonicalHash(const QString _contents) {
+    StreamHash128 hash;
+    QStringList entries = canonicalEntries(_contents);
+    for(QStringList::const_iterator entry = entries.constBegin(); entry != entries.constEnd(); ++entry) {
+        hash.addData(entry->toUtf8());
+        hash.addData("\n", 1);
+    }
+    return hash.result();
+}
+
+QByteArray Canonicalizer::fileHash(const QString &_fileName) {
+    QFile file(_fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            return QByteArray();
+    return canonicalHash(QString::fromUtf8(file.readAll()));
+}
+
+QMap<QByteArray, QStringList> Canonicalizer::findDuplicates(const QStringList _fileNames) {
+    QList<QByteArray> hashes = QtConcurrent::blockingMapped(_fileNames, &Canonicalizer::fileHash);
+
+    QMap<QByteArray, QStringList> groups;
+    for(int i = 0; i < _fileNames.size(); ++i) {
+        if(!hashes.at(i).isEmpty()) {
+            groups[hashes.at(i)] << _fileNames.at(i);
+        }
+    }
+    QMap<QByteArray, QStringList>::iterator group = groups.begin();
+    while (group != groups.end()) {
+        if(group->size() < 2) {
+            group = groups.erase(group);
+        }
+        else {
+            ++group;
+        }
+    }
+    return groups;
+}
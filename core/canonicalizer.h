@@ -0,0 +1,62 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef CANONICALIZER_H
+#define CANONICALIZER_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+// MurmurHash3 x64 128 bit, fed incrementally. Not cryptographic, meant to
+// tell profiles apart quickly.
+class StreamHash128
+{
+public:
+    explicit StreamHash128(quint64 _seed = 0);
+
+    void addData(const char *_data, qint64 _length);
+    void addData(const QByteArray &_data);
+    QByteArray result() const;
+
+private:
+    void mixBlock(const uchar *_block);
+
+    quint64 h1;
+    quint64 h2;
+    uchar tail[16];
+    int tailLength;
+    quint64 totalLength;
+};
+
+// Reduces a profile to a deterministic form: comments, blank lines and
+// leading "--" are dropped, whitespace is collapsed, inline blocks are
+// trimmed and directives are sorted by name. Directives with the same name
+// keep their relative order since it is significant (remote, route, ...).
+// Two profiles OpenVPN treats alike therefore get the same canonical hash.
+class Canonicalizer
+{
+public:
+    static QStringList canonicalEntries(const QString _contents);
+    static QString canonicalize(const QString _contents);
+    static QByteArray canonicalHash(const QString _contents);
+    static QByteArray fileHash(const QString &_fileName);
+
+    // groups files by canonical hash, hashing them in parallel; only groups
+    // with more than one file are returned
+    static QMap<QByteArray, QStringList> findDuplicates(const QStringList _fileNames);
+};
+
+#endif // CANONICALIZER_H
@@ -0,0 +1,164 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "ccdgenerator.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QTextStream>
+
+CcdGenerator::CcdGenerator(const IpPool &_pool)
+    : pool(_pool), writtenCount(0), releasedCount(0) {}
+
+void CcdGenerator::loadExisting(const QString &_ccdDir) {
+    QDir ccd(_ccdDir);
+    QStringList names = ccd.entryList(QDir::Files);
+    for(QStringList::const_iterator name = names.constBegin(); name != names.constEnd(); ++name) {
+        QFile file(ccd.filePath(*name));
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+                continue;
+        QTextStream in(&file);
+        while (!in.atEnd()) {
+            QStringList fields = in.readLine().simplified().split(' ');
+            if(fields.size() >= 2 && fields.at(0) == "ifconfig-push") {
+                bool ok;
+                quint32 address = IpPool::fromString(fields.at(1), &ok);
+                if(ok && pool.allocate(address)) {
+                    existing.insert(*name, address);
+                }
+                else if(ok && pool.isAllocated(address)) {
+                    problems << QCoreApplication::translate("CcdGenerator", "%1: %2 lies in the dynamic pool or is taken")
+                                .arg(*name).arg(fields.at(1));
+                }
+                break;
+            }
+        }
+    }
+}
+
+QString CcdGenerator::clientConfig(const ProfileEntry &_entry, quint32 _address) {
+    QString config = "ifconfig-push " + IpPool::toString(_address) + " " +
+            IpPool::toString(IpPool::netmask(pool.prefixLength())) + "\n";
+
+    QStringList iroutes = _entry.vars.value("iroute").split(';', QString::SkipEmptyParts);
+    for(QStringList::const_iterator iroute = iroutes.constBegin(); iroute != iroutes.constEnd(); ++iroute) {
+        quint32 network;
+        int prefixLength;
+        if(!IpPool::parseSubnet(*iroute, &network, &prefixLength)) {
+            problems << QCoreApplication::translate("CcdGenerator", "%1: invalid iroute %2")
+                        .arg(_entry.name).arg(*iroute);
+            continue;
+        }
+        config += "iroute " + IpPool::toString(network & IpPool::netmask(prefixLength)) + " " +
+                IpPool::toString(IpPool::netmask(prefixLength)) + "\n";
+    }
+    return config;
+}
+
+bool CcdGenerator::generate(const QString _userListFile, const QString _ccdDir, bool _prune) {
+    if(!pool.isValid()) {
+        problems << QCoreApplication::translate("CcdGenerator", "The server subnet is not a valid pool.");
+        return false;
+    }
+    QFile userList(_userListFile);
+    if (!userList.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        problems << userList.errorString();
+        return false;
+    }
+    if(!QDir().mkpath(_ccdDir)) {
+        problems << QCoreApplication::translate("CcdGenerator", "Cannot create %1").arg(_ccdDir);
+        return false;
+    }
+    loadExisting(_ccdDir);
+
+    QList<ProfileEntry> entries;
+    QTextStream in(&userList);
+    ProfileEntry entry;
+    while (!in.atEnd()) {
+        if(ProfileSet::parseUserLine(in.readLine(), &entry)) {
+            entries << entry;
+        }
+    }
+
+    // explicit addresses first so the pool never hands them to somebody else
+    QHash<QString, quint32> assigned;
+    for(QList<ProfileEntry>::const_iterator user = entries.constBegin(); user != entries.constEnd(); ++user) {
+        if(!user->vars.contains("ip")) {
+            continue;
+        }
+        bool ok;
+        quint32 address = IpPool::fromString(user->vars.value("ip"), &ok);
+        if(ok && existing.value(user->name) == address) {
+            assigned.insert(user->name, address);
+        }
+        else if(ok && pool.allocate(address)) {
+            if(existing.contains(user->name)) {
+                pool.release(existing.value(user->name));
+            }
+            assigned.insert(user->name, address);
+        }
+        else {
+            problems << QCoreApplication::translate("CcdGenerator", "%1: address %2 is outside the pool or taken")
+                        .arg(user->name).arg(user->vars.value("ip"));
+        }
+    }
+
+    QDir ccd(_ccdDir);
+    QSet<QString> listed;
+    for(QList<ProfileEntry>::const_iterator user = entries.constBegin(); user != entries.constEnd(); ++user) {
+        listed.insert(user->name);
+        quint32 address = assigned.value(user->name, existing.value(user->name));
+        if(address == 0) {
+            address = pool.allocate();
+        }
+        if(address == 0) {
+            problems << QCoreApplication::translate("CcdGenerator", "The pool is exhausted at %1").arg(user->name);
+            return false;
+        }
+
+        QFile file(ccd.filePath(user->name));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            problems << file.errorString();
+            continue;
+        }
+        file.write(clientConfig(*user, address).toUtf8());
+        ++writtenCount;
+    }
+
+    if(_prune) {
+        QHash<QString, quint32>::const_iterator stale = existing.constBegin();
+        while (stale != existing.constEnd()) {
+            if(!listed.contains(stale.key()) && ccd.remove(stale.key())) {
+                pool.release(stale.value());
+                ++releasedCount;
+            }
+            ++stale;
+        }
+    }
+    return true;
+}
+
+int CcdGenerator::written() const {
+    return writtenCount;
+}
+
+int CcdGenerator::released() const {
+    return releasedCount;
+}
+
+QStringList CcdGenerator::errors() const {
+    return problems;
+}
@@ -0,0 +1,52 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef CCDGENERATOR_H
+#define CCDGENERATOR_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include "ippool.h"
+#include "profileset.h"
+
+// Writes one client-config-dir file per user of a user list:
+//   ifconfig-push <address> <netmask>
+//   iroute <network> <netmask>        (one per "iroute=" entry, ';' separated)
+// Addresses already pushed by existing ccd files and explicit "ip=" values
+// are kept, everybody else gets the next free address of the pool. The
+// dynamic ifconfig-pool range has to be reserved in the pool beforehand.
+class CcdGenerator
+{
+public:
+    explicit CcdGenerator(const IpPool &_pool);
+
+    bool generate(const QString _userListFile, const QString _ccdDir, bool _prune);
+
+    int written() const;
+    int released() const;
+    QStringList errors() const;
+
+private:
+    void loadExisting(const QString &_ccdDir);
+    QString clientConfig(const ProfileEntry &_entry, quint32 _address);
+
+    IpPool pool;
+    QHash<QString, quint32> existing;
+    int writtenCount;
+    int releasedCount;
+    QStringList problems;
+};
+
+#endif // CCDGENERATOR_H
@@ -0,0 +1,386 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "defines.h"
+#include "configdocument.h"
+#include "statistics.h"
+
+// shared by every document, built once
+static const QMap<QString, QString> &availablePairs() {
+    static const QMap<QString, QString> pairs{{"dev", "tun"}, {"dev-node", "MyTap"},
+                                              {"proto", "udp"}, {"remote", "my-server-1 1194"},
+                                              {"http-proxy","[proxy server] [proxy port #]"},
+                                              {"resolv-retry", "infinite"}, {"user", "nobody"},
+                                              {"group", "nogroup"}, {"ns-cert-type", "server"},
+                                              {"tls-auth","ta.key 1"}, {"cipher","AES-256-GCM"}, {"verb","3"},
+                                              {"mute","20"}, {"tun-mtu","1500"},
+                                              {"mssfix","1450"}, {"fragment","1450"},
+                                              {"data-ciphers","AES-256-GCM:AES-128-GCM:CHACHA20-POLY1305"},
+                                              {"compress","stub-v2"}, {"sndbuf","0"}, {"rcvbuf","0"},
+                                              {"txqueuelen","100"},
+                                              {"route-delay","0"},
+                                              // server side
+                                              {"port", "1194"}, {"server", "10.8.0.0 255.255.0.0"},
+                                              {"topology", "subnet"}, {"client-config-dir", "ccd"},
+                                              {"keepalive", "10 120"}, {"status", "openvpn-status.log"},
+                                              {"ifconfig-pool-persist", "ipp.txt"}, {"dh", "dh.pem"},
+                                              {"ifconfig-pool", "10.8.0.2 10.8.127.254 255.255.0.0"}};
+    return pairs;
+}
+
+static const QStringList &availableNoValue() {
+    static const QStringList noValue{"client", "remote-random",
+            "nobind", "persist-key", "persist-tun",
+            "mute-replay-warnings", "comp-lzo", "redirect-gateway",
+            "auth-user-pass", "auth-nocache", "float", "fast-io"};
+    return noValue;
+}
+
+// "<key> " for every entry of availablePairs(), in the same order
+static const QStringList &availablePatterns() {
+    static const QStringList patterns = [] {
+        QStringList keys = availablePairs().keys();
+        for(QStringList::iterator key = keys.begin(); key != keys.end(); ++key) {
+            key->append(' ');
+        }
+        return keys;
+    }();
+    return patterns;
+}
+
+static const QString caTag("ca");
+static const QString certTag("cert");
+static const QString keyTag("key");
+
+ConfigDocument::ConfigDocument() {}
+
+QString ConfigDocument::defaultContents() {
+    return CONFIGHEADER
+           "client\ndev tun\nproto udp\nremote example.org 1194\n"
+           "resolv-retry infinite\nuser nobody\ngroup nogroup\n"
+           "ns-cert-type server\ncomp-lzo\nnobind\npersist-key\n"
+           "persist-tun\nverb 3\n";
+           // do not forget new line at the end
+}
+
+QString ConfigDocument::defaultServerContents() {
+    return CONFIGHEADER
+           "port 1194\nproto udp\ndev tun\ntopology subnet\n"
+           "server 10.8.0.0 255.255.0.0\nclient-config-dir ccd\n"
+           "keepalive 10 120\nuser nobody\ngroup nogroup\npersist-key\n"
+           "persist-tun\nstatus openvpn-status.log\ndh dh.pem\nverb 3\n";
+}
+
+void ConfigDocument::parse(const QString _contents) {
+
+    static Statistics::Metric *const parseTiming = Statistics::instance()->metric("parse", Statistics::Timing);
+    ScopedTiming timing(parseTiming);
+    qint64 lines = 0;
+    // lines are read as references into _contents and directives go into
+    // the arena, the only buffer that may need to grow is fileContents
+    configFile.reset();
+    inlineBlocks.reset();
+    const QChar *before = fileContents.constData();
+    if(fileContents.isSharedWith(_contents)) {
+        fileContents = QString();   // reparse of our own text, it is still read below
+    }
+    fileContents.resize(0);
+    fileContents.reserve(_contents.size());
+    if(fileContents.constData() != before) {
+        DocumentArena::countAllocation();
+    }
+
+    int pos = 0;
+    while (pos < _contents.size()) {
+
+        QStringRef line = nextLine(_contents, &pos);
+        ++lines;
+        if(line.size() > 0) {
+            if(line.at(0) != '#' && line.at(0) != ';') {
+
+                if(line.contains(QLatin1String("<ca>")) || line.contains(QLatin1String("<cert>")) ||
+                        line.contains(QLatin1String("<key>"))) {
+                    setCaKeyFlag(caTag, line.contains(QLatin1String("<ca>")));
+                    setCaKeyFlag(certTag, line.contains(QLatin1String("<cert>")));
+                    setCaKeyFlag(keyTag, line.contains(QLatin1String("<key>")));
+
+                }
+
+                scanLine(line, configFile);
+                fileContents.append(line).append(QLatin1Char('\n'));
+            }
+        }
+
+    }
+    timing.setUnits(lines);
+}
+
+QStringRef ConfigDocument::nextLine(const QString &_contents, int *_pos) {
+    int end = _contents.indexOf(QLatin1Char('\n'), *_pos);
+    if(end < 0) {
+        end = _contents.size();
+    }
+    int length = end - *_pos;
+    // all of them, or a reparse of the rendered text would strip another one
+    while (length > 0 && _contents.at(*_pos + length - 1) == QLatin1Char('\r')) {
+        --length;
+    }
+    QStringRef line(&_contents, *_pos, length);
+    *_pos = end + 1;
+    return line;
+}
+
+void ConfigDocument::scanLine(const QStringRef &_line, DocumentArena &_arena) {
+    const QStringList &patterns = availablePatterns();
+    for(QStringList::const_iterator pattern = patterns.constBegin(); pattern != patterns.constEnd(); ++pattern) {
+        if(_line.contains(*pattern)) {
+            _arena.setValue(pattern->leftRef(pattern->size() - 1), processLine(_line));
+        }
+    }
+    for(QStringList::const_iterator config = availableNoValue().constBegin(); config != availableNoValue().constEnd(); ++config) {
+        if(_line.contains(*config)) {
+            _arena.addFlag(QStringRef(&*config));
+        }
+    }
+}
+
+void ConfigDocument::appendLine(const QStringRef &_line) {
+    const QChar *before = fileContents.constData();
+    fileContents.append(_line).append(QLatin1Char('\n'));
+    if(fileContents.constData() != before) {
+        DocumentArena::countAllocation();
+    }
+}
+
+void ConfigDocument::setIncluded(const DocumentArena &_directives, const QMap<QString, QString> _origins) {
+    // scanned once per fragment by the resolver, shared until either changes
+    included = _directives;
+    origins = _origins;
+}
+
+QString ConfigDocument::directiveOrigin(const QString _configKey) const {
+    QStringRef key = _configKey.leftRef(_configKey.indexOf(" "));
+    if(configFile.contains(key) || configFile.containsFlag(QStringRef(&_configKey))) {
+        return QString();
+    }
+    return origins.value(key.toString());
+}
+
+QString ConfigDocument::render() const {
+    return CONFIGHEADER + fileContents;
+}
+
+bool ConfigDocument::removeLine(const QString _line) {
+    static Statistics::Metric *const removeTiming = Statistics::instance()->metric("remove_line", Statistics::Timing);
+    ScopedTiming timing(removeTiming);
+    // directives from included fragments are not part of this file
+    if(!configFile.containsFlag(QStringRef(&_line)) &&
+            !configFile.contains(_line.leftRef(_line.indexOf(" ")))) {
+        return false;
+    }
+
+    configFile.removeFlag(QStringRef(&_line));
+    configFile.remove(_line.leftRef(_line.indexOf(" ")));
+    // the maps also know keys that only appear inside another line, the
+    // text only loses a line that really starts with the directive
+    int start = directiveLineStart(_line.leftRef(_line.indexOf(" ")));
+    if(start >= 0) {
+        int end = fileContents.indexOf('\n', start);
+        fileContents.remove(start, end < 0 ? fileContents.size() - start : end - start + 1);
+    }
+    return true;
+}
+
+int ConfigDocument::directiveLineStart(const QStringRef &_configKey) const {
+    if(_configKey.isEmpty()) {
+        return -1;
+    }
+    int pos = 0;
+    while (pos < fileContents.size()) {
+        int start = pos;
+        while (start < fileContents.size() &&
+               (fileContents.at(start) == QLatin1Char(' ') || fileContents.at(start) == QLatin1Char('\t'))) {
+            ++start;
+        }
+        int after = start + _configKey.size();
+        if(fileContents.midRef(start, _configKey.size()) == _configKey &&
+                (after >= fileContents.size() || fileContents.at(after).isSpace())) {
+            return pos;
+        }
+        int end = fileContents.indexOf('\n', start);
+        if(end < 0) {
+            break;
+        }
+        pos = end + 1;
+    }
+    return -1;
+}
+
+bool ConfigDocument::addLine(const QString _line, bool _replace) {
+    static Statistics::Metric *const addTiming = Statistics::instance()->metric("add_line", Statistics::Timing);
+    ScopedTiming timing(addTiming);
+    if(_replace && this->isConfigActive(_line)) {
+        removeLine(_line);
+    }
+    if(_line.indexOf(" ") > 0) {
+        QStringRef configKey = _line.leftRef(_line.indexOf(" "));
+        if(_replace || !configFile.contains(configKey)) {
+            configFile.setValue(configKey, processLine(QStringRef(&_line)));
+        }
+    }
+    else if(_replace || !configFile.containsFlag(QStringRef(&_line))) {
+        configFile.addFlag(QStringRef(&_line));
+    }
+    appendLine(QStringRef(&_line));
+    return true;
+}
+
+QStringList ConfigDocument::linesStartingWith(const QString _prefix) const {
+    QStringList lines;
+    QStringList all = fileContents.split('\n');
+    for(QStringList::const_iterator line = all.constBegin(); line != all.constEnd(); ++line) {
+        if(line->trimmed().startsWith(_prefix)) {
+            lines << line->trimmed();
+        }
+    }
+    return lines;
+}
+
+int ConfigDocument::removeLinesStartingWith(const QString _prefix) {
+    QStringList all = fileContents.split('\n');
+    int before = all.size();
+    QStringList::iterator line = all.begin();
+    while (line != all.end()) {
+        if(line->trimmed().startsWith(_prefix)) {
+            line = all.erase(line);
+        }
+        else {
+            ++line;
+        }
+    }
+    if(all.size() == before) {
+        return 0;
+    }
+    fileContents = all.join("\n");
+    QString configKey = _prefix.trimmed().section(' ', 0, 0);
+    configFile.remove(QStringRef(&configKey));
+    configFile.removeFlag(QStringRef(&configKey));
+    return before - all.size();
+}
+
+bool ConfigDocument::addTags(const QString _tag, const QString _content) {
+
+    if(_content.contains("N/A")) {
+        return false;
+    }
+    QString toAdd = "\n<" + _tag + ">" + _content + "</" + _tag + ">";
+    removeTags(_tag);
+    addLine(toAdd);
+    setCaKeyFlag(_tag, true);
+    return true;
+}
+
+void ConfigDocument::removeTags(const QString _tag) {
+
+    QString openTag = "<" + _tag + ">";
+    QString closeTag = "</" + _tag + ">";
+    int tagStart = fileContents.indexOf(openTag);
+    int tagFinish = tagStart < 0 ? -1 : fileContents.indexOf(closeTag, tagStart + openTag.size());
+    // a missing or unterminated block leaves the text alone
+    if(tagFinish >= 0) {
+        tagFinish += closeTag.size();
+        if(tagFinish < fileContents.size() && fileContents.at(tagFinish) == QLatin1Char('\n')) {
+            ++tagFinish;
+        }
+        fileContents.remove(tagStart, tagFinish - tagStart);
+    }
+    setCaKeyFlag(_tag, false);
+}
+
+QStringRef ConfigDocument::processLine(const QStringRef &_line) {
+    return _line.mid(_line.indexOf(QLatin1Char(' '))+1);
+
+}
+
+QString ConfigDocument::getConfigValue(const QString _configKey) const {
+    if(configFile.contains(QStringRef(&_configKey))) {
+        return configFile.value(QStringRef(&_configKey));
+    }
+    return included.value(QStringRef(&_configKey));
+}
+
+QString ConfigDocument::getDefaultConfigValue(const QString _configKey) const {
+    return availablePairs().value(_configKey);
+}
+
+bool ConfigDocument::isConfigActive(const QString _configKey) const {
+    QStringRef key = _configKey.leftRef(_configKey.indexOf(" "));
+    bool first = configFile.containsFlag(QStringRef(&_configKey)) || included.containsFlag(QStringRef(&_configKey));
+    bool second = configFile.contains(key) || included.contains(key);
+    return first || second;
+}
+
+bool ConfigDocument::isCaKeyActive(const QString _tag) const {
+    return inlineBlocks.containsFlag(QStringRef(&_tag));
+}
+
+void ConfigDocument::setCaKeyFlag(QString _tag, bool _active) {
+    if(_active) {
+        inlineBlocks.addFlag(QStringRef(&_tag));
+    }
+    else {
+        inlineBlocks.removeFlag(QStringRef(&_tag));
+    }
+}
+
+void ConfigDocument::setFileContents(const QString _newValue) {
+    fileContents = _newValue;
+}
+
+qint64 ConfigDocument::inlineBlockBytes() const {
+    qint64 bytes = 0;
+    int pos = 0;
+    while ((pos = fileContents.indexOf('<', pos)) >= 0) {
+        int nameEnd = fileContents.indexOf('>', pos);
+        if(nameEnd < 0 || fileContents.at(pos + 1) == '/') {
+            break;
+        }
+        // find "</name>" without building the tag, this runs on every edit
+        QStringRef name = fileContents.midRef(pos + 1, nameEnd - pos - 1);
+        int close = nameEnd;
+        while ((close = fileContents.indexOf(QLatin1String("</"), close)) >= 0) {
+            int closeEnd = close + 2 + name.size();
+            if(closeEnd < fileContents.size() && fileContents.at(closeEnd) == QLatin1Char('>') &&
+                    fileContents.midRef(close + 2, name.size()) == name) {
+                break;
+            }
+            ++close;
+        }
+        if(close < 0) {
+            break;
+        }
+        bytes += (close - nameEnd - 1) * qint64(sizeof(QChar));
+        pos = close + 1;
+    }
+    return bytes;
+}
+
+qint64 ConfigDocument::arenaBytes() const {
+    return configFile.bytes() + inlineBlocks.bytes() + included.bytes();
+}
+
+QString ConfigDocument::getFileContents() const {
+    return fileContents;
+}
@@ -0,0 +1,75 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef CONFIGDOCUMENT_H
+#define CONFIGDOCUMENT_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include "documentarena.h"
+
+// The parsed form of one OpenVPN profile. Only depends on QtCore so it can be
+// used outside the GUI (see openvpnui_core.h). A document is not thread-safe,
+// callers serialize access to a single document themselves.
+class ConfigDocument
+{
+public:
+    ConfigDocument();
+
+    void parse(const QString _contents);
+    QString render() const;
+
+    // directives pulled in with "config <file>", see IncludeResolver; they
+    // are reported as active but never written into this file
+    void setIncluded(const DocumentArena &_directives, const QMap<QString, QString> _origins);
+    QString directiveOrigin(const QString _configKey) const;
+    static QString defaultContents();
+    static QString defaultServerContents();
+
+    QString getFileContents() const;
+    qint64 inlineBlockBytes() const;
+    qint64 arenaBytes() const;
+    void setFileContents(const QString _newValue);
+    QString getDefaultConfigValue(const QString _configKey) const;
+    QString getConfigValue(const QString _configKey) const;
+    bool isConfigActive(const QString _configKey) const;
+    bool isCaKeyActive(const QString _tag) const;
+    void setCaKeyFlag(QString _tag, bool _active);
+    bool addLine(QString _line, bool _replace = true);
+    QStringList linesStartingWith(const QString _prefix) const;
+    int removeLinesStartingWith(const QString _prefix);
+    bool removeLine(QString _line);
+    bool addTags(const QString _tag, const QString _content);
+    void removeTags(const QString _tag);
+
+    // records the directives _line sets in _arena, as parse() does
+    static void scanLine(const QStringRef &_line, DocumentArena &_arena);
+
+private:
+    static QStringRef processLine(const QStringRef &_line);
+    static QStringRef nextLine(const QString &_contents, int *_pos);
+    int directiveLineStart(const QStringRef &_configKey) const;
+    void appendLine(const QStringRef &_line);
+
+    DocumentArena configFile;
+    DocumentArena inlineBlocks;     // flags "ca", "cert", "key" while the block is present
+
+    DocumentArena included;
+    QMap<QString, QString> origins;
+
+    QString fileContents;
+};
+
+#endif // CONFIGDOCUMENT_H
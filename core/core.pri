@@ -0,0 +1,45 @@
+# Widget-free parsing and rendering, shared by the GUI and libopenvpnui-core
+INCLUDEPATH += $$PWD $$PWD/..
+DEPENDPATH += $$PWD
+# compiled into the including target unless core.pro builds the library,
+# so the C entry points must not be marked dllimport there
+!contains(DEFINES, OPENVPNUI_CORE_LIBRARY): DEFINES += OPENVPNUI_CORE_STATIC
+
+HEADERS += \
+    $$PWD/configdocument.h \
+    $$PWD/documentarena.h \
+    $$PWD/openvpnui_core.h \
+    $$PWD/pemvalidator.h \
+    $$PWD/statistics.h \
+    $$PWD/canonicalizer.h \
+    $$PWD/includeresolver.h \
+    $$PWD/profileset.h \
+    $$PWD/ippool.h \
+    $$PWD/ccdgenerator.h \
+    $$PWD/routeaggregator.h \
+    $$PWD/mtucalculator.h \
+    $$PWD/performancepresets.h \
+    $$PWD/instancegenerator.h \
+    $$PWD/failoverestimator.h \
+    $$PWD/loganalyzer.h \
+    $$PWD/statusmodel.h \
+    $$PWD/autosavejournal.h
+SOURCES += \
+    $$PWD/configdocument.cpp \
+    $$PWD/documentarena.cpp \
+    $$PWD/openvpnui_core.cpp \
+    $$PWD/pemvalidator.cpp \
+    $$PWD/statistics.cpp \
+    $$PWD/canonicalizer.cpp \
+    $$PWD/includeresolver.cpp \
+    $$PWD/profileset.cpp \
+    $$PWD/ippool.cpp \
+    $$PWD/ccdgenerator.cpp \
+    $$PWD/routeaggregator.cpp \
+    $$PWD/mtucalculator.cpp \
+    $$PWD/performancepresets.cpp \
+    $$PWD/instancegenerator.cpp \
+    $$PWD/failoverestimator.cpp \
+    $$PWD/loganalyzer.cpp \
+    $$PWD/statusmodel.cpp \
+    $$PWD/autosavejournal.cpp
@@ -0,0 +1,15 @@
+# libopenvpnui-core: profile parsing and rendering without a GUI, see
+# openvpnui_core.h for the C interface
+TEMPLATE = lib
+TARGET = openvpnui-core
+QT = core concurrent
+CONFIG += c++11 hide_symbols
+DEFINES += OPENVPNUI_CORE_LIBRARY
+
+include(core.pri)
+
+# install
+headers.files = openvpnui_core.h
+headers.path = $$[QT_INSTALL_PREFIX]/include
+target.path = $$[QT_INSTALL_PREFIX]/lib
+INSTALLS += target headers
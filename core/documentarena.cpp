@@ -0,0 +1,191 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "documentarena.h"
+#include "statistics.h"
+
+void DocumentArena::countAllocation() {
+    static Statistics::Metric *const allocations =
+            Statistics::instance()->metric("document_allocations", Statistics::Counter);
+    allocations->increment();
+}
+
+void DocumentArena::reset() {
+    const QChar *textBefore = text.constData();
+    const Entry *entriesBefore = entries.constData();
+    // both keep their capacity unless a copy of the document shares them
+    text.resize(0);
+    entries.resize(0);
+    garbage = 0;
+    if(text.constData() != textBefore || entries.constData() != entriesBefore) {
+        countAllocation();
+    }
+}
+
+int DocumentArena::indexOf(const QStringRef &_name, bool _flag) const {
+    // a profile has a few dozen directives, a linear scan beats a tree here
+    for(int i = 0; i < entries.size(); ++i) {
+        const Entry &entry = entries.at(i);
+        if((entry.valueLength < 0) == _flag &&
+                QStringRef(&text, entry.nameOffset, entry.nameLength) == _name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int DocumentArena::store(const QStringRef &_text) {
+    const QChar *before = text.constData();
+    int offset = text.size();
+    if(text.capacity() - offset < _text.size()) {
+        text.reserve(qMax(text.capacity() * 2, offset + _text.size()));
+    }
+    text.append(_text);
+    if(text.constData() != before) {
+        countAllocation();
+    }
+    return offset;
+}
+
+void DocumentArena::append(const Entry &_entry) {
+    const Entry *before = entries.constData();
+    entries.append(_entry);
+    if(entries.constData() != before) {
+        countAllocation();
+    }
+}
+
+void DocumentArena::release(int _index) {
+    const Entry &entry = entries.at(_index);
+    garbage += entry.nameLength + qMax(entry.valueLength, 0);
+    entries.remove(_index);
+    compact();
+}
+
+void DocumentArena::compact() {
+    if(garbage <= text.size() - garbage) {
+        return;
+    }
+    // rebuilt at the old capacity, the next edits do not have to grow it again
+    QString live;
+    live.reserve(text.capacity());
+    countAllocation();
+    for(int i = 0; i < entries.size(); ++i) {
+        Entry &entry = entries[i];
+        int nameOffset = live.size();
+        live.append(text.constData() + entry.nameOffset, entry.nameLength);
+        entry.nameOffset = nameOffset;
+        if(entry.valueLength >= 0) {
+            int valueOffset = live.size();
+            live.append(text.constData() + entry.valueOffset, entry.valueLength);
+            entry.valueOffset = valueOffset;
+        }
+    }
+    text.swap(live);
+    garbage = 0;
+}
+
+bool DocumentArena::contains(const QStringRef &_name) const {
+    return indexOf(_name, false) >= 0;
+}
+
+bool DocumentArena::containsFlag(const QStringRef &_name) const {
+    return indexOf(_name, true) >= 0;
+}
+
+QString DocumentArena::value(const QStringRef &_name) const {
+    int i = indexOf(_name, false);
+    if(i < 0) {
+        return QString();
+    }
+    return text.mid(entries.at(i).valueOffset, entries.at(i).valueLength);
+}
+
+void DocumentArena::setValue(const QStringRef &_name, const QStringRef &_value) {
+    int i = indexOf(_name, false);
+    if(i >= 0) {
+        Entry &entry = entries[i];
+        if(_value.size() <= entry.valueLength) {
+            // overwritten in place, only the tail of the old value is lost
+            text.replace(entry.valueOffset, _value.size(), _value.constData(), _value.size());
+            garbage += entry.valueLength - _value.size();
+            entry.valueLength = _value.size();
+        }
+        else {
+            garbage += entry.valueLength;
+            entry.valueLength = _value.size();
+            entry.valueOffset = store(_value);
+        }
+        compact();
+        return;
+    }
+    Entry entry;
+    entry.nameLength = _name.size();
+    entry.nameOffset = store(_name);
+    entry.valueLength = _value.size();
+    entry.valueOffset = store(_value);
+    append(entry);
+}
+
+void DocumentArena::addFlag(const QStringRef &_name) {
+    if(indexOf(_name, true) >= 0) {
+        return;
+    }
+    Entry entry;
+    entry.nameLength = _name.size();
+    entry.nameOffset = store(_name);
+    entry.valueOffset = 0;
+    entry.valueLength = -1;
+    append(entry);
+}
+
+bool DocumentArena::remove(const QStringRef &_name) {
+    int i = indexOf(_name, false);
+    if(i < 0) {
+        return false;
+    }
+    release(i);
+    return true;
+}
+
+bool DocumentArena::removeFlag(const QStringRef &_name) {
+    int i = indexOf(_name, true);
+    if(i < 0) {
+        return false;
+    }
+    release(i);
+    return true;
+}
+
+void DocumentArena::merge(const DocumentArena &_other) {
+    for(int i = 0; i < _other.entries.size(); ++i) {
+        const Entry &entry = _other.entries.at(i);
+        QStringRef name(&_other.text, entry.nameOffset, entry.nameLength);
+        if(entry.valueLength < 0) {
+            addFlag(name);
+        }
+        else {
+            setValue(name, QStringRef(&_other.text, entry.valueOffset, entry.valueLength));
+        }
+    }
+}
+
+int DocumentArena::size() const {
+    return entries.size();
+}
+
+qint64 DocumentArena::bytes() const {
+    return text.capacity() * qint64(sizeof(QChar)) + entries.capacity() * qint64(sizeof(Entry));
+}
@@ -0,0 +1,71 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef DOCUMENTARENA_H
+#define DOCUMENTARENA_H
+
+#include <QString>
+#include <QStringRef>
+#include <QVector>
+
+// Directive storage of one document. Names and values are spans of a single
+// string and the index is a flat vector, so a reparse reuses the same two
+// buffers instead of allocating a node and a string per directive. A value
+// that fits is overwritten in place, anything else is appended and the dead
+// spans are compacted away once they outweigh the live ones. reset() drops
+// everything in one step but keeps the capacity; every time a buffer has to
+// grow it is counted as "document_allocations".
+class DocumentArena
+{
+public:
+    DocumentArena() : garbage(0) {}
+
+    void reset();
+
+    // directives with a value ("dev tun") and flags ("persist-key")
+    bool contains(const QStringRef &_name) const;
+    bool containsFlag(const QStringRef &_name) const;
+    QString value(const QStringRef &_name) const;
+    void setValue(const QStringRef &_name, const QStringRef &_value);
+    void addFlag(const QStringRef &_name);
+    bool remove(const QStringRef &_name);
+    bool removeFlag(const QStringRef &_name);
+    // sets every value and flag of _other, as if its lines followed ours
+    void merge(const DocumentArena &_other);
+
+    int size() const;
+    qint64 bytes() const;
+
+    static void countAllocation();
+
+private:
+    struct Entry {
+        int nameOffset;
+        int nameLength;
+        int valueOffset;
+        int valueLength;    // -1 for flags
+    };
+
+    int indexOf(const QStringRef &_name, bool _flag) const;
+    int store(const QStringRef &_text);
+    void append(const Entry &_entry);
+    void release(int _index);
+    void compact();
+
+    QString text;
+    QVector<Entry> entries;
+    int garbage;        // characters of text no entry refers to
+};
+
+#endif // DOCUMENTARENA_H
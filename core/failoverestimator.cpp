@@ -0,0 +1,165 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "failoverestimator.h"
+#include <QObject>
+
+// a TLS handshake to a healthy server, including the route setup
+static const int handshakeSeconds = 2;
+
+ResilienceSettings FailoverEstimator::fromDirectives(const QStringList _lines) {
+    ResilienceSettings settings;
+    settings.remotes = 0;
+    settings.udp = true;
+    settings.pingInterval = 0;
+    settings.pingRestart = 0;
+    settings.connectRetry = 5;
+    settings.connectRetryMaxDelay = 300;
+    settings.connectRetryMax = 0;
+    settings.serverPollTimeout = 120;
+    settings.handWindow = 60;
+    settings.explicitExitNotify = false;
+
+    QString proto = "udp";
+    QString firstRemoteProto;
+    for(QStringList::const_iterator line = _lines.constBegin(); line != _lines.constEnd(); ++line) {
+        QStringList fields = line->simplified().split(' ');
+        const QString key = fields.at(0);
+        int value = fields.size() > 1 ? fields.at(1).toInt() : 0;
+        if(key == "remote") {
+            // remote host [port] [proto]
+            if(settings.remotes == 0 && fields.size() > 3) {
+                firstRemoteProto = fields.at(3);
+            }
+            ++settings.remotes;
+        }
+        else if(key == "proto" && fields.size() > 1) {
+            proto = fields.at(1);
+        }
+        else if(key == "keepalive" && fields.size() > 2) {
+            settings.pingInterval = value;
+            settings.pingRestart = fields.at(2).toInt();
+        }
+        else if(key == "ping") {
+            settings.pingInterval = value;
+        }
+        else if(key == "ping-restart") {
+            settings.pingRestart = value;
+        }
+        else if(key == "connect-retry") {
+            settings.connectRetry = value;
+            if(fields.size() > 2) {
+                settings.connectRetryMaxDelay = fields.at(2).toInt();
+            }
+        }
+        else if(key == "connect-retry-max") {
+            settings.connectRetryMax = value;
+        }
+        else if(key == "server-poll-timeout" || key == "connect-timeout") {
+            settings.serverPollTimeout = value;
+        }
+        else if(key == "hand-window") {
+            settings.handWindow = value;
+        }
+        else if(key == "explicit-exit-notify") {
+            settings.explicitExitNotify = true;
+        }
+    }
+    settings.udp = (firstRemoteProto.isEmpty() ? proto : firstRemoteProto).startsWith("udp");
+    return settings;
+}
+
+int FailoverEstimator::retryDelay(const ResilienceSettings &_settings, int _failedAttempts) {
+    // as socket_restart_pause() in OpenVPN: the pause only starts doubling
+    // once every remote has failed five times in a row
+    int delay = _settings.connectRetry;
+    int backoff = _failedAttempts / qMax(_settings.remotes, 1) - 4;
+    if(backoff > 0) {
+        delay = qMax(delay, 1) << qMin(backoff, 15);
+        delay = qMin(delay, qMax(_settings.connectRetryMaxDelay, _settings.connectRetry));
+    }
+    return delay;
+}
+
+FailoverEstimate FailoverEstimator::estimate(const ResilienceSettings &_settings) {
+    FailoverEstimate estimate;
+    estimate.crashSeconds = -1;
+    estimate.plannedSeconds = -1;
+
+    int remotes = qMax(_settings.remotes, 1);
+
+    // TCP notices a dead peer through the socket, UDP only through silence
+    int detection = _settings.pingRestart;
+    if(!_settings.udp && detection <= 0) {
+        detection = _settings.serverPollTimeout;
+    }
+    if(detection <= 0) {
+        estimate.warnings << QObject::tr("Without keepalive or ping-restart a client on UDP never notices"
+                                         " that its server is gone.");
+    }
+    else {
+        estimate.breakdown << QObject::tr("Detecting the dead server: %1 s").arg(detection);
+    }
+
+    if(remotes < 2) {
+        estimate.warnings << QObject::tr("With a single remote the client can only wait for the same"
+                                         " server to come back.");
+    }
+
+    int reconnect = 0;
+    for(int attempt = 0; attempt < remotes - 1; ++attempt) {
+        reconnect += _settings.serverPollTimeout + retryDelay(_settings, attempt);
+    }
+    if(remotes > 1) {
+        estimate.breakdown << QObject::tr("Trying %1 unreachable remotes: %2 s (server-poll-timeout %3 s"
+                                          " plus connect-retry %4 s each)")
+                              .arg(remotes - 1).arg(reconnect).arg(_settings.serverPollTimeout)
+                              .arg(_settings.connectRetry);
+    }
+    int connect = retryDelay(_settings, remotes - 1) + handshakeSeconds;
+    estimate.breakdown << QObject::tr("Connecting to the healthy remote: %1 s (up to %2 s on a lossy"
+                                      " link, bounded by hand-window)")
+                          .arg(connect).arg(_settings.handWindow);
+
+    if(detection > 0 && remotes > 1) {
+        estimate.crashSeconds = detection + reconnect + connect;
+    }
+    if(remotes > 1) {
+        // announced by the server, the client's own explicit-exit-notify plays no part
+        estimate.plannedSeconds = reconnect + connect;
+        if(_settings.udp) {
+            estimate.breakdown << QObject::tr("A planned shutdown is only announced to UDP clients when"
+                                              " the server config has explicit-exit-notify.");
+        }
+    }
+
+    if(_settings.explicitExitNotify && !_settings.udp) {
+        estimate.warnings << QObject::tr("explicit-exit-notify only works with UDP.");
+    }
+    if(_settings.connectRetryMax > 0) {
+        estimate.warnings << QObject::tr("connect-retry-max %1 makes the client give up after %2"
+                                         " attempts, a longer outage needs a manual restart.")
+                             .arg(_settings.connectRetryMax).arg(_settings.connectRetryMax * remotes);
+    }
+    if(_settings.serverPollTimeout > 30 && remotes > 1) {
+        estimate.warnings << QObject::tr("A server-poll-timeout of 10 to 20 s moves on to the next"
+                                         " remote much sooner.");
+    }
+    if(_settings.pingInterval > 0 && _settings.pingRestart > 0 &&
+            _settings.pingRestart < 2 * _settings.pingInterval) {
+        estimate.warnings << QObject::tr("ping-restart should be at least twice the ping interval.");
+    }
+    return estimate;
+}
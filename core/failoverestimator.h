@@ -0,0 +1,61 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef FAILOVERESTIMATOR_H
+#define FAILOVERESTIMATOR_H
+
+#include <QString>
+#include <QStringList>
+
+// Connection timing directives of a client profile, with OpenVPN's defaults
+// for everything the profile leaves out.
+struct ResilienceSettings
+{
+    int remotes;
+    bool udp;                   // protocol of the first remote, the one that goes away
+    int pingInterval;           // keepalive / ping
+    int pingRestart;            // keepalive / ping-restart, 0 never restarts
+    int connectRetry;
+    int connectRetryMaxDelay;   // second argument of connect-retry
+    int connectRetryMax;        // 0 retries forever
+    int serverPollTimeout;
+    int handWindow;
+    bool explicitExitNotify;    // the client's own, only tells the server when it exits
+};
+
+struct FailoverEstimate
+{
+    int crashSeconds;           // -1 when the client never recovers on its own
+    int plannedSeconds;         // server announces its shutdown, see estimate()
+    QStringList breakdown;
+    QStringList warnings;
+};
+
+// Worst case time from a server going away until the client has a working
+// tunnel to another remote: the dead server is detected, every other remote
+// but the last one is assumed dead as well, and the last one answers.
+// After a planned shutdown the server itself tells its clients to restart,
+// through explicit-exit-notify in the server config (UDP) or by closing the
+// connection (TCP), so nothing has to be detected.
+class FailoverEstimator
+{
+public:
+    static ResilienceSettings fromDirectives(const QStringList _lines);
+    static FailoverEstimate estimate(const ResilienceSettings &_settings);
+
+private:
+    static int retryDelay(const ResilienceSettings &_settings, int _failedAttempts);
+};
+
+#endif // FAILOVERESTIMATOR_H
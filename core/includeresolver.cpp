@@ -0,0 +1,206 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "includeresolver.h"
+#include "configdocument.h"
+#include "statistics.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSet>
+#include <QTextStream>
+#include <QtConcurrent>
+
+QStringList IncludeResolver::includesOf(const QString &_contents, const QString &_baseDir,
+                                        QHash<int, QString> *_lineTargets) {
+    QStringList includes;
+    QString contents = _contents;
+    QTextStream in(&contents, QIODevice::ReadOnly);
+    bool inBlock = false;
+    for(int lineNumber = 0; !in.atEnd(); ++lineNumber) {
+        QString line = in.readLine().trimmed();
+        if(inBlock || (line.startsWith('<') && !line.startsWith("</"))) {
+            // text inside an inline block is never an include
+            inBlock = !line.contains("</");
+            continue;
+        }
+        if(line.startsWith("--")) {
+            line = line.mid(2);
+        }
+        if(!line.startsWith("config ") && !line.startsWith("config\t")) {
+            continue;
+        }
+        QString target = line.mid(7).trimmed();
+        if(target.size() > 1 && (target.startsWith('"') || target.startsWith('\'')) &&
+                target.endsWith(target.at(0))) {
+            target = target.mid(1, target.size() - 2);
+        }
+        if(!target.isEmpty()) {
+            includes << QFileInfo(QDir(_baseDir), target).absoluteFilePath();
+            if(_lineTargets) {
+                _lineTargets->insert(lineNumber, includes.last());
+            }
+        }
+    }
+    return includes;
+}
+
+IncludeResolver::FragmentPtr IncludeResolver::loadFragment(const QString &_fileName) {
+    Fragment *fragment = new Fragment;
+    fragment->fileName = _fileName;
+    fragment->ok = false;
+
+    QFile file(_fileName);
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        fragment->modified = QFileInfo(file).lastModified();
+        QString contents = QString::fromUtf8(file.readAll());
+        QHash<int, QString> lineTargets;
+        fragment->includes = includesOf(contents, QFileInfo(_fileName).absolutePath(), &lineTargets);
+
+        // includes are expanded in place, so the directives are kept per
+        // segment and merged in include order, later lines win as in OpenVPN
+        // fragments load on several threads, each with its own expression
+        const QRegularExpression blanks("\\s+");
+        fragment->segments.resize(1);
+        QTextStream in(&contents, QIODevice::ReadOnly);
+        bool inBlock = false;
+        for(int lineNumber = 0; !in.atEnd(); ++lineNumber) {
+            QString line = in.readLine();
+            if(lineTargets.contains(lineNumber)) {
+                fragment->segments.resize(fragment->segments.size() + 1);
+                continue;
+            }
+            Segment &segment = fragment->segments.last();
+            if(!line.isEmpty() && line.at(0) != '#' && line.at(0) != ';') {
+                ConfigDocument::scanLine(QStringRef(&line), segment.directives);
+            }
+            QString directive = line.trimmed();
+            if(inBlock || (directive.startsWith('<') && !directive.startsWith("</"))) {
+                // inline blocks set no directive of their own
+                inBlock = !directive.contains("</");
+                continue;
+            }
+            if(directive.startsWith("--")) {
+                directive = directive.mid(2);
+            }
+            if(!directive.isEmpty() && directive.at(0) != '#' && directive.at(0) != ';') {
+                segment.names << directive.section(blanks, 0, 0);
+            }
+        }
+        fragment->ok = true;
+    }
+    static Statistics::Metric *const fragmentsLoaded = Statistics::instance()->metric("include_fragments_loaded", Statistics::Counter);
+    fragmentsLoaded->increment();
+    return FragmentPtr(fragment);
+}
+
+void IncludeResolver::prefetch(QStringList _fileNames) {
+    QSet<QString> seen;
+    while (!_fileNames.isEmpty()) {
+        QStringList stale;
+        {
+            QMutexLocker locker(&lock);
+            for(QStringList::const_iterator name = _fileNames.constBegin(); name != _fileNames.constEnd(); ++name) {
+                if(seen.contains(*name)) {
+                    continue;
+                }
+                seen.insert(*name);
+                FragmentPtr cached = cache.value(*name);
+                if(!cached || !cached->ok || QFileInfo(*name).lastModified() != cached->modified) {
+                    stale << *name;
+                }
+            }
+        }
+
+        // one include level is read and parsed in parallel
+        QList<FragmentPtr> loaded = QtConcurrent::blockingMapped(stale, &IncludeResolver::loadFragment);
+
+        QStringList next;
+        QMutexLocker locker(&lock);
+        for(QList<FragmentPtr>::const_iterator fragment = loaded.constBegin(); fragment != loaded.constEnd(); ++fragment) {
+            cache.insert((*fragment)->fileName, *fragment);
+        }
+        for(QStringList::const_iterator name = _fileNames.constBegin(); name != _fileNames.constEnd(); ++name) {
+            FragmentPtr fragment = cache.value(*name);
+            if(fragment) {
+                next << fragment->includes;
+            }
+        }
+        _fileNames = next;
+    }
+}
+
+void IncludeResolver::assemble(const QString &_fileName, QStringList &_stack, ResolvedIncludes &_result) {
+    // a fragment included twice is expanded twice, as OpenVPN reads it twice
+    if(_stack.contains(_fileName)) {
+        _result.errors << QObject::tr("Include cycle: %1").arg((_stack + QStringList(_fileName)).join(" -> "));
+        return;
+    }
+
+    FragmentPtr fragment;
+    {
+        QMutexLocker locker(&lock);
+        fragment = cache.value(_fileName);
+    }
+    if(!fragment || !fragment->ok) {
+        _result.errors << QObject::tr("Cannot read included file %1").arg(_fileName);
+        return;
+    }
+
+    _stack << _fileName;
+    for(int i = 0; i < fragment->segments.size(); ++i) {
+        const Segment &segment = fragment->segments.at(i);
+        _result.directives.merge(segment.directives);
+        for(QStringList::const_iterator name = segment.names.constBegin(); name != segment.names.constEnd(); ++name) {
+            _result.origins.insert(*name, _fileName);
+        }
+        if(i < fragment->includes.size()) {
+            assemble(fragment->includes.at(i), _stack, _result);
+        }
+    }
+    _stack.removeLast();
+}
+
+ResolvedIncludes IncludeResolver::resolve(const QString _fileName, const QString _contents) {
+    ResolvedIncludes result;
+    QString root = _fileName.isEmpty() ? QString() : QFileInfo(_fileName).absoluteFilePath();
+    QStringList includes = includesOf(_contents, root.isEmpty() ? QDir::currentPath()
+                                                                : QFileInfo(root).absolutePath());
+    if(includes.isEmpty()) {
+        return result;
+    }
+
+    prefetch(includes);
+
+    QStringList stack;
+    if(!root.isEmpty()) {
+        stack << root;
+    }
+    for(QStringList::const_iterator include = includes.constBegin(); include != includes.constEnd(); ++include) {
+        assemble(*include, stack, result);
+    }
+    return result;
+}
+
+void IncludeResolver::invalidate(const QString _fileName) {
+    QMutexLocker locker(&lock);
+    cache.remove(QFileInfo(_fileName).absoluteFilePath());
+}
+
+int IncludeResolver::cachedFragments() const {
+    QMutexLocker locker(&lock);
+    return cache.size();
+}
@@ -0,0 +1,76 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef INCLUDERESOLVER_H
+#define INCLUDERESOLVER_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "documentarena.h"
+
+// The result of following the "config <file>" directives of a profile.
+struct ResolvedIncludes
+{
+    DocumentArena directives;         // of all included fragments, later ones win
+    QMap<QString, QString> origins;   // directive -> fragment that set it last
+    QStringList errors;               // missing files and include cycles
+};
+
+// Loads the fragments pulled in with OpenVPN's "config <file>" directive.
+// Each fragment is read and scanned for directives once per session and
+// shared by every profile that includes it; it is only read again once its
+// modification time changes. Resolving merges the scanned directives and
+// never looks at the text again. Fragments of one include level are loaded
+// in parallel.
+class IncludeResolver
+{
+public:
+    ResolvedIncludes resolve(const QString _fileName, const QString _contents);
+    void invalidate(const QString _fileName);
+    int cachedFragments() const;
+
+    // _lineTargets, when given, maps the line number of every include to its target
+    static QStringList includesOf(const QString &_contents, const QString &_baseDir,
+                                  QHash<int, QString> *_lineTargets = 0);
+
+private:
+    // the lines before, between and after the includes of a fragment
+    struct Segment {
+        DocumentArena directives;
+        QStringList names;          // set in this segment, for the origins
+    };
+    struct Fragment {
+        QString fileName;
+        QStringList includes;
+        QVector<Segment> segments;  // one more than includes
+        QDateTime modified;
+        bool ok;
+    };
+    typedef QSharedPointer<const Fragment> FragmentPtr;
+
+    static FragmentPtr loadFragment(const QString &_fileName);
+    void prefetch(QStringList _fileNames);
+    void assemble(const QString &_fileName, QStringList &_stack, ResolvedIncludes &_result);
+
+    mutable QMutex lock;
+    QHash<QString, FragmentPtr> cache;
+};
+
+#endif // INCLUDERESOLVER_H
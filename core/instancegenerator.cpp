@@ -0,0 +1,249 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "instancegenerator.h"
+#include "configdocument.h"
+#include "ippool.h"
+#include <QFileInfo>
+#include <QObject>
+
+// directives both ends of the data channel have to agree on
+static const QStringList &sharedDirectives() {
+    static const QStringList shared{"cipher", "data-ciphers", "auth", "compress", "comp-lzo",
+                                    "tun-mtu", "fragment", "mssfix"};
+    return shared;
+}
+
+// "fd00:1::/64" as eight 16 bit groups
+static bool parseIpv6Subnet(const QString _subnet, quint16 *_groups, int *_prefixLength) {
+    bool ok;
+    *_prefixLength = _subnet.section('/', 1, 1).toInt(&ok);
+    QStringList halves = _subnet.section('/', 0, 0).split("::");
+    if(!ok || *_prefixLength < 0 || *_prefixLength > 128 || halves.size() > 2) {
+        return false;
+    }
+    QStringList head = halves.at(0).split(':', QString::SkipEmptyParts);
+    QStringList tail = halves.size() == 2 ? halves.at(1).split(':', QString::SkipEmptyParts) : QStringList();
+    if(halves.size() == 1 ? head.size() != 8 : head.size() + tail.size() > 7) {
+        return false;
+    }
+    QStringList groups = head;
+    while (groups.size() + tail.size() < 8) {
+        groups << "0";
+    }
+    groups << tail;
+    for(int i = 0; i < 8; ++i) {
+        _groups[i] = groups.at(i).toUShort(&ok, 16);
+        if(!ok || groups.at(i).size() > 4) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the _instance-th of 2^_extraBits equal slices of an IPv6 subnet
+static QString ipv6Slice(const QString _subnet, int _instance, int _extraBits) {
+    quint16 groups[8];
+    int prefixLength;
+    if(!parseIpv6Subnet(_subnet, groups, &prefixLength)) {
+        return _subnet;
+    }
+    for(int bit = prefixLength; bit < 128; ++bit) {
+        int shift = 15 - bit % 16;
+        groups[bit / 16] &= ~(1 << shift);
+        if(bit < prefixLength + _extraBits && (_instance >> (prefixLength + _extraBits - 1 - bit)) & 1) {
+            groups[bit / 16] |= 1 << shift;
+        }
+    }
+    QStringList address;
+    for(int i = 0; i < 8; ++i) {
+        address << QString::number(groups[i], 16);
+    }
+    return address.join(":") + "/" + QString::number(prefixLength + _extraBits);
+}
+
+InstanceGenerator::InstanceGenerator(const QString _serverTemplate)
+    : basePort(1194), devType("tun"), proto("udp")
+{
+    QStringList all = _serverTemplate.split('\n');
+    for(QStringList::const_iterator line = all.constBegin(); line != all.constEnd(); ++line) {
+        QString directive = line->simplified();
+        if(directive.isEmpty() || directive.startsWith('#') || directive.startsWith(';')) {
+            continue;
+        }
+        lines << directive;
+        QString key = directive.section(' ', 0, 0);
+        QString value = directive.section(' ', 1, 1);
+        if(key == "port") {
+            basePort = value.toInt();
+        }
+        else if(key == "dev") {
+            devType = value.startsWith("tap") ? "tap" : "tun";
+        }
+        else if(key == "proto") {
+            proto = value;
+        }
+    }
+}
+
+QString InstanceGenerator::withSuffix(const QString _fileName, int _instance) {
+    QFileInfo info(_fileName);
+    QString suffix = info.completeSuffix();
+    QString base = _fileName.left(_fileName.size() - (suffix.isEmpty() ? 0 : suffix.size() + 1));
+    return base + "-" + QString::number(_instance) + (suffix.isEmpty() ? QString() : "." + suffix);
+}
+
+QString InstanceGenerator::serverConfig(int _instance, quint32 _network, int _prefixLength,
+                                        int _extraBits) const {
+    QString contents;
+    bool hasPort = false;
+    for(QStringList::const_iterator line = lines.constBegin(); line != lines.constEnd(); ++line) {
+        QStringList fields = line->split(' ');
+        const QString key = fields.at(0);
+        if(key == "port") {
+            fields[1] = QString::number(basePort + _instance);
+            hasPort = true;
+        }
+        else if(key == "dev" && fields.size() > 1) {
+            fields[1] = devType + QString::number(_instance);
+        }
+        else if(key == "server" && fields.size() > 1) {
+            // keeps a trailing "nopool"
+            fields = QStringList() << key << IpPool::toString(_network)
+                                   << IpPool::toString(IpPool::netmask(_prefixLength)) << fields.mid(3);
+        }
+        else if(key == "ifconfig-pool" && fields.size() > 2) {
+            // the lower half of the slice stays dynamic, as the ccd generator does it
+            fields = QStringList() << key << IpPool::toString(_network + 2)
+                                   << IpPool::toString(_network + (quint32(1) << (31 - _prefixLength)) - 1)
+                                   << IpPool::toString(IpPool::netmask(_prefixLength));
+        }
+        else if(key == "server-ipv6" && fields.size() > 1) {
+            fields[1] = ipv6Slice(fields.at(1), _instance, _extraBits);
+        }
+        else if((key == "status" || key == "log" || key == "log-append" ||
+                 key == "ifconfig-pool-persist" || key == "replay-persist" ||
+                 key == "client-config-dir") && fields.size() > 1) {
+            fields[1] = withSuffix(fields.at(1), _instance);
+        }
+        else if(key == "management" && fields.size() > 2) {
+            if(fields.at(2) == "unix") {
+                fields[1] = withSuffix(fields.at(1), _instance);
+            }
+            else {
+                fields[2] = QString::number(fields.at(2).toInt() + _instance);
+            }
+        }
+        contents += fields.join(" ") + "\n";
+    }
+    if(!hasPort) {
+        contents += "port " + QString::number(basePort + _instance) + "\n";
+    }
+
+    ConfigDocument document;
+    document.parse(contents);
+    return document.render();
+}
+
+QString InstanceGenerator::clientConfig(int _instances, const QString _remoteHost) const {
+    ConfigDocument document;
+    document.parse(ConfigDocument::defaultContents());
+    document.removeLinesStartingWith("remote ");
+    document.removeLinesStartingWith("comp-lzo");
+    document.addLine("dev " + devType);
+    document.addLine("proto " + proto.section('-', 0, 0));  // tcp-server -> tcp
+
+    for(QStringList::const_iterator line = lines.constBegin(); line != lines.constEnd(); ++line) {
+        if(sharedDirectives().contains(line->section(' ', 0, 0))) {
+            document.addLine(*line);
+        }
+    }
+    for(int i = 0; i < _instances; ++i) {
+        document.addLine("remote " + _remoteHost + " " + QString::number(basePort + i), false);
+    }
+    document.addLine("remote-random");
+    return document.render();
+}
+
+bool InstanceGenerator::generate(int _instances, const QString _remoteHost) {
+    generated.clear();
+    error.clear();
+
+    quint32 network = 0;
+    int prefixLength = 0;
+    QString server;
+    QString serverIpv6;
+    for(QStringList::const_iterator line = lines.constBegin(); line != lines.constEnd(); ++line) {
+        if(line->startsWith("server ")) {
+            server = line->section(' ', 1, 2);
+        }
+        else if(line->startsWith("server-ipv6 ")) {
+            serverIpv6 = line->section(' ', 1, 1);
+        }
+    }
+    if(!IpPool::parseSubnet(server, &network, &prefixLength)) {
+        error = QObject::tr("The template has no \"server\" subnet to split.");
+        return false;
+    }
+    network &= IpPool::netmask(prefixLength);
+
+    // every instance gets an equal, aligned slice of the subnet
+    int extraBits = 0;
+    while((1 << extraBits) < _instances) {
+        ++extraBits;
+    }
+    int slicePrefix = prefixLength + extraBits;
+    if(_instances < 1 || slicePrefix > 29) {
+        error = QObject::tr("The subnet %1/%2 is too small for %3 instances.")
+                .arg(IpPool::toString(network)).arg(prefixLength).arg(_instances);
+        return false;
+    }
+    if(!serverIpv6.isEmpty()) {
+        quint16 groups[8];
+        int prefixLength6;
+        // OpenVPN only accepts IPv6 pools up to /112
+        if(!parseIpv6Subnet(serverIpv6, groups, &prefixLength6) || prefixLength6 + extraBits > 112) {
+            error = QObject::tr("The IPv6 subnet %1 is too small for %2 instances.")
+                    .arg(serverIpv6).arg(_instances);
+            return false;
+        }
+    }
+    if(basePort + _instances - 1 > 65535) {
+        error = QObject::tr("Port %1 leaves no room for %2 instances.").arg(basePort).arg(_instances);
+        return false;
+    }
+
+    quint32 sliceSize = quint32(1) << (32 - slicePrefix);
+    for(int i = 0; i < _instances; ++i) {
+        GeneratedConfig config;
+        config.fileName = "server-" + QString::number(i) + ".conf";
+        config.contents = serverConfig(i, network + quint32(i) * sliceSize, slicePrefix, extraBits);
+        generated << config;
+    }
+
+    GeneratedConfig client;
+    client.fileName = "client.ovpn";
+    client.contents = clientConfig(_instances, _remoteHost);
+    generated << client;
+    return true;
+}
+
+QList<GeneratedConfig> InstanceGenerator::configs() const {
+    return generated;
+}
+
+QString InstanceGenerator::errorString() const {
+    return error;
+}
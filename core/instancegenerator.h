@@ -0,0 +1,59 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef INSTANCEGENERATOR_H
+#define INSTANCEGENERATOR_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+struct GeneratedConfig
+{
+    QString fileName;
+    QString contents;
+};
+
+// Splits one server configuration into a number of instances, one per core,
+// since an OpenVPN 2.x process only ever uses a single core. Instance i gets
+// port + i, its own tun/tap device, the i-th equal slice of the "server" and
+// "server-ipv6" subnets, its own status, log and pool files, management
+// socket and client-config-dir. Static addresses in a ccd have to lie in the
+// slice of their instance, so the ccd files are generated per instance. The
+// client profile lists every instance as a remote and picks one at random.
+class InstanceGenerator
+{
+public:
+    explicit InstanceGenerator(const QString _serverTemplate);
+
+    bool generate(int _instances, const QString _remoteHost);
+
+    QList<GeneratedConfig> configs() const;   // server-<i>.conf ..., client.ovpn
+    QString errorString() const;
+
+    static QString withSuffix(const QString _fileName, int _instance);
+
+private:
+    QString serverConfig(int _instance, quint32 _network, int _prefixLength, int _extraBits) const;
+    QString clientConfig(int _instances, const QString _remoteHost) const;
+
+    QStringList lines;
+    int basePort;
+    QString devType;
+    QString proto;
+    QList<GeneratedConfig> generated;
+    QString error;
+};
+
+#endif // INSTANCEGENERATOR_H
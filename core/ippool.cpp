@@ -0,0 +1,169 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "ippool.h"
+#include <QRegularExpression>
+#include <QStringList>
+#include <QtAlgorithms>
+
+IpPool::IpPool() : base(0), prefix(32), size(0), freeCount(0), hint(0) {}
+
+IpPool::IpPool(quint32 _network, int _prefixLength)
+    : base(_network & netmask(_prefixLength)), prefix(_prefixLength), size(0), freeCount(0), hint(0)
+{
+    // /31 and /32 leave no room for clients, larger than /8 is not sensible
+    if(_prefixLength < 8 || _prefixLength > 30) {
+        return;
+    }
+    size = quint32(1) << (32 - _prefixLength);
+    bits.fill(0, int((size + 63) / 64));
+    freeCount = int(size);
+
+    // the tail of the last word lies outside the pool
+    for(quint32 i = size; i < quint32(bits.size()) * 64; ++i) {
+        bits[int(i / 64)] |= quint64(1) << (i % 64);
+    }
+    allocate(base);                 // network
+    allocate(base + 1);             // the server itself
+    allocate(base + size - 1);      // broadcast
+}
+
+quint32 IpPool::netmask(int _prefixLength) {
+    return _prefixLength <= 0 ? 0 : ~quint32(0) << (32 - _prefixLength);
+}
+
+quint32 IpPool::fromString(const QString _address, bool *_ok) {
+    QStringList octets = _address.trimmed().split('.');
+    bool ok = octets.size() == 4;
+    quint32 address = 0;
+    for(int i = 0; ok && i < 4; ++i) {
+        uint octet = octets.at(i).toUInt(&ok);
+        ok = ok && octet < 256;
+        address = (address << 8) | octet;
+    }
+    if(_ok) {
+        *_ok = ok;
+    }
+    return ok ? address : 0;
+}
+
+QString IpPool::toString(quint32 _address) {
+    return QString("%1.%2.%3.%4").arg(_address >> 24).arg((_address >> 16) & 0xff)
+            .arg((_address >> 8) & 0xff).arg(_address & 0xff);
+}
+
+bool IpPool::parseSubnet(const QString _subnet, quint32 *_network, int *_prefixLength) {
+    // accepts "10.8.0.0/16" as well as the "10.8.0.0 255.255.0.0" of the
+    // server directive
+    QStringList parts = _subnet.trimmed().split(QRegularExpression("[\\s/]+"));
+    if(parts.size() != 2) {
+        return false;
+    }
+    bool ok;
+    *_network = fromString(parts.at(0), &ok);
+    if(!ok) {
+        return false;
+    }
+    if(parts.at(1).contains('.')) {
+        quint32 mask = fromString(parts.at(1), &ok);
+        // a netmask must be contiguous ones
+        if(!ok || (~mask & (~mask + 1)) != 0) {
+            return false;
+        }
+        *_prefixLength = 32 - qCountTrailingZeroBits(quint64(mask) | (quint64(1) << 32));
+    }
+    else {
+        *_prefixLength = parts.at(1).toInt(&ok);
+        if(!ok || *_prefixLength < 0 || *_prefixLength > 32) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IpPool::isValid() const {
+    return size > 0;
+}
+
+quint32 IpPool::network() const {
+    return base;
+}
+
+int IpPool::prefixLength() const {
+    return prefix;
+}
+
+int IpPool::available() const {
+    return freeCount;
+}
+
+bool IpPool::contains(quint32 _address) const {
+    return size > 0 && _address - base < size;
+}
+
+bool IpPool::isAllocated(quint32 _address) const {
+    if(!contains(_address)) {
+        return false;
+    }
+    quint32 offset = _address - base;
+    return bits.at(int(offset / 64)) & (quint64(1) << (offset % 64));
+}
+
+quint32 IpPool::allocate() {
+    for(int word = hint; word < bits.size(); ++word) {
+        if(bits.at(word) != ~quint64(0)) {
+            int bit = int(qCountTrailingZeroBits(~bits.at(word)));
+            bits[word] |= quint64(1) << bit;
+            --freeCount;
+            hint = word;
+            return base + quint32(word) * 64 + quint32(bit);
+        }
+    }
+    hint = bits.size();
+    return 0;
+}
+
+bool IpPool::allocate(quint32 _address) {
+    if(!contains(_address) || isAllocated(_address)) {
+        return false;
+    }
+    quint32 offset = _address - base;
+    bits[int(offset / 64)] |= quint64(1) << (offset % 64);
+    --freeCount;
+    return true;
+}
+
+bool IpPool::release(quint32 _address) {
+    quint32 offset = _address - base;
+    // the reserved addresses never go back into the pool
+    if(!isAllocated(_address) || offset <= 1 || offset == size - 1) {
+        return false;
+    }
+    int word = int(offset / 64);
+    bits[word] &= ~(quint64(1) << (offset % 64));
+    ++freeCount;
+    hint = qMin(hint, word);
+    return true;
+}
+
+bool IpPool::reserve(quint32 _first, quint32 _last) {
+    if(_first > _last || !contains(_first) || !contains(_last)) {
+        return false;
+    }
+    for(quint32 address = _first; address <= _last; ++address) {
+        allocate(address);
+    }
+    return true;
+}
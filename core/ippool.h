@@ -0,0 +1,58 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef IPPOOL_H
+#define IPPOOL_H
+
+#include <QString>
+#include <QVector>
+
+// IPv4 address pool for "topology subnet" servers, one bit per address.
+// The network, broadcast and server (first host) addresses are reserved.
+// allocate() finds the next free address one 64 bit word at a time, so
+// handing out or releasing tens of thousands of addresses stays instant.
+class IpPool
+{
+public:
+    IpPool();
+    IpPool(quint32 _network, int _prefixLength);
+
+    static bool parseSubnet(const QString _subnet, quint32 *_network, int *_prefixLength);
+    static QString toString(quint32 _address);
+    static quint32 fromString(const QString _address, bool *_ok = 0);
+    static quint32 netmask(int _prefixLength);
+
+    bool isValid() const;
+    quint32 network() const;
+    int prefixLength() const;
+    int available() const;
+
+    quint32 allocate();                 // 0 when the pool is exhausted
+    bool allocate(quint32 _address);    // claims a specific address
+    bool release(quint32 _address);
+    bool reserve(quint32 _first, quint32 _last);  // e.g. the dynamic ifconfig-pool range
+    bool isAllocated(quint32 _address) const;
+
+private:
+    bool contains(quint32 _address) const;
+
+    quint32 base;
+    int prefix;
+    quint32 size;
+    int freeCount;
+    int hint;       // first word that may have a free bit
+    QVector<quint64> bits;
+};
+
+#endif // IPPOOL_H
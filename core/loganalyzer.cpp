@@ -0,0 +1,411 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "loganalyzer.h"
+#include "statistics.h"
+#include <QDateTime>
+#include <QFile>
+#include <QObject>
+#include <QThread>
+#include <QtConcurrent>
+#include <cstring>
+
+// handshakes that never finish (port scans, wrong keys) must not pile up
+static const int maxOpenHandshakes = 4096;
+
+LogStats::LogStats()
+    : lines(0), handshakes(0), handshakeSecondsTotal(0), handshakeSecondsMax(0),
+      reconnects(0), tlsErrors(0), mtuWarnings(0), replayWarnings(0),
+      tunReadBytes(-1), tunWriteBytes(-1), linkReadBytes(-1), linkWriteBytes(-1)
+{
+    memset(handshakeHistogram, 0, sizeof(handshakeHistogram));
+}
+
+LogAnalyzer::LogAnalyzer(qint64 _chunkSize)
+    : chunkSize(_chunkSize) {}
+
+static int find(const char *_line, int _length, const char *_needle) {
+    int needleLength = int(strlen(_needle));
+    const char *end = _line + _length - needleLength;
+    for(const char *p = _line; p <= end; ++p) {
+        p = static_cast<const char *>(memchr(p, _needle[0], end - p + 1));
+        if(!p) {
+            return -1;
+        }
+        if(memcmp(p, _needle, needleLength) == 0) {
+            return int(p - _line);
+        }
+    }
+    return -1;
+}
+
+static int twoDigits(const char *_p) {
+    return (_p[0] - '0') * 10 + (_p[1] - '0');
+}
+
+qint64 LogAnalyzer::parseTimestamp(const char *_line, int _length) {
+    // "2026-10-19 10:00:00 ..." (2.5+ and most service managers)
+    if(_length >= 19 && _line[4] == '-' && _line[7] == '-' && _line[13] == ':') {
+        QDate date(twoDigits(_line) * 100 + twoDigits(_line + 2), twoDigits(_line + 5), twoDigits(_line + 8));
+        QTime time(twoDigits(_line + 11), twoDigits(_line + 14), twoDigits(_line + 17));
+        return date.isValid() && time.isValid() ? QDateTime(date, time, Qt::UTC).toMSecsSinceEpoch() / 1000 : -1;
+    }
+    // "Mon Oct 19 10:00:00 2026 ..." (ctime format of older releases)
+    if(_length >= 24 && _line[3] == ' ' && _line[7] == ' ' && _line[13] == ':') {
+        static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+        const char *month = strstr(months, QByteArray(_line + 4, 3).constData());
+        if(month && (month - months) % 3 != 0) {
+            month = 0;
+        }
+        int day = _line[8] == ' ' ? _line[9] - '0' : twoDigits(_line + 8);
+        QDate date(twoDigits(_line + 20) * 100 + twoDigits(_line + 22),
+                   month ? int(month - months) / 3 + 1 : 0, day);
+        QTime time(twoDigits(_line + 11), twoDigits(_line + 14), twoDigits(_line + 17));
+        return date.isValid() && time.isValid() ? QDateTime(date, time, Qt::UTC).toMSecsSinceEpoch() / 1000 : -1;
+    }
+    return -1;
+}
+
+static QByteArray peerAfter(const char *_line, int _length, int _from) {
+    // "... from [AF_INET]1.2.3.4:1194" or "... with [AF_INET6]..."
+    int start = _from;
+    while(start < _length && _line[start] != ']' && _line[start] != ' ') {
+        ++start;
+    }
+    if(start < _length && _line[start] == ']') {
+        ++start;
+    }
+    int end = start;
+    while(end < _length && _line[end] != ' ' && _line[end] != ',' && _line[end] != '\r') {
+        ++end;
+    }
+    return QByteArray(_line + start, end - start);
+}
+
+static qint64 counterValue(const char *_line, int _length, int _at) {
+    int comma = _at;
+    while(comma < _length && _line[comma] != ',') {
+        ++comma;
+    }
+    return QByteArray(_line + comma + 1, _length - comma - 1).trimmed().toLongLong();
+}
+
+void LogAnalyzer::addHandshake(LogStats &_stats, qint64 _seconds) {
+    static const qint64 limits[LogStats::HandshakeBuckets - 1] = {1, 2, 5, 10, 30, 60};
+    if(_seconds < 0) {
+        return;
+    }
+    int bucket = 0;
+    while(bucket < LogStats::HandshakeBuckets - 1 && _seconds >= limits[bucket]) {
+        ++bucket;
+    }
+    ++_stats.handshakeHistogram[bucket];
+    ++_stats.handshakes;
+    _stats.handshakeSecondsTotal += _seconds;
+    _stats.handshakeSecondsMax = qMax(_stats.handshakeSecondsMax, _seconds);
+}
+
+void LogAnalyzer::scanLine(const char *_line, int _length, LogStats &_stats) {
+    ++_stats.lines;
+    int at;
+
+    if((at = find(_line, _length, "TLS: Initial packet from ")) >= 0) {
+        if(_stats.openHandshakes.size() < maxOpenHandshakes) {
+            _stats.openHandshakes.insert(peerAfter(_line, _length, at + 25), parseTimestamp(_line, _length));
+        }
+    }
+    else if((at = find(_line, _length, "Peer Connection Initiated with ")) >= 0) {
+        QByteArray peer = peerAfter(_line, _length, at + 31);
+        qint64 finished = parseTimestamp(_line, _length);
+        QHash<QByteArray, qint64>::iterator started = _stats.openHandshakes.find(peer);
+        if(started != _stats.openHandshakes.end()) {
+            if(started.value() >= 0 && finished >= 0) {
+                addHandshake(_stats, finished - started.value());
+            }
+            _stats.openHandshakes.erase(started);
+        }
+        else if(_stats.finishedWithoutStart.size() < maxOpenHandshakes) {
+            _stats.finishedWithoutStart.insert(peer, finished);
+        }
+    }
+    else if((at = find(_line, _length, "SIGUSR1[")) >= 0 || (at = find(_line, _length, "SIGHUP[")) >= 0) {
+        ++_stats.reconnects;
+        int open = find(_line + at, _length - at, ",");
+        int close = find(_line + at, _length - at, "]");
+        QString cause = open >= 0 && close > open
+                ? QString::fromLatin1(_line + at + open + 1, close - open - 1)
+                : QString::fromLatin1(_line + at, qMin(_length - at, 7)).section('[', 0, 0);
+        ++_stats.reconnectCauses[cause];
+    }
+    else if(find(_line, _length, "TLS Error") >= 0 || find(_line, _length, "TLS handshake failed") >= 0) {
+        ++_stats.tlsErrors;
+    }
+    // the "MTU parms" line printed on every connect is not a warning
+    else if(find(_line, _length, "FRAG_") >= 0 || find(_line, _length, "EMSGSIZE") >= 0 ||
+            find(_line, _length, "Message too long") >= 0 ||
+            find(_line, _length, "packet length") >= 0 ||
+            find(_line, _length, "mtu' is used inconsistently") >= 0) {
+        ++_stats.mtuWarnings;
+    }
+    else if(find(_line, _length, "Replay-window backtrack") >= 0 ||
+            find(_line, _length, "may be a replay") >= 0 || find(_line, _length, "PID_ERR") >= 0) {
+        ++_stats.replayWarnings;
+    }
+    // counters printed on exit and on SIGUSR2
+    else if((at = find(_line, _length, "TUN/TAP read bytes")) >= 0) {
+        _stats.tunReadBytes = counterValue(_line, _length, at);
+    }
+    else if((at = find(_line, _length, "TUN/TAP write bytes")) >= 0) {
+        _stats.tunWriteBytes = counterValue(_line, _length, at);
+    }
+    else if((at = find(_line, _length, "TCP/UDP read bytes")) >= 0) {
+        _stats.linkReadBytes = counterValue(_line, _length, at);
+    }
+    else if((at = find(_line, _length, "TCP/UDP write bytes")) >= 0) {
+        _stats.linkWriteBytes = counterValue(_line, _length, at);
+    }
+}
+
+LogStats LogAnalyzer::scanChunk(const Chunk &_chunk) {
+    LogStats stats;
+    const char *line = _chunk.data;
+    const char *end = _chunk.data + _chunk.size;
+    while(line < end) {
+        const char *newline = static_cast<const char *>(memchr(line, '\n', end - line));
+        const char *lineEnd = newline ? newline : end;
+        if(lineEnd > line) {
+            scanLine(line, int(qMin<qint64>(lineEnd - line, 1 << 20)), stats);
+        }
+        line = lineEnd + 1;
+    }
+    return stats;
+}
+
+void LogAnalyzer::merge(LogStats &_total, const LogStats &_chunk) {
+    // chunks arrive in file order, so a handshake finished early in this
+    // chunk may have started at the end of the previous ones
+    QHash<QByteArray, qint64>::const_iterator finished = _chunk.finishedWithoutStart.constBegin();
+    while (finished != _chunk.finishedWithoutStart.constEnd()) {
+        QHash<QByteArray, qint64>::iterator started = _total.openHandshakes.find(finished.key());
+        if(started != _total.openHandshakes.end()) {
+            if(started.value() >= 0 && finished.value() >= 0) {
+                addHandshake(_total, finished.value() - started.value());
+            }
+            _total.openHandshakes.erase(started);
+        }
+        ++finished;
+    }
+    QHash<QByteArray, qint64>::const_iterator open = _chunk.openHandshakes.constBegin();
+    while (open != _chunk.openHandshakes.constEnd() && _total.openHandshakes.size() < maxOpenHandshakes) {
+        _total.openHandshakes.insert(open.key(), open.value());
+        ++open;
+    }
+
+    _total.lines += _chunk.lines;
+    _total.handshakes += _chunk.handshakes;
+    _total.handshakeSecondsTotal += _chunk.handshakeSecondsTotal;
+    _total.handshakeSecondsMax = qMax(_total.handshakeSecondsMax, _chunk.handshakeSecondsMax);
+    for(int i = 0; i < LogStats::HandshakeBuckets; ++i) {
+        _total.handshakeHistogram[i] += _chunk.handshakeHistogram[i];
+    }
+    _total.reconnects += _chunk.reconnects;
+    QMap<QString, qint64>::const_iterator cause = _chunk.reconnectCauses.constBegin();
+    while (cause != _chunk.reconnectCauses.constEnd()) {
+        _total.reconnectCauses[cause.key()] += cause.value();
+        ++cause;
+    }
+    _total.tlsErrors += _chunk.tlsErrors;
+    _total.mtuWarnings += _chunk.mtuWarnings;
+    _total.replayWarnings += _chunk.replayWarnings;
+    if(_chunk.tunReadBytes >= 0) {
+        _total.tunReadBytes = _chunk.tunReadBytes;
+    }
+    if(_chunk.tunWriteBytes >= 0) {
+        _total.tunWriteBytes = _chunk.tunWriteBytes;
+    }
+    if(_chunk.linkReadBytes >= 0) {
+        _total.linkReadBytes = _chunk.linkReadBytes;
+    }
+    if(_chunk.linkWriteBytes >= 0) {
+        _total.linkWriteBytes = _chunk.linkWriteBytes;
+    }
+}
+
+bool LogAnalyzer::analyzeMapped(const uchar *_data, qint64 _size) {
+    // chunk borders are moved to the next line break
+    QList<Chunk> chunks;
+    const char *data = reinterpret_cast<const char *>(_data);
+    qint64 offset = 0;
+    while(offset < _size) {
+        qint64 end = qMin(offset + chunkSize, _size);
+        if(end < _size) {
+            const char *newline = static_cast<const char *>(memchr(data + end, '\n', _size - end));
+            end = newline ? newline - data + 1 : _size;
+        }
+        Chunk chunk;
+        chunk.data = data + offset;
+        chunk.size = end - offset;
+        chunks << chunk;
+        offset = end;
+    }
+    total = QtConcurrent::blockingMappedReduced(chunks, &LogAnalyzer::scanChunk, &LogAnalyzer::merge,
+                                                QtConcurrent::OrderedReduce);
+    return true;
+}
+
+bool LogAnalyzer::analyzeStreamed(QFile &_file) {
+    // one batch of chunks per round keeps the memory bounded
+    int batchSize = qMax(QThread::idealThreadCount(), 1);
+    QByteArray carry;
+    while(!_file.atEnd()) {
+        QList<QByteArray> buffers;
+        for(int i = 0; i < batchSize && !_file.atEnd(); ++i) {
+            QByteArray buffer = carry + _file.read(chunkSize);
+            int lastNewline = buffer.lastIndexOf('\n');
+            if(lastNewline >= 0 && !_file.atEnd()) {
+                carry = buffer.mid(lastNewline + 1);
+                buffer.truncate(lastNewline + 1);
+            }
+            else {
+                carry.clear();
+            }
+            buffers << buffer;
+        }
+        if(_file.error() != QFile::NoError) {
+            error = _file.errorString();
+            return false;
+        }
+        QList<Chunk> chunks;
+        for(QList<QByteArray>::const_iterator buffer = buffers.constBegin(); buffer != buffers.constEnd(); ++buffer) {
+            Chunk chunk;
+            chunk.data = buffer->constData();
+            chunk.size = buffer->size();
+            chunks << chunk;
+        }
+        LogStats batch = QtConcurrent::blockingMappedReduced(chunks, &LogAnalyzer::scanChunk,
+                                                             &LogAnalyzer::merge,
+                                                             QtConcurrent::OrderedReduce);
+        merge(total, batch);
+    }
+    return true;
+}
+
+bool LogAnalyzer::analyze(const QString _fileName) {
+    total = LogStats();
+    error.clear();
+
+    QFile file(_fileName);
+    if(!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    static Statistics::Metric *const analyzeTiming = Statistics::instance()->metric("analyze_log", Statistics::Timing);
+    ScopedTiming timing(analyzeTiming);
+    timing.setUnits(file.size());
+
+    bool ok;
+    uchar *mapped = file.size() > 0 ? file.map(0, file.size()) : 0;
+    if(mapped) {
+        ok = analyzeMapped(mapped, file.size());
+        file.unmap(mapped);
+    }
+    else {
+        ok = analyzeStreamed(file);
+    }
+    // whatever is still open never finished
+    total.openHandshakes.clear();
+    total.finishedWithoutStart.clear();
+    return ok;
+}
+
+LogStats LogAnalyzer::stats() const {
+    return total;
+}
+
+QString LogAnalyzer::errorString() const {
+    return error;
+}
+
+QString LogAnalyzer::report() const {
+    QStringList lines;
+    lines << QObject::tr("%1 lines").arg(total.lines);
+    if(total.handshakes > 0) {
+        lines << QObject::tr("%1 handshakes, average %2 s, slowest %3 s")
+                 .arg(total.handshakes)
+                 .arg(double(total.handshakeSecondsTotal) / total.handshakes, 0, 'f', 1)
+                 .arg(total.handshakeSecondsMax);
+        static const char *const buckets[LogStats::HandshakeBuckets] = {
+            "< 1 s", "1-2 s", "2-5 s", "5-10 s", "10-30 s", "30-60 s", ">= 60 s"};
+        for(int i = 0; i < LogStats::HandshakeBuckets; ++i) {
+            if(total.handshakeHistogram[i] > 0) {
+                lines << QString("  %1: %2").arg(buckets[i]).arg(total.handshakeHistogram[i]);
+            }
+        }
+    }
+    lines << QObject::tr("%1 restarts").arg(total.reconnects);
+    QMap<QString, qint64>::const_iterator cause = total.reconnectCauses.constBegin();
+    while (cause != total.reconnectCauses.constEnd()) {
+        lines << QString("  %1: %2").arg(cause.key()).arg(cause.value());
+        ++cause;
+    }
+    lines << QObject::tr("%1 TLS errors").arg(total.tlsErrors)
+          << QObject::tr("%1 MTU or fragmentation warnings").arg(total.mtuWarnings)
+          << QObject::tr("%1 replay warnings").arg(total.replayWarnings);
+    if(total.linkReadBytes >= 0 || total.tunReadBytes >= 0) {
+        lines << QObject::tr("Link read/write: %1 / %2 bytes, tunnel read/write: %3 / %4 bytes")
+                 .arg(total.linkReadBytes).arg(total.linkWriteBytes)
+                 .arg(total.tunReadBytes).arg(total.tunWriteBytes);
+    }
+    return lines.join("\n");
+}
+
+QStringList LogAnalyzer::suggestions(const QStringList _profileLines) const {
+    QStringList directives;
+    int verbosity = 1;
+    for(QStringList::const_iterator line = _profileLines.constBegin(); line != _profileLines.constEnd(); ++line) {
+        QString directive = line->trimmed().section(' ', 0, 0);
+        directives << directive;
+        if(directive == "verb") {
+            verbosity = line->trimmed().section(' ', 1, 1).toInt();
+        }
+    }
+
+    QStringList hints;
+    if(total.mtuWarnings > 0 && !directives.contains("mssfix")) {
+        hints << QObject::tr("MTU warnings and no mssfix: use the MTU calculator to set tun-mtu and mssfix.");
+    }
+    else if(total.mtuWarnings > 0) {
+        hints << QObject::tr("MTU warnings despite mssfix: lower mssfix or measure the path MTU again.");
+    }
+    if(total.replayWarnings > 0 && !directives.contains("mute-replay-warnings")) {
+        hints << QObject::tr("Replay warnings: on links that reorder packets, add mute-replay-warnings"
+                             " or widen replay-window.");
+    }
+    if(total.reconnectCauses.value("ping-restart") > 0) {
+        hints << QObject::tr("%1 restarts after ping-restart: check keepalive on the Connection tab.")
+                 .arg(total.reconnectCauses.value("ping-restart"));
+    }
+    if(total.tlsErrors > 0) {
+        hints << QObject::tr("TLS errors: check tls-auth/tls-crypt keys and consider a larger hand-window.");
+    }
+    if(total.handshakes > 0 && total.handshakeSecondsTotal / total.handshakes >= 5) {
+        hints << QObject::tr("Slow handshakes: prefer ECDSA keys and check hand-window and server load.");
+    }
+    if(verbosity >= 4 && total.lines > 1000000) {
+        hints << QObject::tr("verb %1 logs per packet details, verb 3 or lower saves a lot of CPU and disk.")
+                 .arg(verbosity);
+    }
+    return hints;
+}
@@ -0,0 +1,92 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef LOGANALYZER_H
+#define LOGANALYZER_H
+
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+QT_BEGIN_NAMESPACE
+class QFile;
+QT_END_NAMESPACE
+
+// Aggregated findings of an OpenVPN log. Everything is a counter or a
+// fixed size histogram so the size does not depend on the log.
+struct LogStats
+{
+    enum { HandshakeBuckets = 7 };
+
+    LogStats();
+
+    qint64 lines;
+    qint64 handshakes;
+    qint64 handshakeSecondsTotal;
+    qint64 handshakeSecondsMax;
+    qint64 handshakeHistogram[HandshakeBuckets];  // <1, <2, <5, <10, <30, <60, >=60 s
+    qint64 reconnects;
+    QMap<QString, qint64> reconnectCauses;
+    qint64 tlsErrors;
+    qint64 mtuWarnings;
+    qint64 replayWarnings;
+    qint64 tunReadBytes;        // last value the log reported, -1 if none
+    qint64 tunWriteBytes;
+    qint64 linkReadBytes;
+    qint64 linkWriteBytes;
+
+    // handshakes that cross a chunk boundary, keyed by peer address
+    QHash<QByteArray, qint64> openHandshakes;       // started, not finished yet
+    QHash<QByteArray, qint64> finishedWithoutStart; // finished, start in an earlier chunk
+};
+
+// Scans OpenVPN logs of any size in parallel chunks. The file is memory
+// mapped when possible and read in bounded batches otherwise, so memory use
+// stays flat however large the log is.
+class LogAnalyzer
+{
+public:
+    explicit LogAnalyzer(qint64 _chunkSize = 8 * 1024 * 1024);
+
+    bool analyze(const QString _fileName);
+    LogStats stats() const;
+    QString errorString() const;
+
+    QString report() const;
+    // ties the findings to directives of the profile the log was made with
+    QStringList suggestions(const QStringList _profileLines) const;
+
+    static qint64 parseTimestamp(const char *_line, int _length);   // -1 if none
+
+private:
+    struct Chunk {
+        const char *data;
+        qint64 size;
+    };
+
+    static LogStats scanChunk(const Chunk &_chunk);
+    static void merge(LogStats &_total, const LogStats &_chunk);
+    static void scanLine(const char *_line, int _length, LogStats &_stats);
+    static void addHandshake(LogStats &_stats, qint64 _seconds);
+
+    bool analyzeMapped(const uchar *_data, qint64 _size);
+    bool analyzeStreamed(QFile &_file);
+
+    qint64 chunkSize;
+    LogStats total;
+    QString error;
+};
+
+#endif // LOGANALYZER_H
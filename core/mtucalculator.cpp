@@ -0,0 +1,150 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "mtucalculator.h"
+#include <QObject>
+
+static QString firstValue(const QStringList &_lines, const QString _directive) {
+    for(QStringList::const_iterator line = _lines.constBegin(); line != _lines.constEnd(); ++line) {
+        QStringList fields = line->simplified().split(' ');
+        if(fields.size() >= 2 && fields.at(0) == _directive) {
+            return fields.at(1);
+        }
+    }
+    return QString();
+}
+
+MtuCalculator::Input MtuCalculator::fromDirectives(const QStringList _lines, int _pathMtu) {
+    Input input;
+    input.pathMtu = _pathMtu;
+    input.proto = firstValue(_lines, "proto");
+    input.dev = firstValue(_lines, "dev");
+    input.auth = firstValue(_lines, "auth");
+
+    // data-ciphers is negotiated first, the old cipher directive is the fallback
+    input.cipher = firstValue(_lines, "data-ciphers").section(':', 0, 0);
+    if(input.cipher.isEmpty()) {
+        input.cipher = firstValue(_lines, "cipher");
+    }
+
+    input.compression = firstValue(_lines, "compress");
+    if(input.compression.isEmpty()) {
+        for(QStringList::const_iterator line = _lines.constBegin(); line != _lines.constEnd(); ++line) {
+            if(line->trimmed() == "compress") {
+                input.compression = "compress";
+            }
+            else if(line->trimmed().startsWith("comp-lzo")) {
+                input.compression = "comp-lzo";
+            }
+        }
+    }
+    return input;
+}
+
+bool MtuCalculator::isAead(const QString _cipher) {
+    QString cipher = _cipher.toUpper();
+    return cipher.endsWith("-GCM") || cipher == "CHACHA20-POLY1305";
+}
+
+int MtuCalculator::cipherBlockSize(const QString _cipher) {
+    QString cipher = _cipher.toUpper();
+    if(cipher.startsWith("BF-") || cipher.startsWith("DES") || cipher.startsWith("CAST5")) {
+        return 8;
+    }
+    if(cipher.endsWith("-CTR") || cipher.endsWith("-OFB") || cipher.endsWith("-CFB")) {
+        return 1; // stream modes are not padded
+    }
+    return 16;
+}
+
+int MtuCalculator::digestSize(const QString _auth) {
+    QString auth = _auth.toUpper();
+    if(auth.isEmpty() || auth == "SHA1") {
+        return 20; // OpenVPN default
+    }
+    if(auth == "NONE") {
+        return 0;
+    }
+    if(auth.contains("512")) {
+        return 64;
+    }
+    if(auth.contains("384")) {
+        return 48;
+    }
+    if(auth.contains("256")) {
+        return 32;
+    }
+    if(auth.contains("224")) {
+        return 28;
+    }
+    if(auth == "MD5") {
+        return 16;
+    }
+    return 20;
+}
+
+MtuCalculator::Result MtuCalculator::calculate(const Input &_input) {
+    Result result;
+    bool tcp = _input.proto.startsWith("tcp");
+    bool ipv6 = _input.proto.section('-', 0, 0).endsWith('6');   // tcp6-client as well
+    QString cipher = _input.cipher.isEmpty() ? QString("AES-256-GCM") : _input.cipher;
+
+    int ipHeader = ipv6 ? 40 : 20;
+    int transport = tcp ? 20 + 2 : 8;  // TCP adds a two byte length prefix per packet
+    int opcode = 4;                     // P_DATA_V2 opcode and peer id
+    int packetId = 4;
+    int crypto;
+    QString cryptoLabel;
+    if(isAead(cipher)) {
+        crypto = 16;
+        cryptoLabel = QObject::tr("%1 tag").arg(cipher);
+    }
+    else if(cipher.toLower() == "none") {
+        crypto = digestSize(_input.auth);
+        cryptoLabel = QObject::tr("HMAC");
+    }
+    else {
+        // IV, HMAC and worst case padding to the next block
+        int block = cipherBlockSize(cipher);
+        crypto = (block > 1 ? block : 16) + digestSize(_input.auth) + (block > 1 ? block : 0);
+        cryptoLabel = QObject::tr("%1 IV, HMAC and padding").arg(cipher);
+    }
+    int compression = 0;
+    if(!_input.compression.isEmpty() && _input.compression != "stub-v2" && _input.compression != "lz4-v2") {
+        compression = 1; // v1 framing always spends one byte, v2 only for escaped payloads
+    }
+    int ethernet = _input.dev.startsWith("tap") ? 14 : 0;
+
+    result.overhead = ipHeader + transport + opcode + packetId + crypto + compression + ethernet;
+    result.tunMtu = _input.pathMtu - result.overhead;
+    result.mssfix = _input.pathMtu - ipHeader - (tcp ? 20 : 8);
+
+    // mssfix only clamps TCP; bridged tap links also carry large non-TCP
+    // frames that nothing else would shrink. fragment does not exist for TCP.
+    result.fragment = (!tcp && ethernet > 0) ? result.mssfix : 0;
+
+    result.breakdown << QObject::tr("Outer %1 header: %2").arg(ipv6 ? "IPv6" : "IPv4").arg(ipHeader)
+                     << QObject::tr("%1 header: %2").arg(tcp ? "TCP" : "UDP").arg(transport)
+                     << QObject::tr("Opcode and peer id: %1").arg(opcode)
+                     << QObject::tr("Packet id: %1").arg(packetId)
+                     << QObject::tr("%1: %2").arg(cryptoLabel).arg(crypto);
+    if(compression > 0) {
+        result.breakdown << QObject::tr("Compression framing: %1").arg(compression);
+    }
+    if(ethernet > 0) {
+        result.breakdown << QObject::tr("Ethernet header (tap): %1").arg(ethernet);
+    }
+    return result;
+}
@@ -0,0 +1,53 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef MTUCALCULATOR_H
+#define MTUCALCULATOR_H
+
+#include <QString>
+#include <QStringList>
+
+// Models the bytes OpenVPN adds around every data channel packet and derives
+// tun-mtu, mssfix and fragment values that keep the encrypted datagrams
+// within a given path MTU. mssfix and fragment use the classic semantics
+// (size of the UDP payload), which every 2.x release understands.
+class MtuCalculator
+{
+public:
+    struct Input {
+        int pathMtu;
+        QString proto;          // udp, tcp, udp6, tcp-client, ...
+        QString dev;            // tun or tap
+        QString cipher;         // first negotiable cipher
+        QString auth;           // HMAC digest, only used by non-AEAD ciphers
+        QString compression;    // "", "comp-lzo", "lz4-v2", "stub-v2", ...
+    };
+
+    struct Result {
+        int tunMtu;
+        int mssfix;
+        int fragment;           // 0 when fragmentation is not advisable
+        int overhead;           // bytes between path MTU and tun-mtu
+        QStringList breakdown;  // one "label: bytes" entry per component
+    };
+
+    static Input fromDirectives(const QStringList _lines, int _pathMtu);
+    static Result calculate(const Input &_input);
+
+    static int digestSize(const QString _auth);
+    static int cipherBlockSize(const QString _cipher);
+    static bool isAead(const QString _cipher);
+};
+
+#endif // MTUCALCULATOR_H
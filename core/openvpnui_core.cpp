@@ -0,0 +1,150 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "openvpnui_core.h"
+#include "configdocument.h"
+#include "pemvalidator.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+struct ovpnui_document
+{
+    QMutex lock;
+    ConfigDocument document;
+};
+
+static char *copyOut(const QByteArray &_data, size_t *_length) {
+    char *buffer = static_cast<char *>(std::malloc(size_t(_data.size()) + 1));
+    if(!buffer) {
+        return 0;
+    }
+    std::memcpy(buffer, _data.constData(), size_t(_data.size()));
+    buffer[_data.size()] = '\0';
+    if(_length) {
+        *_length = size_t(_data.size());
+    }
+    return buffer;
+}
+
+ovpnui_document *ovpnui_document_new(void) {
+    return new (std::nothrow) ovpnui_document;
+}
+
+void ovpnui_document_free(ovpnui_document *doc) {
+    delete doc;
+}
+
+int ovpnui_document_parse(ovpnui_document *doc, const char *text, size_t length) {
+    if(!doc || (!text && length > 0) || length > size_t(INT_MAX)) {
+        return OVPNUI_E_INVALID;
+    }
+    QString contents = QString::fromUtf8(text, int(length));
+    QMutexLocker locker(&doc->lock);
+    doc->document.parse(contents);
+    return OVPNUI_OK;
+}
+
+int ovpnui_document_add_line(ovpnui_document *doc, const char *line) {
+    if(!doc || !line || !*line) {
+        return OVPNUI_E_INVALID;
+    }
+    QString value = QString::fromUtf8(line);
+    QMutexLocker locker(&doc->lock);
+    doc->document.addLine(value);
+    return OVPNUI_OK;
+}
+
+int ovpnui_document_remove_line(ovpnui_document *doc, const char *line) {
+    if(!doc || !line || !*line) {
+        return OVPNUI_E_INVALID;
+    }
+    QString value = QString::fromUtf8(line);
+    QMutexLocker locker(&doc->lock);
+    doc->document.removeLine(value);
+    return OVPNUI_OK;
+}
+
+int ovpnui_document_is_active(ovpnui_document *doc, const char *directive) {
+    if(!doc || !directive) {
+        return OVPNUI_E_INVALID;
+    }
+    QString key = QString::fromUtf8(directive);
+    QMutexLocker locker(&doc->lock);
+    return doc->document.isConfigActive(key) ? 1 : 0;
+}
+
+int ovpnui_document_add_tags(ovpnui_document *doc, const char *tag, const char *content) {
+    if(!doc || !tag || !*tag || !content) {
+        return OVPNUI_E_INVALID;
+    }
+    QString name = QString::fromUtf8(tag);
+    QString body = QString::fromUtf8(content);
+    QMutexLocker locker(&doc->lock);
+    return doc->document.addTags(name, body) ? OVPNUI_OK : OVPNUI_E_REJECTED;
+}
+
+int ovpnui_document_remove_tags(ovpnui_document *doc, const char *tag) {
+    if(!doc || !tag || !*tag) {
+        return OVPNUI_E_INVALID;
+    }
+    QString name = QString::fromUtf8(tag);
+    QMutexLocker locker(&doc->lock);
+    doc->document.removeTags(name);
+    return OVPNUI_OK;
+}
+
+int ovpnui_validate_block(const char *tag, const char *content, size_t length) {
+    if(!tag || (!content && length > 0) || length > size_t(INT_MAX)) {
+        return OVPNUI_E_INVALID;
+    }
+    return int(PemValidator::validate(QString::fromUtf8(tag),
+                                      QByteArray::fromRawData(content, int(length))));
+}
+
+int ovpnui_document_get_value(ovpnui_document *doc, const char *directive, char **value) {
+    if(!doc || !directive || !value) {
+        return OVPNUI_E_INVALID;
+    }
+    QString key = QString::fromUtf8(directive);
+    QMutexLocker locker(&doc->lock);
+    *value = 0;
+    if(!doc->document.isConfigActive(key)) {
+        return OVPNUI_OK;
+    }
+    QByteArray data = doc->document.getConfigValue(key).toUtf8();
+    locker.unlock();
+    *value = copyOut(data, 0);
+    return *value ? OVPNUI_OK : OVPNUI_E_NOMEM;
+}
+
+int ovpnui_document_render(ovpnui_document *doc, char **buffer, size_t *length) {
+    if(!doc || !buffer) {
+        return OVPNUI_E_INVALID;
+    }
+    QMutexLocker locker(&doc->lock);
+    QString rendered = doc->document.render();
+    locker.unlock();
+    // the UTF-8 conversion and copy run outside the lock
+    *buffer = copyOut(rendered.toUtf8(), length);
+    return *buffer ? OVPNUI_OK : OVPNUI_E_NOMEM;
+}
+
+void ovpnui_free(void *buffer) {
+    std::free(buffer);
+}
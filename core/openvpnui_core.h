@@ -0,0 +1,88 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef OPENVPNUI_CORE_H
+#define OPENVPNUI_CORE_H
+
+/* C interface of libopenvpnui-core.
+ *
+ * Every call on one document is serialized by a lock owned by that document,
+ * so a document may be shared between threads. Different documents share
+ * nothing but lock free statistics counters and can be used fully in
+ * parallel.
+ *
+ * Strings are UTF-8. Functions returning int return 0 on success and a
+ * negative OVPNUI_E_* value on failure. Lengths above INT_MAX are rejected
+ * with OVPNUI_E_INVALID. Buffers returned by the library must
+ * be released with ovpnui_free(). */
+
+#include <stddef.h>
+
+/* OPENVPNUI_CORE_STATIC is set when the sources are compiled straight into
+ * an application (core.pri), OPENVPNUI_CORE_LIBRARY when building the DLL */
+#if defined(OPENVPNUI_CORE_STATIC)
+#  define OVPNUI_API
+#elif defined(_WIN32)
+#  if defined(OPENVPNUI_CORE_LIBRARY)
+#    define OVPNUI_API __declspec(dllexport)
+#  else
+#    define OVPNUI_API __declspec(dllimport)
+#  endif
+#else
+#  define OVPNUI_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OVPNUI_OK 0
+#define OVPNUI_E_INVALID -1
+#define OVPNUI_E_NOMEM -2
+#define OVPNUI_E_REJECTED -3
+
+typedef struct ovpnui_document ovpnui_document;
+
+OVPNUI_API ovpnui_document *ovpnui_document_new(void);
+OVPNUI_API void ovpnui_document_free(ovpnui_document *doc);
+
+/* replaces the document with the parsed profile text */
+OVPNUI_API int ovpnui_document_parse(ovpnui_document *doc, const char *text, size_t length);
+
+/* "directive [value]" lines, same semantics as the GUI editor */
+OVPNUI_API int ovpnui_document_add_line(ovpnui_document *doc, const char *line);
+OVPNUI_API int ovpnui_document_remove_line(ovpnui_document *doc, const char *line);
+OVPNUI_API int ovpnui_document_is_active(ovpnui_document *doc, const char *directive);
+
+/* inline blocks such as <ca>, <cert> and <key> */
+OVPNUI_API int ovpnui_document_add_tags(ovpnui_document *doc, const char *tag, const char *content);
+OVPNUI_API int ovpnui_document_remove_tags(ovpnui_document *doc, const char *tag);
+
+/* checks an inline block body: armor, block type for the tag and payload
+ * encoding; returns 0 when valid, otherwise a positive reason code */
+OVPNUI_API int ovpnui_validate_block(const char *tag, const char *content, size_t length);
+
+/* *value receives a NUL terminated copy, NULL when the directive is not set */
+OVPNUI_API int ovpnui_document_get_value(ovpnui_document *doc, const char *directive, char **value);
+
+/* *buffer receives the complete profile, NUL terminated; *length excludes the NUL */
+OVPNUI_API int ovpnui_document_render(ovpnui_document *doc, char **buffer, size_t *length);
+
+OVPNUI_API void ovpnui_free(void *buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENVPNUI_CORE_H */
@@ -0,0 +1,321 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "pemvalidator.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <QtAlgorithms>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PEMVALIDATOR_SSE2
+#endif
+
+static inline bool isBlank(char _c) {
+    return _c == '\n' || _c == '\r' || _c == ' ' || _c == '\t';
+}
+
+static inline int sextet(char _c) {
+    if(_c >= 'A' && _c <= 'Z') {
+        return _c - 'A';
+    }
+    if(_c >= 'a' && _c <= 'z') {
+        return _c - 'a' + 26;
+    }
+    if(_c >= '0' && _c <= '9') {
+        return _c - '0' + 52;
+    }
+    if(_c == '+') {
+        return 62;
+    }
+    return _c == '/' ? 63 : -1;
+}
+
+static inline bool isHexChar(char _c) {
+    return (_c >= '0' && _c <= '9') || (_c >= 'a' && _c <= 'f') || (_c >= 'A' && _c <= 'F');
+}
+
+#ifdef PEMVALIDATOR_SSE2
+// bytes >= 0x80 are negative as signed chars and fall outside every range
+static inline __m128i inRange(__m128i _v, char _low, char _high) {
+    return _mm_and_si128(_mm_cmpgt_epi8(_v, _mm_set1_epi8(char(_low - 1))),
+                         _mm_cmplt_epi8(_v, _mm_set1_epi8(char(_high + 1))));
+}
+
+static inline __m128i blankMask(__m128i _v) {
+    __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(_v, _mm_set1_epi8('\n')),
+                                 _mm_cmpeq_epi8(_v, _mm_set1_epi8('\r')));
+    return _mm_or_si128(blank, _mm_or_si128(_mm_cmpeq_epi8(_v, _mm_set1_epi8(' ')),
+                                            _mm_cmpeq_epi8(_v, _mm_set1_epi8('\t'))));
+}
+
+// maps 16 base64 characters to their 6 bit values; false if any of them is
+// something else, a line break included
+static inline bool sextets(__m128i _v, __m128i *_values) {
+    __m128i upper = inRange(_v, 'A', 'Z');
+    __m128i lower = inRange(_v, 'a', 'z');
+    __m128i digit = inRange(_v, '0', '9');
+    __m128i plus = _mm_cmpeq_epi8(_v, _mm_set1_epi8('+'));
+    __m128i slash = _mm_cmpeq_epi8(_v, _mm_set1_epi8('/'));
+    __m128i any = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(plus, slash)));
+    if(_mm_movemask_epi8(any) != 0xffff) {
+        return false;
+    }
+    // each class moves by its own offset: 'A' to 0, 'a' to 26, '0' to 52
+    __m128i offset = _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')),
+                                  _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+    offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+    offset = _mm_or_si128(offset, _mm_or_si128(_mm_and_si128(plus, _mm_set1_epi8(62 - '+')),
+                                               _mm_and_si128(slash, _mm_set1_epi8(63 - '/'))));
+    *_values = _mm_add_epi8(_v, offset);
+    return true;
+}
+
+// merges 16 sextets into four 24 bit groups and writes their 12 bytes
+static inline void packSextets(__m128i _values, char *_out) {
+    // a b -> ab in every 16 bit lane, then ab cd -> abcd in every 32 bit lane
+    __m128i pairs = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(_values, _mm_set1_epi16(0x00ff)), 6),
+                                 _mm_srli_epi16(_values, 8));
+    __m128i groups = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(pairs, _mm_set1_epi32(0xffff)), 12),
+                                  _mm_srli_epi32(pairs, 16));
+    quint32 group[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(group), groups);
+    for(int k = 0; k < 4; ++k) {
+        _out[3 * k] = char(group[k] >> 16);
+        _out[3 * k + 1] = char(group[k] >> 8);
+        _out[3 * k + 2] = char(group[k]);
+    }
+}
+#endif
+
+qint64 PemValidator::decodeBase64(const char *_data, qint64 _length, char *_out) {
+    qint64 count = 0;
+    quint32 bits = 0;
+    char *out = _out;
+    qint64 i = 0;
+    while (i < _length) {
+#ifdef PEMVALIDATOR_SSE2
+        // a 64 column line is four full vectors, the line break goes below
+        __m128i values;
+        if(count % 4 == 0 && i + 16 <= _length &&
+                sextets(_mm_loadu_si128(reinterpret_cast<const __m128i *>(_data + i)), &values)) {
+            packSextets(values, out);
+            out += 12;
+            count += 16;
+            i += 16;
+            continue;
+        }
+#endif
+        char c = _data[i++];
+        int value = sextet(c);
+        if(value < 0) {
+            if(!isBlank(c)) {
+                return -1;
+            }
+            continue;
+        }
+        bits = (bits << 6) | quint32(value);
+        if(++count % 4 == 0) {
+            *out++ = char(bits >> 16);
+            *out++ = char(bits >> 8);
+            *out++ = char(bits);
+            bits = 0;
+        }
+    }
+    // two or three characters before the padding carry one or two bytes
+    int rest = int(count % 4);
+    if(rest >= 2) {
+        bits <<= 6 * (4 - rest);
+        *out++ = char(bits >> 16);
+        if(rest == 3) {
+            *out++ = char(bits >> 8);
+        }
+    }
+    return count;
+}
+
+qint64 PemValidator::countHex(const char *_data, qint64 _length) {
+    qint64 count = 0;
+    qint64 i = 0;
+#ifdef PEMVALIDATOR_SSE2
+    for(; i + 16 <= _length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(_data + i));
+        __m128i chars = _mm_or_si128(inRange(v, '0', '9'),
+                                     _mm_or_si128(inRange(v, 'a', 'f'), inRange(v, 'A', 'F')));
+        int charBits = _mm_movemask_epi8(chars);
+        if((charBits | _mm_movemask_epi8(blankMask(v))) != 0xffff) {
+            return -1;
+        }
+        count += qPopulationCount(quint32(charBits));
+    }
+#endif
+    for(; i < _length; ++i) {
+        if(isHexChar(_data[i])) {
+            ++count;
+        }
+        else if(!isBlank(_data[i])) {
+            return -1;
+        }
+    }
+    return count;
+}
+
+// the outer SEQUENCE of a certificate or key has to span exactly the
+// decoded bytes, a truncated or padded body does not
+static bool isDerSequence(const unsigned char *_der, qint64 _size) {
+    if(_size < 2 || _der[0] != 0x30) {
+        return false;
+    }
+    qint64 length = _der[1];
+    int header = 2;
+    if(length & 0x80) {
+        int bytes = int(length & 0x7f);
+        if(bytes == 0 || bytes > 4 || _size < 2 + bytes) {
+            return false;
+        }
+        length = 0;
+        for(int k = 0; k < bytes; ++k) {
+            length = (length << 8) | _der[2 + k];
+        }
+        header += bytes;
+    }
+    return header + length == _size;
+}
+
+static QStringList expectedTypes(const QString &_tag) {
+    if(_tag == "ca" || _tag == "cert" || _tag == "extra-certs") {
+        return QStringList() << "CERTIFICATE" << "TRUSTED CERTIFICATE" << "X509 CERTIFICATE";
+    }
+    if(_tag == "key") {
+        return QStringList() << "PRIVATE KEY" << "RSA PRIVATE KEY" << "EC PRIVATE KEY"
+                             << "ENCRYPTED PRIVATE KEY";
+    }
+    if(_tag == "tls-auth" || _tag == "tls-crypt" || _tag == "secret") {
+        return QStringList() << "OpenVPN Static key V1";
+    }
+    return QStringList();
+}
+
+PemValidator::Result PemValidator::validate(const QString _tag, const QByteArray &_content) {
+    QStringList types = expectedTypes(_tag);
+    bool staticKey = types.contains("OpenVPN Static key V1");
+    const char *data = _content.constData();
+    QByteArray decoded;
+    int blocks = 0;
+    int pos = 0;
+
+    // a bundle may hold several blocks, e.g. a CA chain
+    while (true) {
+        int begin = _content.indexOf("-----BEGIN ", pos);
+        if(begin < 0) {
+            break;
+        }
+        int labelEnd = _content.indexOf("-----", begin + 11);
+        if(labelEnd < 0) {
+            return MissingArmor;
+        }
+        QByteArray label = _content.mid(begin + 11, labelEnd - begin - 11);
+        if(!types.isEmpty() && !types.contains(QString::fromLatin1(label))) {
+            return WrongBlockType;
+        }
+        QByteArray endLine = "-----END " + label + "-----";
+        int bodyStart = labelEnd + 5;
+        int end = _content.indexOf(endLine, bodyStart);
+        if(end < 0) {
+            return MissingArmor;
+        }
+
+        // legacy encrypted keys carry "Proc-Type:" style headers, ended by
+        // an empty line in either line ending
+        bool encrypted = false;
+        int headerEnd = _content.indexOf("\n\n", bodyStart);
+        int separator = 2;
+        int crlfHeaderEnd = _content.indexOf("\r\n\r\n", bodyStart);
+        if(crlfHeaderEnd >= 0 && (headerEnd < 0 || crlfHeaderEnd < headerEnd)) {
+            headerEnd = crlfHeaderEnd;
+            separator = 4;
+        }
+        if(headerEnd > 0 && headerEnd < end) {
+            QByteArray headers = _content.mid(bodyStart, headerEnd - bodyStart);
+            if(headers.contains(':')) {
+                encrypted = headers.contains("Proc-Type:");
+                bodyStart = headerEnd + separator;
+            }
+        }
+
+        qint64 bodyLength = end - bodyStart;
+        if(staticKey) {
+            qint64 digits = countHex(data + bodyStart, bodyLength);
+            if(digits < 0) {
+                return BadAlphabet;
+            }
+            if(digits != 512) { // 2048 bit key
+                return BadLength;
+            }
+        }
+        else {
+            // strip the trailing blanks and up to two padding characters
+            qint64 tail = bodyLength;
+            while (tail > 0 && isBlank(data[bodyStart + tail - 1])) {
+                --tail;
+            }
+            int padding = 0;
+            while (tail > 0 && padding < 2 && data[bodyStart + tail - 1] == '=') {
+                --tail;
+                ++padding;
+            }
+            decoded.resize(int(tail * 3 / 4));
+            qint64 chars = decodeBase64(data + bodyStart, tail, decoded.data());
+            if(chars < 0) {
+                return BadAlphabet;
+            }
+            if(chars == 0 || (chars + padding) % 4 != 0) {
+                return BadLength;
+            }
+            // an encrypted legacy key is ciphertext, not DER
+            if(!encrypted && !isDerSequence(reinterpret_cast<const unsigned char *>(decoded.constData()),
+                                            chars * 3 / 4)) {
+                return NotDer;
+            }
+        }
+        ++blocks;
+        pos = end + endLine.size();
+    }
+
+    if(blocks == 0) {
+        return _content.trimmed().isEmpty() ? Empty : MissingArmor;
+    }
+    return Valid;
+}
+
+QString PemValidator::describe(Result _result) {
+    switch(_result) {
+    case Valid:
+        return QCoreApplication::translate("PemValidator", "The block is valid.");
+    case Empty:
+        return QCoreApplication::translate("PemValidator", "The file is empty.");
+    case MissingArmor:
+        return QCoreApplication::translate("PemValidator", "The file has no complete BEGIN/END block.");
+    case WrongBlockType:
+        return QCoreApplication::translate("PemValidator", "The file holds a different kind of block than expected here.");
+    case BadAlphabet:
+        return QCoreApplication::translate("PemValidator", "The block contains characters that are not allowed in its encoding.");
+    case BadLength:
+        return QCoreApplication::translate("PemValidator", "The block has an invalid length, it is probably truncated.");
+    case NotDer:
+        return QCoreApplication::translate("PemValidator", "The block does not decode to a complete certificate or key structure.");
+    }
+    return QString();
+}
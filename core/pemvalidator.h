@@ -0,0 +1,43 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef PEMVALIDATOR_H
+#define PEMVALIDATOR_H
+
+#include <QByteArray>
+#include <QString>
+
+// Checks the body of an inline block (<ca>, <cert>, <key>, <tls-auth>)
+// before it is added to a profile: armor lines, the block type expected for
+// the tag and the base64 (or hex for static keys) payload. Base64 bodies
+// are decoded, 16 characters at a time with SSE2 where available, and the
+// outer DER SEQUENCE has to span exactly the decoded bytes.
+class PemValidator
+{
+public:
+    enum Result { Valid, Empty, MissingArmor, WrongBlockType, BadAlphabet, BadLength, NotDer };
+
+    static Result validate(const QString _tag, const QByteArray &_content);
+    static QString describe(Result _result);
+
+    // decodes the base64 characters in _data into _out, which needs room
+    // for _length * 3 / 4 bytes, ignoring line breaks and blanks; returns
+    // the number of characters (chars * 3 / 4 bytes are written) or -1 if
+    // anything else is found
+    static qint64 decodeBase64(const char *_data, qint64 _length, char *_out);
+    // counts hex digits in _data, ignoring line breaks and blanks
+    static qint64 countHex(const char *_data, qint64 _length);
+};
+
+#endif // PEMVALIDATOR_H
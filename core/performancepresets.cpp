@@ -0,0 +1,91 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "performancepresets.h"
+#include <QObject>
+
+static PerformancePreset makePreset(const QString _name, const QString _description,
+                                    int _socketBuffer, bool _pushBuffers, bool _fastIo,
+                                    int _txQueueLength, int _verbosity, int _mute) {
+    PerformancePreset preset;
+    preset.name = _name;
+    preset.description = _description;
+    preset.socketBuffer = _socketBuffer;
+    preset.pushBuffers = _pushBuffers;
+    preset.fastIo = _fastIo;
+    preset.txQueueLength = _txQueueLength;
+    preset.verbosity = _verbosity;
+    preset.mute = _mute;
+    return preset;
+}
+
+QList<PerformancePreset> PerformancePresets::all() {
+    QList<PerformancePreset> presets;
+    presets << makePreset(QObject::tr("System defaults"),
+                          QObject::tr("Leaves buffers and queues to the operating system."),
+                          0, false, false, 0, 3, 20)
+            << makePreset(QObject::tr("High bandwidth"),
+                          QObject::tr("Large socket buffers, also pushed to clients, a longer"
+                                      " device queue and fast-io on UDP. For links above"
+                                      " 100 Mbit/s."),
+                          524288, true, true, 1000, 1, 10)
+            << makePreset(QObject::tr("Balanced"),
+                          QObject::tr("Moderate buffers that suit most broadband links."),
+                          262144, true, false, 500, 3, 20)
+            << makePreset(QObject::tr("Low memory device"),
+                          QObject::tr("Small buffers and minimal logging for routers and"
+                                      " embedded clients."),
+                          65536, false, false, 100, 1, 5);
+    return presets;
+}
+
+QStringList PerformancePresets::managedPrefixes() {
+    return QStringList() << "sndbuf " << "rcvbuf " << "fast-io" << "txqueuelen "
+                         << "verb " << "mute " << "push \"sndbuf " << "push \"rcvbuf ";
+}
+
+QStringList PerformancePresets::plan(const PerformancePreset &_preset, const QString _proto,
+                                     bool _server, QStringList *_warnings) {
+    QStringList lines;
+    bool tcp = _proto.startsWith("tcp");
+
+    if(_preset.socketBuffer > 0) {
+        lines << "sndbuf " + QString::number(_preset.socketBuffer)
+              << "rcvbuf " + QString::number(_preset.socketBuffer);
+        if(_preset.pushBuffers && _server) {
+            lines << "push \"sndbuf " + QString::number(_preset.socketBuffer) + "\""
+                  << "push \"rcvbuf " + QString::number(_preset.socketBuffer) + "\"";
+        }
+    }
+    if(_preset.fastIo) {
+        if(tcp) {
+            *_warnings << QObject::tr("fast-io only works with UDP and was left out.");
+        }
+        else {
+            lines << "fast-io";
+            *_warnings << QObject::tr("fast-io has no effect on Windows.");
+        }
+    }
+    if(_preset.txQueueLength > 0) {
+        lines << "txqueuelen " + QString::number(_preset.txQueueLength);
+        *_warnings << QObject::tr("txqueuelen is only honoured on Linux and BSD.");
+    }
+    if(tcp && _preset.socketBuffer > 0) {
+        *_warnings << QObject::tr("Over TCP large buffers add latency when the link is saturated.");
+    }
+    lines << "verb " + QString::number(_preset.verbosity)
+          << "mute " + QString::number(_preset.mute);
+    return lines;
+}
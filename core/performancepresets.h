@@ -0,0 +1,49 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef PERFORMANCEPRESETS_H
+#define PERFORMANCEPRESETS_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+struct PerformancePreset
+{
+    QString name;
+    QString description;
+    int socketBuffer;       // sndbuf and rcvbuf, 0 leaves them to the OS
+    bool pushBuffers;       // servers push the same sizes to their clients
+    bool fastIo;
+    int txQueueLength;      // 0 keeps the system default
+    int verbosity;
+    int mute;
+};
+
+// Data channel tuning presets. A preset owns the directives listed in
+// managedPrefixes(): applying it removes all of them and writes the lines
+// from plan(), so switching presets never leaves stale values behind.
+class PerformancePresets
+{
+public:
+    static QList<PerformancePreset> all();
+    static QStringList managedPrefixes();
+
+    // lines to write for this profile; combinations that cannot work are
+    // left out and explained in _warnings
+    static QStringList plan(const PerformancePreset &_preset, const QString _proto,
+                            bool _server, QStringList *_warnings);
+};
+
+#endif // PERFORMANCEPRESETS_H
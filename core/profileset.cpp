@@ -0,0 +1,64 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "profileset.h"
+#include <QRegularExpression>
+#include <QStringList>
+
+bool ProfileSet::parseUserLine(const QString _line, ProfileEntry *_entry) {
+    QString line = _line.trimmed();
+    if(line.isEmpty() || line.at(0) == '#' || line.at(0) == ';') {
+        return false;
+    }
+
+    QStringList fields = line.split(QRegularExpression("[\\s,]+"), QString::SkipEmptyParts);
+    QString name = fields.takeFirst();
+    // the name ends up in archive paths, keep it a plain file name
+    if(name.contains('/') || name.contains('\\') || name.startsWith('.')) {
+        return false;
+    }
+
+    _entry->name = name;
+    _entry->vars.clear();
+    for(QStringList::const_iterator field = fields.constBegin(); field != fields.constEnd(); ++field) {
+        int split = field->indexOf('=');
+        if(split > 0) {
+            _entry->vars.insert(field->left(split), field->mid(split + 1));
+        }
+    }
+    return true;
+}
+
+QString ProfileSet::render(const QString _template, const ProfileEntry &_entry) {
+    if(!_template.contains("${")) {
+        return _template;
+    }
+
+    QString rendered = _template;
+    rendered.replace("${name}", _entry.name);
+    QMap<QString, QString>::const_iterator i = _entry.vars.constBegin();
+    while (i != _entry.vars.constEnd()) {
+        rendered.replace("${" + i.key() + "}", i.value());
+        ++i;
+    }
+    return rendered;
+}
+
+QString ProfileSet::profilePath(const ProfileEntry &_entry, bool _userDirs) {
+    if(_userDirs) {
+        return _entry.name + "/" + _entry.name + ".ovpn";
+    }
+    return _entry.name + ".ovpn";
+}
@@ -0,0 +1,39 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef PROFILESET_H
+#define PROFILESET_H
+
+#include <QMap>
+#include <QString>
+
+// One user of a profile set. A user list has one user per line:
+//   <name> [key=value ...]
+// Every "${key}" in the template is replaced by its value, "${name}" by the
+// user name.
+struct ProfileEntry
+{
+    QString name;
+    QMap<QString, QString> vars;
+};
+
+class ProfileSet
+{
+public:
+    static bool parseUserLine(const QString _line, ProfileEntry *_entry);
+    static QString render(const QString _template, const ProfileEntry &_entry);
+    static QString profilePath(const ProfileEntry &_entry, bool _userDirs);
+};
+
+#endif // PROFILESET_H
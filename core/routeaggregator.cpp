@@ -0,0 +1,187 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "routeaggregator.h"
+#include "ippool.h"
+#include <QMap>
+
+static inline int bitAt(quint32 _address, int _depth) {
+    return (_address >> (31 - _depth)) & 1;
+}
+
+RouteAggregator::RouteAggregator() {
+    newNode();  // root, 0.0.0.0/0
+}
+
+int RouteAggregator::newNode() {
+    Node node;
+    node.child[0] = -1;
+    node.child[1] = -1;
+    node.full = false;
+    nodes.append(node);
+    return nodes.size() - 1;
+}
+
+int RouteAggregator::childOf(int _node, int _bit) {
+    if(nodes.at(_node).child[_bit] < 0) {
+        int child = newNode();
+        nodes[_node].child[_bit] = child;
+    }
+    return nodes.at(_node).child[_bit];
+}
+
+void RouteAggregator::add(quint32 _network, int _prefixLength) {
+    int node = 0;
+    for(int depth = 0; depth < _prefixLength; ++depth) {
+        if(nodes.at(node).full) {
+            return; // already covered by a shorter prefix
+        }
+        node = childOf(node, bitAt(_network, depth));
+    }
+    // everything below is covered now
+    nodes[node].full = true;
+    nodes[node].child[0] = -1;
+    nodes[node].child[1] = -1;
+}
+
+void RouteAggregator::exclude(quint32 _network, int _prefixLength) {
+    int node = 0;
+    for(int depth = 0; depth < _prefixLength; ++depth) {
+        if(nodes.at(node).full) {
+            // split the covering prefix into its two halves
+            nodes[node].full = false;
+            nodes[childOf(node, 0)].full = true;
+            nodes[childOf(node, 1)].full = true;
+        }
+        int child = nodes.at(node).child[bitAt(_network, depth)];
+        if(child < 0) {
+            return; // nothing of it was covered
+        }
+        node = child;
+    }
+    nodes[node].full = false;
+    nodes[node].child[0] = -1;
+    nodes[node].child[1] = -1;
+}
+
+bool RouteAggregator::compact(int _node) {
+    Node &node = nodes[_node];
+    if(node.full) {
+        return true;
+    }
+    int left = node.child[0];
+    int right = node.child[1];
+    bool leftFull = left >= 0 && compact(left);
+    bool rightFull = right >= 0 && compact(right);
+    if(leftFull && rightFull) {
+        // siblings merge into their parent
+        nodes[_node].full = true;
+        nodes[_node].child[0] = -1;
+        nodes[_node].child[1] = -1;
+        return true;
+    }
+    return false;
+}
+
+void RouteAggregator::collect(int _node, quint32 _network, int _depth, QList<Prefix> &_out) const {
+    const Node &node = nodes.at(_node);
+    if(node.full) {
+        _out << Prefix(_network, _depth);
+        return;
+    }
+    for(int bit = 0; bit < 2; ++bit) {
+        if(node.child[bit] >= 0) {
+            collect(node.child[bit], _network | (quint32(bit) << (31 - _depth)), _depth + 1, _out);
+        }
+    }
+}
+
+QList<RouteAggregator::Prefix> RouteAggregator::prefixes() const {
+    RouteAggregator compacted(*this);
+    compacted.compact(0);
+    QList<Prefix> out;
+    compacted.collect(0, 0, 0, out);
+    return out;
+}
+
+QStringList RouteAggregator::aggregateDirectives(const QStringList _lines, const QStringList _exclusions) {
+    // routes only merge with routes sharing the same gateway and metric
+    QMap<QString, RouteAggregator> groups;
+    QStringList passthrough;
+    QStringList groupOrder;
+
+    for(QStringList::const_iterator line = _lines.constBegin(); line != _lines.constEnd(); ++line) {
+        QString route = line->simplified();
+        bool isPushed = route.startsWith("push ");
+        if(isPushed) {
+            route = route.mid(5);
+            route.remove('"');
+        }
+        QStringList fields = route.split(' ');
+        bool ok = fields.size() >= 2 && fields.at(0) == "route";
+        quint32 network = 0;
+        int prefixLength = 32;
+        if(ok) {
+            network = IpPool::fromString(fields.at(1), &ok);
+        }
+        if(ok && fields.size() >= 3) {
+            ok = IpPool::parseSubnet(fields.at(1) + " " + fields.at(2), &network, &prefixLength);
+        }
+        if(!ok) {
+            passthrough << *line;
+            continue;
+        }
+        // the key starts with 'p' for pushed routes, followed by gateway and metric
+        QString key = (isPushed ? "p" : "r") + QStringList(fields.mid(3)).join(" ");
+        if(!groups.contains(key)) {
+            groupOrder << key;
+        }
+        groups[key].add(network & IpPool::netmask(prefixLength), prefixLength);
+    }
+
+    for(QStringList::const_iterator exclusion = _exclusions.constBegin(); exclusion != _exclusions.constEnd(); ++exclusion) {
+        quint32 network;
+        int prefixLength;
+        if(!IpPool::parseSubnet(*exclusion, &network, &prefixLength)) {
+            bool ok;
+            network = IpPool::fromString(*exclusion, &ok);
+            prefixLength = 32;
+            if(!ok) {
+                continue;
+            }
+        }
+        QMap<QString, RouteAggregator>::iterator group = groups.begin();
+        while (group != groups.end()) {
+            group->exclude(network & IpPool::netmask(prefixLength), prefixLength);
+            ++group;
+        }
+    }
+
+    QStringList result;
+    for(QStringList::const_iterator key = groupOrder.constBegin(); key != groupOrder.constEnd(); ++key) {
+        bool pushed = key->startsWith('p');
+        QString suffix = key->mid(1);
+        QList<Prefix> merged = groups.value(*key).prefixes();
+        for(QList<Prefix>::const_iterator prefix = merged.constBegin(); prefix != merged.constEnd(); ++prefix) {
+            QString route = "route " + IpPool::toString(prefix->first) + " " +
+                    IpPool::toString(IpPool::netmask(prefix->second));
+            if(!suffix.isEmpty()) {
+                route += " " + suffix;
+            }
+            result << (pushed ? "push \"" + route + "\"" : route);
+        }
+    }
+    return result + passthrough;
+}
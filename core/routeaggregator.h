@@ -0,0 +1,58 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef ROUTEAGGREGATOR_H
+#define ROUTEAGGREGATOR_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Binary radix tree over IPv4 prefixes. Adjacent and overlapping networks
+// collapse into their common parent and excluded networks are carved out,
+// so prefixes() is the smallest set of CIDRs covering exactly
+// (added - excluded).
+class RouteAggregator
+{
+public:
+    typedef QPair<quint32, int> Prefix;     // network, prefix length
+
+    RouteAggregator();
+
+    void add(quint32 _network, int _prefixLength);
+    void exclude(quint32 _network, int _prefixLength);
+    QList<Prefix> prefixes() const;
+
+    // rewrites "route" or "push \"route ...\"" lines; lines that are not
+    // plain IPv4 routes are passed through untouched. Routes are only merged
+    // when their gateway and metric agree.
+    static QStringList aggregateDirectives(const QStringList _lines, const QStringList _exclusions);
+
+private:
+    struct Node {
+        int child[2];
+        bool full;
+    };
+
+    int newNode();
+    int childOf(int _node, int _bit);
+    bool compact(int _node);
+    void collect(int _node, quint32 _network, int _depth, QList<Prefix> &_out) const;
+
+    QVector<Node> nodes;
+};
+
+#endif // ROUTEAGGREGATOR_H
@@ -0,0 +1,120 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "statistics.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtAlgorithms>
+
+Statistics *Statistics::instance() {
+    static Statistics registry;
+    return &registry;
+}
+
+Statistics::~Statistics() {
+    qDeleteAll(metrics);
+}
+
+Statistics::Metric *Statistics::metric(const QString _name, Kind _kind) {
+    QMutexLocker locker(&lock);
+    Metric *&entry = metrics[_name];
+    if(!entry) {
+        entry = new Metric(_kind);
+    }
+    return entry;
+}
+
+void Statistics::addTiming(const QString _name, qint64 _nsecs, qint64 _units) {
+    metric(_name, Timing)->addTiming(_nsecs, _units);
+}
+
+void Statistics::increment(const QString _name, qint64 _by) {
+    metric(_name, Counter)->increment(_by);
+}
+
+void Statistics::setGauge(const QString _name, qint64 _value) {
+    metric(_name, Gauge)->setGauge(_value);
+}
+
+void Statistics::reset() {
+    // handles are kept by their users, only the values start over
+    QMutexLocker locker(&lock);
+    for(QMap<QString, Metric *>::const_iterator i = metrics.constBegin(); i != metrics.constEnd(); ++i) {
+        i.value()->count.store(0);
+        i.value()->total.store(0);
+        i.value()->units.store(0);
+    }
+}
+
+QByteArray Statistics::toJson() const {
+    QMutexLocker locker(&lock);
+    QJsonObject root;
+    QMap<QString, Metric *>::const_iterator i = metrics.constBegin();
+    while (i != metrics.constEnd()) {
+        const qint64 count = i.value()->count.load();
+        const qint64 total = i.value()->total.load();
+        const qint64 units = i.value()->units.load();
+        if(i.value()->kind != Gauge && count == 0) {
+            // registered but not used since start or the last reset
+            ++i;
+            continue;
+        }
+        if(i.value()->kind == Timing) {
+            QJsonObject timing;
+            timing.insert("count", double(count));
+            timing.insert("total_ms", total / 1e6);
+            timing.insert("avg_us", count ? total / 1e3 / count : 0.0);
+            if(units > 0) {
+                timing.insert("units", double(units));
+                timing.insert("units_per_sec", total ? units * 1e9 / total : 0.0);
+            }
+            root.insert(i.key(), timing);
+        }
+        else {
+            root.insert(i.key(), double(count));
+        }
+        ++i;
+    }
+    return QJsonDocument(root).toJson();
+}
+
+QString Statistics::toText() const {
+    QMutexLocker locker(&lock);
+    QString text;
+    QMap<QString, Metric *>::const_iterator i = metrics.constBegin();
+    while (i != metrics.constEnd()) {
+        const qint64 count = i.value()->count.load();
+        const qint64 total = i.value()->total.load();
+        const qint64 units = i.value()->units.load();
+        if(i.value()->kind != Gauge && count == 0) {
+            // registered but not used since start or the last reset
+            ++i;
+            continue;
+        }
+        if(i.value()->kind == Timing) {
+            text += QString("%1: %2 x, avg %3 us").arg(i.key()).arg(count)
+                    .arg(count ? total / 1e3 / count : 0.0, 0, 'f', 1);
+            if(units > 0 && total > 0) {
+                text += QString(", %1 /s").arg(units * 1e9 / total, 0, 'f', 0);
+            }
+            text += "\n";
+        }
+        else {
+            text += QString("%1: %2\n").arg(i.key()).arg(count);
+        }
+        ++i;
+    }
+    return text;
+}
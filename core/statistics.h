@@ -0,0 +1,96 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+
+// Process wide metrics registry. Timings keep a count, the total time and an
+// optional number of processed units (e.g. lines), counters only a count and
+// gauges the last value set. Safe to use from any thread.
+//
+// Looking a metric up by name takes the registry lock. Code that runs per
+// parse or edit registers its metric once, usually into a function local
+// static, and updates the returned handle, which only uses atomics, so
+// documents on different threads never wait for each other.
+class Statistics
+{
+public:
+    enum Kind { Timing, Counter, Gauge };
+
+    class Metric
+    {
+    public:
+        void addTiming(qint64 _nsecs, qint64 _units = 0) {
+            count.fetchAndAddRelaxed(1);
+            total.fetchAndAddRelaxed(_nsecs);
+            units.fetchAndAddRelaxed(_units);
+        }
+        void increment(qint64 _by = 1) { count.fetchAndAddRelaxed(_by); }
+        void setGauge(qint64 _value) { count.store(_value); }
+
+    private:
+        friend class Statistics;
+        explicit Metric(Kind _kind) : kind(_kind), count(0), total(0), units(0) {}
+
+        Kind kind;
+        QAtomicInteger<qint64> count;
+        QAtomicInteger<qint64> total;
+        QAtomicInteger<qint64> units;
+    };
+
+    static Statistics *instance();
+
+    // the returned metric lives as long as the process
+    Metric *metric(const QString _name, Kind _kind);
+
+    void addTiming(const QString _name, qint64 _nsecs, qint64 _units = 0);
+    void increment(const QString _name, qint64 _by = 1);
+    void setGauge(const QString _name, qint64 _value);
+    void reset();
+
+    QByteArray toJson() const;
+    QString toText() const;
+
+private:
+    Statistics() {}
+    ~Statistics();
+
+    mutable QMutex lock;
+    QMap<QString, Metric *> metrics;
+};
+
+// Records the lifetime of the scope as one timing sample.
+class ScopedTiming
+{
+public:
+    explicit ScopedTiming(Statistics::Metric *_metric) : metric(_metric), units(0) { timer.start(); }
+    explicit ScopedTiming(const QString _name)
+        : metric(Statistics::instance()->metric(_name, Statistics::Timing)), units(0) { timer.start(); }
+    ~ScopedTiming() { metric->addTiming(timer.nsecsElapsed(), units); }
+    void setUnits(qint64 _units) { units = _units; }
+
+private:
+    Statistics::Metric *metric;
+    qint64 units;
+    QElapsedTimer timer;
+};
+
+#endif // STATISTICS_H
@@ -0,0 +1,342 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "statusmodel.h"
+#include "loganalyzer.h"
+#include "statistics.h"
+#include <QFile>
+#include <QFileInfo>
+#include <cstring>
+
+static quint64 lineKey(const QByteArray &_line) {
+    // two differently seeded hashes make a collision between an old and a
+    // changed line practically impossible
+    return (quint64(qHash(_line, 0)) << 32) | qHash(_line, 0x9e3779b9u);
+}
+
+StatusTableModel::StatusTableModel(QObject *parent)
+    : QAbstractTableModel(parent), generation(0), fileVersion(0), changed(0), lastSize(-1) {}
+
+int StatusTableModel::version() const {
+    return fileVersion;
+}
+
+int StatusTableModel::changedLastRefresh() const {
+    return changed;
+}
+
+QString StatusTableModel::errorString() const {
+    return error;
+}
+
+void StatusTableModel::setKnownProfiles(const QSet<QString> _names) {
+    knownProfiles = _names;
+    if(!clients.isEmpty()) {
+        emit dataChanged(index(0, Profile), index(clients.size() - 1, Profile));
+    }
+}
+
+void StatusTableModel::parseHeader(const QList<QByteArray> &_fields) {
+    // HEADER,CLIENT_LIST,Common Name,Real Address,...
+    clientColumns.clear();
+    for(int i = 2; i < _fields.size(); ++i) {
+        clientColumns.insert(QString::fromUtf8(_fields.at(i)), i - 2);
+    }
+}
+
+bool StatusTableModel::parseClient(const QList<QByteArray> &_fields, StatusClient *_client) const {
+    if(fileVersion == 1) {
+        // Common Name,Real Address,Bytes Received,Bytes Sent,Connected Since
+        if(_fields.size() < 5) {
+            return false;
+        }
+        _client->commonName = QString::fromUtf8(_fields.at(0));
+        _client->realAddress = QString::fromLatin1(_fields.at(1));
+        _client->bytesReceived = _fields.at(2).toLongLong();
+        _client->bytesSent = _fields.at(3).toLongLong();
+        _client->connectedSince = LogAnalyzer::parseTimestamp(_fields.at(4).constData(), _fields.at(4).size());
+        return true;
+    }
+
+    int name = clientColumns.value("Common Name", 0);
+    if(name >= _fields.size()) {
+        return false;
+    }
+    _client->commonName = QString::fromUtf8(_fields.at(name));
+    _client->realAddress = QString::fromLatin1(_fields.value(clientColumns.value("Real Address", 1)));
+    _client->virtualAddress = QString::fromLatin1(_fields.value(clientColumns.value("Virtual Address", 2)));
+    _client->bytesReceived = _fields.value(clientColumns.value("Bytes Received", 3)).toLongLong();
+    _client->bytesSent = _fields.value(clientColumns.value("Bytes Sent", 4)).toLongLong();
+    _client->connectedSince = _fields.value(clientColumns.value("Connected Since (time_t)", 6)).toLongLong();
+    _client->cipher = QString::fromLatin1(_fields.value(clientColumns.value("Data Channel Cipher", -1)));
+    return true;
+}
+
+void StatusTableModel::removeRow(int _row) {
+    // the last row moves into the gap, nothing else shifts
+    int last = clients.size() - 1;
+    rowOf.remove(clients.at(_row).commonName);
+    if(_row != last) {
+        clients[_row] = clients.at(last);
+        rowOf.insert(clients.at(_row).commonName, _row);
+        emit dataChanged(index(_row, 0), index(_row, ColumnCount - 1));
+    }
+    beginRemoveRows(QModelIndex(), last, last);
+    clients.removeLast();
+    endRemoveRows();
+}
+
+bool StatusTableModel::refresh(const QString _fileName) {
+    QFileInfo info(_fileName);
+    if(info.lastModified() == lastModified && info.size() == lastSize) {
+        changed = 0;
+        return false;
+    }
+    QFile file(_fileName);
+    if(!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    static Statistics::Metric *const refreshTiming = Statistics::instance()->metric("status_refresh", Statistics::Timing);
+    ScopedTiming timing(refreshTiming);
+    QByteArray contents = file.readAll();
+    lastModified = info.lastModified();
+    lastSize = info.size();
+
+    int detected = contents.startsWith("OpenVPN CLIENT LIST") ? 1
+                 : contents.startsWith("TITLE\t") ? 3
+                 : contents.startsWith("TITLE,") ? 2 : 0;
+    if(detected == 0) {
+        // OpenVPN may be half way through rewriting it, try again next time
+        error = tr("%1 is not an OpenVPN status file.").arg(_fileName);
+        lastSize = -1;
+        return false;
+    }
+    if(detected != fileVersion) {
+        knownLines.clear();
+        fileVersion = detected;
+    }
+    error.clear();
+    char separator = fileVersion == 3 ? '\t' : ',';
+
+    ++generation;
+    changed = 0;
+    int firstUpdated = clients.size();
+    int lastUpdated = -1;
+    QVector<StatusClient> added;
+    QHash<QString, int> addedRow;
+    Section section = None;
+
+    const char *data = contents.constData();
+    const char *end = data + contents.size();
+    qint64 lineCount = 0;
+    for(const char *start = data; start < end; ) {
+        const char *newline = static_cast<const char *>(memchr(start, '\n', end - start));
+        const char *lineEnd = newline ? newline : end;
+        int length = int(lineEnd - start);
+        if(length > 0 && start[length - 1] == '\r') {
+            --length;
+        }
+        QByteArray line = QByteArray::fromRawData(start, length);
+        start = lineEnd + 1;
+        ++lineCount;
+
+        if(fileVersion == 1) {
+            if(line == "OpenVPN CLIENT LIST") {
+                section = ClientList;
+                continue;
+            }
+            if(line == "ROUTING TABLE") {
+                section = RoutingTable;
+                continue;
+            }
+            if(line == "GLOBAL STATS" || line == "END") {
+                section = None;
+                continue;
+            }
+        }
+
+        quint64 key = lineKey(line);
+        QHash<quint64, KnownLine>::iterator known = knownLines.find(key);
+        if(known != knownLines.end()) {
+            known->seen = generation;
+            if(!known->owner.isEmpty()) {
+                int row = rowOf.value(known->owner, -1);
+                if(row >= 0) {
+                    clients[row].seen = generation;
+                }
+            }
+            continue;
+        }
+
+        QList<QByteArray> fields = QByteArray(line.constData(), line.size()).split(separator);
+        QString owner;
+        StatusClient client;
+        client.bytesReceived = 0;
+        client.bytesSent = 0;
+        client.connectedSince = -1;
+        client.seen = generation;
+        bool isClient = false;
+
+        if(fileVersion == 1) {
+            if(section == ClientList && !line.startsWith("Updated,") && !line.startsWith("Common Name,")) {
+                isClient = parseClient(fields, &client);
+            }
+            else if(section == RoutingTable && fields.size() >= 2 && !line.startsWith("Virtual Address,")) {
+                // Virtual Address,Common Name,Real Address,Last Ref
+                QString name = QString::fromUtf8(fields.at(1));
+                int row = rowOf.value(name, -1);
+                if(row >= 0) {
+                    clients[row].virtualAddress = QString::fromLatin1(fields.at(0));
+                    firstUpdated = qMin(firstUpdated, row);
+                    lastUpdated = qMax(lastUpdated, row);
+                }
+                else if(addedRow.contains(name)) {
+                    added[addedRow.value(name)].virtualAddress = QString::fromLatin1(fields.at(0));
+                }
+            }
+        }
+        else if(fields.value(0) == "HEADER" && fields.value(1) == "CLIENT_LIST") {
+            if(line != clientHeader) {
+                // new columns, every client line has to be read again
+                clientHeader = QByteArray(line.constData(), line.size());
+                parseHeader(fields);
+                knownLines.clear();
+            }
+        }
+        else if(fields.value(0) == "CLIENT_LIST") {
+            fields.removeFirst();
+            isClient = parseClient(fields, &client);
+        }
+
+        if(isClient) {
+            owner = client.commonName;
+            int row = rowOf.value(client.commonName, -1);
+            if(row >= 0) {
+                if(client.virtualAddress.isEmpty()) {
+                    client.virtualAddress = clients.at(row).virtualAddress;
+                }
+                clients[row] = client;
+                firstUpdated = qMin(firstUpdated, row);
+                lastUpdated = qMax(lastUpdated, row);
+            }
+            else if(addedRow.contains(client.commonName)) {
+                added[addedRow.value(client.commonName)] = client;
+            }
+            else {
+                addedRow.insert(client.commonName, added.size());
+                added << client;
+            }
+            ++changed;
+        }
+        KnownLine &entry = knownLines[key];
+        entry.owner = owner;
+        entry.seen = generation;
+    }
+    timing.setUnits(lineCount);
+
+    if(lastUpdated >= firstUpdated) {
+        emit dataChanged(index(firstUpdated, 0), index(lastUpdated, ColumnCount - 1));
+    }
+    for(int row = clients.size() - 1; row >= 0; --row) {
+        if(clients.at(row).seen != generation) {
+            removeRow(row);
+            ++changed;
+        }
+    }
+    if(!added.isEmpty()) {
+        beginInsertRows(QModelIndex(), clients.size(), clients.size() + added.size() - 1);
+        for(QVector<StatusClient>::const_iterator client = added.constBegin(); client != added.constEnd(); ++client) {
+            rowOf.insert(client->commonName, clients.size());
+            clients << *client;
+        }
+        endInsertRows();
+    }
+    // lines OpenVPN no longer writes
+    QHash<quint64, KnownLine>::iterator known = knownLines.begin();
+    while (known != knownLines.end()) {
+        if(known->seen != generation) {
+            known = knownLines.erase(known);
+        }
+        else {
+            ++known;
+        }
+    }
+    return true;
+}
+
+int StatusTableModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : clients.size();
+}
+
+int StatusTableModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : int(ColumnCount);
+}
+
+QVariant StatusTableModel::data(const QModelIndex &index, int role) const {
+    if(!index.isValid() || index.row() >= clients.size() || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    const StatusClient &client = clients.at(index.row());
+    switch(index.column()) {
+    case CommonName:
+        return client.commonName;
+    case RealAddress:
+        return client.realAddress;
+    case VirtualAddress:
+        return client.virtualAddress;
+    case BytesReceived:
+        return client.bytesReceived;
+    case BytesSent:
+        return client.bytesSent;
+    case ConnectedSince:
+        return client.connectedSince >= 0
+                ? QVariant(QDateTime::fromMSecsSinceEpoch(client.connectedSince * 1000).toLocalTime())
+                : QVariant();
+    case Cipher:
+        return client.cipher;
+    case Profile:
+        if(knownProfiles.isEmpty()) {
+            return QVariant();
+        }
+        return knownProfiles.contains(client.commonName) ? tr("yes") : tr("missing");
+    }
+    return QVariant();
+}
+
+QVariant StatusTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if(orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    switch(section) {
+    case CommonName:
+        return tr("Common Name");
+    case RealAddress:
+        return tr("Real Address");
+    case VirtualAddress:
+        return tr("Virtual Address");
+    case BytesReceived:
+        return tr("Bytes Received");
+    case BytesSent:
+        return tr("Bytes Sent");
+    case ConnectedSince:
+        return tr("Connected Since");
+    case Cipher:
+        return tr("Cipher");
+    case Profile:
+        return tr("Profile");
+    }
+    return QVariant();
+}
@@ -0,0 +1,95 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef STATUSMODEL_H
+#define STATUSMODEL_H
+
+#include <QAbstractTableModel>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+// One connected client of a server status file.
+struct StatusClient
+{
+    QString commonName;
+    QString realAddress;
+    QString virtualAddress;
+    qint64 bytesReceived;
+    qint64 bytesSent;
+    qint64 connectedSince;      // seconds since the epoch, UTC
+    QString cipher;
+    uint seen;                  // refresh generation that last listed the client
+};
+
+// Client table of an OpenVPN server "status" file, versions 1 to 3.
+// OpenVPN rewrites the whole file every interval, but most lines stay the
+// same: every line is hashed and only lines that were not in the previous
+// version are split and parsed, so a refresh costs a hash per line plus
+// real work per changed client. The table of known lines is updated in
+// place, only added and dropped lines touch its nodes. Rows are keyed by
+// common name.
+class StatusTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column { CommonName, RealAddress, VirtualAddress, BytesReceived, BytesSent,
+                  ConnectedSince, Cipher, Profile, ColumnCount };
+
+    explicit StatusTableModel(QObject *parent = 0);
+
+    // false when the file is unchanged or unreadable
+    bool refresh(const QString _fileName);
+    void setKnownProfiles(const QSet<QString> _names);
+
+    int version() const;
+    int changedLastRefresh() const;
+    QString errorString() const;
+
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    virtual QVariant headerData(int section, Qt::Orientation orientation,
+                                int role = Qt::DisplayRole) const;
+
+private:
+    enum Section { None, ClientList, RoutingTable };
+
+    struct KnownLine {
+        QString owner;          // common name, empty for other lines
+        uint seen;              // refresh generation that last read the line
+    };
+
+    void parseHeader(const QList<QByteArray> &_fields);
+    bool parseClient(const QList<QByteArray> &_fields, StatusClient *_client) const;
+    void removeRow(int _row);
+
+    QVector<StatusClient> clients;
+    QHash<QString, int> rowOf;
+    QHash<quint64, KnownLine> knownLines;   // by line hash
+    QSet<QString> knownProfiles;
+    QHash<QString, int> clientColumns;      // from the HEADER,CLIENT_LIST line
+    QByteArray clientHeader;
+    uint generation;
+    int fileVersion;
+    int changed;
+    QDateTime lastModified;
+    qint64 lastSize;
+    QString error;
+};
+
+#endif // STATUSMODEL_H
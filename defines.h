@@ -19,6 +19,8 @@
 #define GITHUBLINK "https://github.com/vgezer/openvpnui"
 #define APPNAME "OpenVPN UI"
 #define VERSION "1.0a"
+#define CONFIGHEADER "# Config created by OpenVPN UI #\n" \
+                     "# https://github.com/vgezer/openvpnui #\n"
 
 #endif // DEFINES_H
 
@@ -0,0 +1,224 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "configdocument.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QTextStream>
+#include <cstdio>
+#include <cstdlib>
+
+// a failed property aborts, libFuzzer and AFL both report that as a crash
+#define FUZZ_CHECK(_condition) \
+    do { \
+        if(!(_condition)) { \
+            fprintf(stderr, "property failed: %s (%s:%d)\n", #_condition, __FILE__, __LINE__); \
+            abort(); \
+        } \
+    } while (0)
+
+static const char *const directives[] = {"dev", "proto", "remote", "cipher", "verb", "tun-mtu",
+                                         "server", "keepalive", "client", "persist-key", "comp-lzo"};
+static const char *const tags[] = {"ca", "cert", "key"};
+
+static void checkRoundTrip(const ConfigDocument &_document) {
+    // parse(render(d)) is a fixed point: same text, same directives
+    ConfigDocument again;
+    again.parse(_document.render());
+    FUZZ_CHECK(again.getFileContents() == _document.getFileContents());
+    for(size_t i = 0; i < sizeof(directives) / sizeof(directives[0]); ++i) {
+        QString directive = QString::fromLatin1(directives[i]);
+        FUZZ_CHECK(again.getConfigValue(directive) == _document.getConfigValue(directive));
+        FUZZ_CHECK(again.isConfigActive(directive) == _document.isConfigActive(directive));
+    }
+    for(size_t i = 0; i < sizeof(tags) / sizeof(tags[0]); ++i) {
+        QString tag = QString::fromLatin1(tags[i]);
+        FUZZ_CHECK(again.isCaKeyActive(tag) == _document.isCaKeyActive(tag));
+    }
+    FUZZ_CHECK(_document.render().startsWith(ConfigDocument().render()));
+    FUZZ_CHECK(_document.inlineBlockBytes() >= 0 &&
+               _document.inlineBlockBytes() <= _document.getFileContents().size() * qint64(sizeof(QChar)));
+}
+
+static void checkRemoveLine(const ConfigDocument &_document, const QString _line) {
+    // either nothing happens or exactly one whole line disappears
+    ConfigDocument edited = _document;
+    QString before = edited.getFileContents();
+    edited.removeLine(_line);
+    QString after = edited.getFileContents();
+    if(after == before) {
+        return;
+    }
+    int removed = before.size() - after.size();
+    FUZZ_CHECK(removed > 0);
+    int start = 0;
+    while (start < after.size() && before.at(start) == after.at(start)) {
+        ++start;
+    }
+    // an identical neighbour line can shift the first difference forward
+    while (start > 0 && before.at(start - 1) != '\n') {
+        --start;
+    }
+    FUZZ_CHECK(before.left(start) == after.left(start));
+    FUZZ_CHECK(before.mid(start + removed) == after.mid(start));
+    QString line = before.mid(start, removed);
+    FUZZ_CHECK(line.indexOf('\n') < 0 || line.indexOf('\n') == line.size() - 1);
+}
+
+static void checkEdits(const ConfigDocument &_document) {
+    QString before = _document.getFileContents();
+
+    QStringList lines = before.split('\n', QString::SkipEmptyParts);
+    for(int i = 0; i < lines.size() && i < 8; ++i) {
+        checkRemoveLine(_document, lines.at(i));
+        checkRemoveLine(_document, lines.at(i).section(' ', 0, 0));
+    }
+
+    ConfigDocument edited = _document;
+    edited.addLine("verb 4");
+    FUZZ_CHECK(edited.getFileContents().endsWith("verb 4\n"));
+    FUZZ_CHECK(edited.getConfigValue("verb") == "4");
+
+    edited = _document;
+    edited.removeLinesStartingWith("route ");
+    FUZZ_CHECK(edited.linesStartingWith("route ").isEmpty());
+
+    // a block that is not there, or not closed, leaves the text alone
+    edited = _document;
+    int tagStart = before.indexOf("<ca>");
+    bool complete = tagStart >= 0 && before.indexOf("</ca>", tagStart + 4) >= 0;
+    edited.removeTags("ca");
+    FUZZ_CHECK(!edited.isCaKeyActive("ca"));
+    QString after = edited.getFileContents();
+    if(!complete) {
+        FUZZ_CHECK(after == before);
+    }
+    else {
+        int removed = before.size() - after.size();
+        QString block = before.mid(tagStart, removed);
+        FUZZ_CHECK(before.left(tagStart) == after.left(tagStart));
+        FUZZ_CHECK(before.mid(tagStart + removed) == after.mid(tagStart));
+        FUZZ_CHECK(block.startsWith("<ca>") && (block.endsWith("</ca>") || block.endsWith("</ca>\n")));
+    }
+
+    if(!before.contains("<cert>")) {
+        edited = _document;
+        FUZZ_CHECK(edited.addTags("cert", "MIIB"));
+        FUZZ_CHECK(edited.isCaKeyActive("cert"));
+        edited.removeTags("cert");
+        FUZZ_CHECK(edited.getFileContents() == before + "\n");
+    }
+
+    // whatever the edits did, the result still renders to a stable profile
+    ConfigDocument reparsed;
+    reparsed.parse(edited.render());
+    checkRoundTrip(reparsed);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *_data, size_t _size) {
+    if(_size > 1024 * 1024) {
+        return 0;
+    }
+    ConfigDocument document;
+    document.parse(QString::fromUtf8(reinterpret_cast<const char *>(_data), int(_size)));
+    checkRoundTrip(document);
+    checkEdits(document);
+    return 0;
+}
+
+#ifndef OPENVPNUI_LIBFUZZER
+
+// Replays files and corpus directories, e.g. "documentfuzzer corpus". Every
+// input has to finish within its budget: --budget-ms plus 1 ms per 4 KiB,
+// or the value listed for it in a budgets.txt ("<file> <ms>") next to it.
+// Inputs over budget fail the run, which catches quadratic behaviour that
+// libFuzzer's -timeout is far too coarse for.
+static bool replay(const QString &_fileName, qint64 _budget, QTextStream &_out) {
+    QFile file(_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        _out << _fileName << ": " << file.errorString() << "\n";
+        return false;
+    }
+    QByteArray data = file.readAll();
+    QElapsedTimer timer;
+    timer.start();
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(data.constData()), size_t(data.size()));
+    qint64 elapsed = timer.elapsed();
+    bool ok = elapsed <= _budget;
+    _out << QFileInfo(_fileName).fileName() << "\t" << data.size() << " bytes\t" << elapsed
+         << " ms / " << _budget << " ms" << (ok ? "" : "\tOVER BUDGET") << "\n";
+    return ok;
+}
+
+static QMap<QString, qint64> readBudgets(const QDir &_dir) {
+    QMap<QString, qint64> budgets;
+    QFile file(_dir.filePath("budgets.txt"));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            return budgets;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QStringList fields = in.readLine().split(' ', QString::SkipEmptyParts);
+        if(fields.size() == 2 && !fields.at(0).startsWith('#')) {
+            budgets.insert(fields.at(0), fields.at(1).toLongLong());
+        }
+    }
+    return budgets;
+}
+
+int main(int argc, char *argv[])
+{
+    QTextStream out(stdout);
+    qint64 baseBudget = 50;
+    QStringList inputs;
+    for(int i = 1; i < argc; ++i) {
+        QString arg = QString::fromLocal8Bit(argv[i]);
+        if(arg == "--budget-ms" && i + 1 < argc) {
+            baseBudget = QString::fromLocal8Bit(argv[++i]).toLongLong();
+        }
+        else {
+            inputs << arg;
+        }
+    }
+    if(inputs.isEmpty()) {
+        out << "usage: documentfuzzer [--budget-ms <ms>] <file or corpus dir>...\n";
+        return 2;
+    }
+
+    int failures = 0;
+    for(QStringList::const_iterator input = inputs.constBegin(); input != inputs.constEnd(); ++input) {
+        QFileInfo info(*input);
+        if(!info.isDir()) {
+            failures += replay(*input, baseBudget + info.size() / 4096, out) ? 0 : 1;
+            continue;
+        }
+        QDir dir(*input);
+        QMap<QString, qint64> budgets = readBudgets(dir);
+        QFileInfoList files = dir.entryInfoList(QDir::Files, QDir::Name);
+        for(QFileInfoList::const_iterator file = files.constBegin(); file != files.constEnd(); ++file) {
+            if(file->fileName() == "budgets.txt") {
+                continue;
+            }
+            qint64 budget = budgets.value(file->fileName(), baseBudget + file->size() / 4096);
+            failures += replay(file->absoluteFilePath(), budget, out) ? 0 : 1;
+        }
+    }
+    out << failures << " inputs failed\n";
+    return failures == 0 ? 0 : 1;
+}
+
+#endif // OPENVPNUI_LIBFUZZER
@@ -0,0 +1,23 @@
+# Fuzz target for the parse/edit/render cycle of ConfigDocument.
+#
+#   qmake CONFIG+=libfuzzer QMAKE_CXX=clang++ QMAKE_LINK=clang++ && make
+#   ./documentfuzzer -max_len=65536 corpus
+#
+# Without CONFIG+=libfuzzer the same binary replays files or directories
+# with a time budget per input (see README.md); built with afl-clang-fast++
+# it can be run as "afl-fuzz -i corpus -o findings -- ./documentfuzzer @@".
+TEMPLATE = app
+TARGET = documentfuzzer
+QT = core concurrent
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+include(../core/core.pri)
+
+SOURCES += documentfuzzer.cpp
+
+libfuzzer {
+    DEFINES += OPENVPNUI_LIBFUZZER
+    QMAKE_CXXFLAGS += -fsanitize=fuzzer,address,undefined
+    QMAKE_LFLAGS += -fsanitize=fuzzer,address,undefined
+}
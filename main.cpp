@@ -13,19 +13,232 @@
 //  limitations under the License. */
 
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QDebug>
+#include <QHostAddress>
 
+#include "defines.h"
 #include "vpngui.h"
 #include "configparser.h"
+#include "profileserver.h"
+#include "configdocument.h"
+#include "statistics.h"
+#include "canonicalizer.h"
+#include "loganalyzer.h"
+#include <QDirIterator>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+
+#ifdef Q_OS_UNIX
+#include <QSocketNotifier>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int signalPipe[2];
+
+static void quitOnSignal(int) {
+    // only async-signal-safe calls here, the event loop does the rest
+    char byte = 1;
+    ssize_t written = ::write(signalPipe[1], &byte, 1);
+    Q_UNUSED(written);
+}
+
+// SIGINT and SIGTERM leave the event loop like a normal exit, so --serve
+// still writes its --stats
+static void quitOnTermination(QCoreApplication &app) {
+    if(::socketpair(AF_UNIX, SOCK_STREAM, 0, signalPipe) != 0) {
+        return;
+    }
+    QSocketNotifier *notifier = new QSocketNotifier(signalPipe[0], QSocketNotifier::Read, &app);
+    QObject::connect(notifier, SIGNAL(activated(int)), &app, SLOT(quit()));
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = quitOnSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &action, 0);
+    sigaction(SIGTERM, &action, 0);
+}
+#endif
+
+// options that run without any window
+static bool isHeadless(int argc, char *argv[]) {
+    for(int i = 1; i < argc; ++i) {
+        if(qstrcmp(argv[i], "--serve") == 0 || qstrcmp(argv[i], "--render") == 0 ||
+                qstrcmp(argv[i], "--find-duplicates") == 0 || qstrcmp(argv[i], "--analyze-log") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int renderProfile(const QString _input, const QString _output) {
+    QFile in(_input);
+    if (!in.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qCritical() << in.errorString();
+        return 1;
+    }
+    ConfigDocument document;
+    document.parse(QTextStream(&in).readAll());
+
+    QString rendered = document.render();
+    if(!_output.isEmpty() && Canonicalizer::fileHash(_output) == Canonicalizer::canonicalHash(rendered)) {
+        // equivalent profile already there, keep the file untouched
+        return 0;
+    }
+
+    QFile out;
+    bool opened;
+    if(_output.isEmpty()) {
+        opened = out.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    }
+    else {
+        out.setFileName(_output);
+        opened = out.open(QIODevice::WriteOnly | QIODevice::Text);
+    }
+    if (!opened) {
+        qCritical() << out.errorString();
+        return 1;
+    }
+    ScopedTiming timing("save");
+    out.write(rendered.toUtf8());
+    return 0;
+}
+
+static int findDuplicates(const QString _dir) {
+    QStringList fileNames;
+    QDirIterator it(_dir, QStringList() << "*.ovpn" << "*.conf", QDir::Files,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        fileNames << it.next();
+    }
+
+    QMap<QByteArray, QStringList> groups = Canonicalizer::findDuplicates(fileNames);
+    QTextStream out(stdout);
+    QMap<QByteArray, QStringList>::const_iterator group = groups.constBegin();
+    while (group != groups.constEnd()) {
+        out << group.key().toHex() << "\n";
+        for(QStringList::const_iterator file = group->constBegin(); file != group->constEnd(); ++file) {
+            out << "  " << *file << "\n";
+        }
+        ++group;
+    }
+    out << fileNames.size() << " profiles, " << groups.size() << " groups of equivalent profiles\n";
+    return 0;
+}
+
+static int analyzeLog(const QString _log, const QString _profile) {
+    LogAnalyzer analyzer;
+    if(!analyzer.analyze(_log)) {
+        qCritical() << analyzer.errorString();
+        return 1;
+    }
+    QTextStream out(stdout);
+    out << analyzer.report() << "\n";
+
+    QFile profile(_profile);
+    if(!_profile.isEmpty() && profile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QStringList suggestions = analyzer.suggestions(QTextStream(&profile).readAll().split('\n'));
+        for(QStringList::const_iterator suggestion = suggestions.constBegin(); suggestion != suggestions.constEnd(); ++suggestion) {
+            out << "* " << *suggestion << "\n";
+        }
+    }
+    return 0;
+}
+
+static int runHeadless(QCoreApplication &app) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription(APPNAME);
+    parser.addHelpOption();
+    QCommandLineOption serveOption("serve", "Serve rendered profiles over HTTP on <port>.", "port");
+    QCommandLineOption listenOption("listen", "Address to listen on (default 127.0.0.1).",
+                                    "address", "127.0.0.1");
+    QCommandLineOption templateOption("template", "Profile template to render.", "file");
+    QCommandLineOption usersOption("users", "User list, one \"<name> [key=value ...]\" per line.",
+                                   "file");
+    QCommandLineOption renderOption("render", "Parse <file> and write the rendered profile.", "file");
+    QCommandLineOption outputOption("output", "Where --render writes to (default stdout).", "file");
+    QCommandLineOption duplicatesOption("find-duplicates",
+                                        "List equivalent profiles below <dir>.", "dir");
+    QCommandLineOption analyzeOption("analyze-log",
+                                     "Summarize an OpenVPN log, with hints for the --template profile.",
+                                     "file");
+    QCommandLineOption statsOption("stats", "Write the runtime statistics as JSON to stderr when done.");
+    parser.addOption(serveOption);
+    parser.addOption(listenOption);
+    parser.addOption(templateOption);
+    parser.addOption(usersOption);
+    parser.addOption(renderOption);
+    parser.addOption(outputOption);
+    parser.addOption(duplicatesOption);
+    parser.addOption(analyzeOption);
+    parser.addOption(statsOption);
+    parser.process(app);
+
+    if(parser.isSet(renderOption) || parser.isSet(duplicatesOption) || parser.isSet(analyzeOption)) {
+        int result;
+        if(parser.isSet(renderOption)) {
+            result = renderProfile(parser.value(renderOption), parser.value(outputOption));
+        }
+        else if(parser.isSet(duplicatesOption)) {
+            result = findDuplicates(parser.value(duplicatesOption));
+        }
+        else {
+            result = analyzeLog(parser.value(analyzeOption), parser.value(templateOption));
+        }
+        if(parser.isSet(statsOption)) {
+            QTextStream(stderr) << Statistics::instance()->toJson();
+        }
+        return result;
+    }
+
+    ProfileServer server;
+    if(!parser.isSet(templateOption) || !parser.isSet(usersOption)) {
+        qCritical() << "--serve needs --template and --users";
+        return 1;
+    }
+    bool portOk;
+    uint port = parser.value(serveOption).toUInt(&portOk);
+    if(!portOk || port == 0 || port > 65535) {
+        qCritical() << "--serve needs a port between 1 and 65535, not" << parser.value(serveOption);
+        return 1;
+    }
+    if(!server.setTemplateFile(parser.value(templateOption)) ||
+            !server.setUserListFile(parser.value(usersOption)) ||
+            !server.listen(QHostAddress(parser.value(listenOption)),
+                           quint16(port))) {
+        qCritical() << server.errorString();
+        return 1;
+    }
+#ifdef Q_OS_UNIX
+    quitOnTermination(app);
+#endif
+    int result = app.exec();
+    if(parser.isSet(statsOption)) {
+        QTextStream(stderr) << Statistics::instance()->toJson();
+    }
+    return result;
+}
 
 int main(int argc, char *argv[])
 {
+    if(isHeadless(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return runHeadless(app);
+    }
+
     QApplication app(argc, argv);
 
     ConfigParser *configParser = new ConfigParser();
 
     VPNGui gui(configParser);
     gui.show();
+    // offer what a crash left behind once the window is up
+    QTimer::singleShot(0, configParser, SLOT(recoverAutosave()));
 
     return app.exec();
 }
@@ -0,0 +1,172 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "managementclient.h"
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QTimer>
+
+ManagementClient::ManagementClient(QObject *parent)
+    : QObject(parent), tcpSocket(0), localSocket(0), device(0), interval(1)
+{
+    clientTimer = new QTimer(this);
+    clientTimer->setSingleShot(true);
+    clientTimer->setInterval(0);
+    connect(clientTimer, SIGNAL(timeout()), this, SLOT(emitClientCounters()));
+}
+
+void ManagementClient::connectTo(const QString _address, const QString _password, int _interval) {
+    disconnectFromServer();
+    password = _password;
+    interval = _interval;
+    clientCounters.clear();
+
+    // "host:port" for TCP, anything else is the path of a Unix socket
+    int colon = _address.lastIndexOf(':');
+    bool isTcp = colon > 0 && !_address.contains('/') && _address.mid(colon + 1).toUShort() > 0;
+    if(isTcp) {
+        tcpSocket = new QTcpSocket(this);
+        device = tcpSocket;
+        connect(tcpSocket, SIGNAL(connected()), this, SLOT(socketConnected()));
+        connect(tcpSocket, SIGNAL(disconnected()), this, SIGNAL(disconnected()));
+        connect(tcpSocket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(socketError()));
+        connect(tcpSocket, SIGNAL(readyRead()), this, SLOT(readLines()));
+        tcpSocket->connectToHost(_address.left(colon), _address.mid(colon + 1).toUShort());
+    }
+    else {
+        localSocket = new QLocalSocket(this);
+        device = localSocket;
+        connect(localSocket, SIGNAL(connected()), this, SLOT(socketConnected()));
+        connect(localSocket, SIGNAL(disconnected()), this, SIGNAL(disconnected()));
+        connect(localSocket, SIGNAL(error(QLocalSocket::LocalSocketError)), this, SLOT(socketError()));
+        connect(localSocket, SIGNAL(readyRead()), this, SLOT(readLines()));
+        localSocket->connectToServer(_address);
+    }
+}
+
+void ManagementClient::disconnectFromServer() {
+    if(tcpSocket) {
+        tcpSocket->disconnect(this);
+        tcpSocket->abort();
+        tcpSocket->deleteLater();
+        tcpSocket = 0;
+    }
+    if(localSocket) {
+        localSocket->disconnect(this);
+        localSocket->abort();
+        localSocket->deleteLater();
+        localSocket = 0;
+    }
+    clientTimer->stop();
+    device = 0;
+}
+
+bool ManagementClient::isConnected() const {
+    return (tcpSocket && tcpSocket->state() == QAbstractSocket::ConnectedState) ||
+           (localSocket && localSocket->state() == QLocalSocket::ConnectedState);
+}
+
+void ManagementClient::send(const QByteArray &_command) {
+    if(device) {
+        device->write(_command + "\n");
+    }
+}
+
+void ManagementClient::socketConnected() {
+    // notifications are enabled once the banner arrives, after the
+    // password if the interface asks for one
+    emit connected();
+}
+
+void ManagementClient::subscribe() {
+    send("state on");
+    send("state");
+    send("bytecount " + QByteArray::number(interval));
+}
+
+void ManagementClient::socketError() {
+    emit errorOccurred(device ? device->errorString() : QString());
+}
+
+void ManagementClient::readLines() {
+    while(device && device->canReadLine()) {
+        QByteArray line = device->readLine().trimmed();
+        if(!line.isEmpty()) {
+            handleLine(line);
+        }
+    }
+    // the password prompt is not terminated by a line break
+    if(device && device->peek(15) == "ENTER PASSWORD:") {
+        device->read(15);
+        send(password.toUtf8());
+    }
+}
+
+void ManagementClient::handleLine(const QByteArray &_line) {
+    if(_line.startsWith(">INFO:")) {
+        subscribe();
+    }
+    else if(_line.startsWith("ERROR: bad password")) {
+        emit errorOccurred(tr("The management interface rejected the password."));
+    }
+    else if(_line.startsWith(">BYTECOUNT:")) {
+        QList<QByteArray> fields = _line.mid(11).split(',');
+        if(fields.size() >= 2) {
+            emit byteCount(fields.at(0).toLongLong(), fields.at(1).toLongLong());
+        }
+    }
+    else if(_line.startsWith(">BYTECOUNT_CLI:")) {
+        QList<QByteArray> fields = _line.mid(15).split(',');
+        if(fields.size() >= 3) {
+            clientCounters.insert(fields.at(0), qMakePair(fields.at(1).toLongLong(),
+                                                          fields.at(2).toLongLong()));
+            // one line per client arrives each interval, summing after
+            // every line would give a sample per client and round
+            if(!clientTimer->isActive()) {
+                clientTimer->start();
+            }
+        }
+    }
+    else if(_line.startsWith(">CLIENT:DISCONNECT,")) {
+        clientCounters.remove(_line.mid(19).split(',').value(0));
+    }
+    else if(_line.startsWith(">STATE:") || (_line.at(0) >= '0' && _line.at(0) <= '9' && _line.count(',') >= 2)) {
+        // ">STATE:<time>,<state>,<detail>,..." or the reply to "state"
+        QList<QByteArray> fields = _line.mid(_line.startsWith('>') ? 7 : 0).split(',');
+        QString state = QString::fromLatin1(fields.value(1));
+        if(state == "CONNECTED") {
+            if(setupTimer.isValid()) {
+                emit connectLatency(setupTimer.elapsed());
+                setupTimer.invalidate();
+            }
+        }
+        else if(!setupTimer.isValid() && state != "EXITING") {
+            setupTimer.start();
+        }
+        emit stateChanged(state, QString::fromUtf8(fields.value(2)));
+    }
+}
+
+void ManagementClient::emitClientCounters() {
+    qint64 bytesIn = 0;
+    qint64 bytesOut = 0;
+    QHash<QByteArray, QPair<qint64, qint64> >::const_iterator client = clientCounters.constBegin();
+    while (client != clientCounters.constEnd()) {
+        bytesIn += client->first;
+        bytesOut += client->second;
+        ++client;
+    }
+    emit byteCount(bytesIn, bytesOut);
+}
@@ -0,0 +1,75 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef MANAGEMENTCLIENT_H
+#define MANAGEMENTCLIENT_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPair>
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+class QLocalSocket;
+class QTcpSocket;
+class QTimer;
+QT_END_NAMESPACE
+
+// Talks to the management interface of a running OpenVPN over TCP
+// ("host:port") or a Unix socket (a path). It enables real-time state and
+// bytecount notifications and turns them into signals. On a server the
+// per-client counters of one round are summed up into a single byteCount.
+class ManagementClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ManagementClient(QObject *parent = 0);
+
+    void connectTo(const QString _address, const QString _password = QString(), int _interval = 1);
+    void disconnectFromServer();
+    bool isConnected() const;
+
+signals:
+    void connected();
+    void disconnected();
+    void byteCount(qint64 _bytesIn, qint64 _bytesOut);
+    void stateChanged(const QString _state, const QString _detail);
+    // from leaving CONNECTED (or connecting) until CONNECTED again
+    void connectLatency(qint64 _milliseconds);
+    void errorOccurred(const QString _message);
+
+private slots:
+    void socketConnected();
+    void socketError();
+    void readLines();
+    void emitClientCounters();
+
+private:
+    void subscribe();
+    void send(const QByteArray &_command);
+    void handleLine(const QByteArray &_line);
+
+    QTcpSocket *tcpSocket;
+    QLocalSocket *localSocket;
+    QIODevice *device;
+    QString password;
+    int interval;
+    QElapsedTimer setupTimer;
+    QTimer *clientTimer;    // fires once the lines of a round are read
+    QHash<QByteArray, QPair<qint64, qint64> > clientCounters;
+};
+
+#endif // MANAGEMENTCLIENT_H
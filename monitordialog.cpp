@@ -0,0 +1,122 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#include <QtWidgets>
+
+#include "monitordialog.h"
+#include "throughputgraph.h"
+#include "managementclient.h"
+#include "configparser.h"
+
+MonitorDialog::MonitorDialog(ConfigParser *_configParser, QWidget *parent)
+    : QDialog(parent), m_pConfigParser(_configParser)
+{
+    m_pClient = new ManagementClient(this);
+    connect(m_pClient, SIGNAL(connected()), this, SLOT(clientConnected()));
+    connect(m_pClient, SIGNAL(disconnected()), this, SLOT(clientDisconnected()));
+    connect(m_pClient, SIGNAL(errorOccurred(QString)), this, SLOT(showError(QString)));
+    connect(m_pClient, SIGNAL(stateChanged(QString,QString)), this, SLOT(showState(QString,QString)));
+
+    m_pAddressLabel = new QLabel(tr("Management interface:"));
+    m_pAddressEdit = new QLineEdit;
+    m_pAddressEdit->setPlaceholderText(tr("127.0.0.1:7505 or /run/openvpn/client.sock"));
+    m_pPasswordLabel = new QLabel(tr("Password:"));
+    m_pPasswordEdit = new QLineEdit;
+    m_pPasswordEdit->setEchoMode(QLineEdit::Password);
+    m_pConnectBtn = new QPushButton(tr("Connect"));
+    connect(m_pConnectBtn, SIGNAL(released()), this, SLOT(toggleConnection()));
+
+    m_pStateLabel = new QLabel(tr("Not connected"));
+    m_pRateLabel = new QLabel;
+    m_pLatencyLabel = new QLabel;
+    m_pGraph = new ThroughputGraph;
+    connect(m_pClient, SIGNAL(connectLatency(qint64)), this, SLOT(showLatency(qint64)));
+    connect(m_pClient, SIGNAL(connectLatency(qint64)), m_pGraph, SLOT(addLatency(qint64)));
+    connect(m_pClient, SIGNAL(byteCount(qint64,qint64)), m_pGraph, SLOT(addByteCount(qint64,qint64)));
+    connect(m_pGraph, SIGNAL(sampleAdded()), this, SLOT(showRate()));
+
+    QFormLayout *formLayout = new QFormLayout;
+    formLayout->addRow(m_pAddressLabel, m_pAddressEdit);
+    formLayout->addRow(m_pPasswordLabel, m_pPasswordEdit);
+    formLayout->addRow(m_pConnectBtn);
+    formLayout->addRow(tr("State:"), m_pStateLabel);
+    formLayout->addRow(tr("Throughput:"), m_pRateLabel);
+    formLayout->addRow(tr("Last connection setup:"), m_pLatencyLabel);
+
+    QVBoxLayout *layout = new QVBoxLayout;
+    layout->addLayout(formLayout);
+    layout->addWidget(m_pGraph);
+    setLayout(layout);
+
+    setWindowTitle(tr("Live monitor"));
+}
+
+void MonitorDialog::showEvent(QShowEvent *event) {
+    // "management <host> <port>" or "management <socket> unix" of the profile
+    if(m_pAddressEdit->text().isEmpty()) {
+        QStringList management = m_pConfigParser->linesStartingWith("management ");
+        if(!management.isEmpty()) {
+            QStringList fields = management.first().simplified().split(' ');
+            if(fields.size() >= 3 && fields.at(2) == "unix") {
+                m_pAddressEdit->setText(fields.at(1));
+            }
+            else if(fields.size() >= 3) {
+                m_pAddressEdit->setText(fields.at(1) + ":" + fields.at(2));
+            }
+        }
+    }
+    QDialog::showEvent(event);
+}
+
+void MonitorDialog::toggleConnection() {
+    if(m_pClient->isConnected()) {
+        m_pClient->disconnectFromServer();
+        clientDisconnected();
+        return;
+    }
+    if(m_pAddressEdit->text().trimmed().isEmpty()) {
+        return;
+    }
+    m_pGraph->clear();
+    m_pStateLabel->setText(tr("Connecting..."));
+    m_pClient->connectTo(m_pAddressEdit->text().trimmed(), m_pPasswordEdit->text());
+}
+
+void MonitorDialog::clientConnected() {
+    m_pConnectBtn->setText(tr("Disconnect"));
+    m_pStateLabel->setText(tr("Connected"));
+}
+
+void MonitorDialog::clientDisconnected() {
+    m_pConnectBtn->setText(tr("Connect"));
+    m_pStateLabel->setText(tr("Not connected"));
+}
+
+void MonitorDialog::showError(const QString _message) {
+    m_pStateLabel->setText(_message);
+    m_pConnectBtn->setText(tr("Connect"));
+}
+
+void MonitorDialog::showState(const QString _state, const QString _detail) {
+    m_pStateLabel->setText(_detail.isEmpty() ? _state : _state + " (" + _detail + ")");
+}
+
+void MonitorDialog::showLatency(qint64 _milliseconds) {
+    m_pLatencyLabel->setText(tr("%1 ms").arg(_milliseconds));
+}
+
+void MonitorDialog::showRate() {
+    m_pRateLabel->setText(tr("in %1, out %2").arg(ThroughputGraph::formatRate(m_pGraph->inRate(0)))
+                                             .arg(ThroughputGraph::formatRate(m_pGraph->outRate(0))));
+}
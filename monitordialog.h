@@ -0,0 +1,68 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef MONITORDIALOG_H
+#define MONITORDIALOG_H
+
+#include <QDialog>
+
+class ConfigParser;
+class ManagementClient;
+class ThroughputGraph;
+
+QT_BEGIN_NAMESPACE
+class QLabel;
+class QLineEdit;
+class QPushButton;
+QT_END_NAMESPACE
+
+// Live view of a running OpenVPN through its management interface, meant
+// to stay open next to the profile while it is tuned.
+class MonitorDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit MonitorDialog(ConfigParser *_configParser, QWidget *parent = 0);
+
+public slots:
+    void toggleConnection();
+
+protected:
+    virtual void showEvent(QShowEvent *event);
+
+private slots:
+    void clientConnected();
+    void clientDisconnected();
+    void showError(const QString _message);
+    void showState(const QString _state, const QString _detail);
+    void showLatency(qint64 _milliseconds);
+    void showRate();
+
+private:
+    ConfigParser *m_pConfigParser;
+    ManagementClient *m_pClient;
+
+    QLabel *m_pAddressLabel;
+    QLineEdit *m_pAddressEdit;
+    QLabel *m_pPasswordLabel;
+    QLineEdit *m_pPasswordEdit;
+    QPushButton *m_pConnectBtn;
+    QLabel *m_pStateLabel;
+    QLabel *m_pRateLabel;
+    QLabel *m_pLatencyLabel;
+    ThroughputGraph *m_pGraph;
+};
+
+#endif // MONITORDIALOG_H
@@ -1,14 +1,46 @@
-QT += widgets
+QT += widgets concurrent network
 
 HEADERS     = \
     configparser.h \
     vpngui.h \
-    defines.h
+    defines.h \
+    backgroundtask.h \
+    profilearchiver.h \
+    profileserver.h \
+    pkiscanner.h \
+    cipherbenchmark.h \
+    compressionbenchmark.h \
+    managementclient.h \
+    monitordialog.h \
+    throughputgraph.h \
+    statusdialog.h
 SOURCES     = \
               main.cpp \
     configparser.cpp \
-    vpngui.cpp
+    vpngui.cpp \
+    profilearchiver.cpp \
+    profileserver.cpp \
+    pkiscanner.cpp \
+    cipherbenchmark.cpp \
+    compressionbenchmark.cpp \
+    managementclient.cpp \
+    monitordialog.cpp \
+    throughputgraph.cpp \
+    statusdialog.cpp
 
 CONFIG += c++11
+unix: CONFIG += link_pkgconfig
+unix: PKGCONFIG += libcrypto
+win32: LIBS += -llibcrypto
+# optional codecs for the compression benchmark
+unix:packagesExist(liblz4) {
+    PKGCONFIG += liblz4
+    DEFINES += OPENVPNUI_HAVE_LZ4
+}
+unix:packagesExist(lzo2) {
+    PKGCONFIG += lzo2
+    DEFINES += OPENVPNUI_HAVE_LZO
+}
+include(core/core.pri)
 win32:RC_ICONS += res/openvpn-gui.ico
 # install
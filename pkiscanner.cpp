@@ -0,0 +1,184 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "pkiscanner.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QtConcurrent>
+
+#include <openssl/bio.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+// encrypted keys cannot be paired without asking for each passphrase
+static int noPassphrase(char *, int, int, void *) {
+    return 0;
+}
+
+static QByteArray publicKeyFingerprint(EVP_PKEY *_key) {
+    unsigned char *der = 0;
+    int length = i2d_PUBKEY(_key, &der);
+    if(length <= 0) {
+        return QByteArray();
+    }
+    QByteArray fingerprint = QCryptographicHash::hash(
+                QByteArray::fromRawData(reinterpret_cast<const char *>(der), length),
+                QCryptographicHash::Sha256);
+    OPENSSL_free(der);
+    return fingerprint;
+}
+
+static QString bioContents(BIO *_bio) {
+    char *data = 0;
+    long length = BIO_get_mem_data(_bio, &data);
+    return QString::fromLatin1(data, int(length));
+}
+
+PkiScanner::ParsedFile PkiScanner::parseFile(const QString &_path) {
+    ParsedFile parsed;
+    parsed.path = _path;
+    parsed.isKey = _path.endsWith(".key");
+    parsed.serverOnly = false;
+
+    QFile file(_path);
+    if (!file.open(QIODevice::ReadOnly))
+            return parsed;
+    QByteArray contents = file.readAll();
+
+    BIO *in = BIO_new_mem_buf(contents.constData(), contents.size());
+    BIO *out = BIO_new(BIO_s_mem());
+    if(parsed.isKey) {
+        EVP_PKEY *key = PEM_read_bio_PrivateKey(in, 0, noPassphrase, 0);
+        if(key) {
+            parsed.fingerprint = publicKeyFingerprint(key);
+            parsed.pem = QString::fromLatin1(contents).trimmed() + "\n";
+            EVP_PKEY_free(key);
+        }
+    }
+    else {
+        // easy-rsa prepends a text dump to issued certificates, inline only
+        // the PEM block
+        X509 *certificate = PEM_read_bio_X509(in, 0, 0, 0);
+        if(certificate) {
+            parsed.fingerprint = publicKeyFingerprint(X509_get0_pubkey(certificate));
+            // extendedKeyUsage serverAuth only or nsCertType server, as
+            // easy-rsa's build-server-full issues them
+            parsed.serverOnly = X509_check_purpose(certificate, X509_PURPOSE_SSL_CLIENT, 0) != 1 &&
+                                X509_check_purpose(certificate, X509_PURPOSE_SSL_SERVER, 0) == 1;
+            if(PEM_write_bio_X509(out, certificate)) {
+                parsed.pem = bioContents(out);
+            }
+            X509_free(certificate);
+        }
+    }
+    BIO_free(out);
+    BIO_free(in);
+    return parsed;
+}
+
+bool PkiScanner::scan(const QString _pkiDir) {
+    ca.clear();
+    pairs.clear();
+    leftovers.clear();
+    error.clear();
+
+    QDir pki(_pkiDir);
+    if(!pki.exists("ca.crt")) {
+        error = QObject::tr("%1 does not contain ca.crt.").arg(_pkiDir);
+        return false;
+    }
+
+    QStringList paths;
+    paths << pki.filePath("ca.crt");
+    QDir issued(pki.filePath("issued"));
+    QStringList issuedNames = issued.entryList(QStringList("*.crt"), QDir::Files, QDir::Name);
+    for(QStringList::const_iterator name = issuedNames.constBegin(); name != issuedNames.constEnd(); ++name) {
+        paths << issued.filePath(*name);
+    }
+    QDir privateDir(pki.filePath("private"));
+    QStringList keyNames = privateDir.entryList(QStringList("*.key"), QDir::Files, QDir::Name);
+    for(QStringList::const_iterator name = keyNames.constBegin(); name != keyNames.constEnd(); ++name) {
+        paths << privateDir.filePath(*name);
+    }
+
+    QList<ParsedFile> parsed = QtConcurrent::blockingMapped(paths, &PkiScanner::parseFile);
+
+    const ParsedFile &caFile = parsed.first();
+    if(caFile.fingerprint.isEmpty()) {
+        error = QObject::tr("%1 is not a valid certificate.").arg(caFile.path);
+        return false;
+    }
+    ca = caFile.pem;
+
+    QHash<QByteArray, const ParsedFile *> keys;
+    for(int i = 1; i < parsed.size(); ++i) {
+        const ParsedFile &file = parsed.at(i);
+        if(file.fingerprint.isEmpty()) {
+            leftovers << file.path;
+        }
+        else if(file.isKey && file.fingerprint != caFile.fingerprint) {
+            keys.insert(file.fingerprint, &file);
+        }
+    }
+
+    for(int i = 1; i < parsed.size(); ++i) {
+        const ParsedFile &file = parsed.at(i);
+        if(file.isKey || file.fingerprint.isEmpty()) {
+            continue;
+        }
+        if(file.serverOnly) {
+            // its key stays in keys and is listed below as well
+            leftovers << file.path;
+            continue;
+        }
+        const ParsedFile *key = keys.take(file.fingerprint);
+        if(!key) {
+            leftovers << file.path;
+            continue;
+        }
+        PkiIdentity identity;
+        identity.name = QFileInfo(file.path).completeBaseName();
+        identity.certificate = file.pem;
+        identity.key = key->pem;
+        pairs << identity;
+    }
+    QHash<QByteArray, const ParsedFile *>::const_iterator key = keys.constBegin();
+    while (key != keys.constEnd()) {
+        leftovers << key.value()->path;
+        ++key;
+    }
+    return true;
+}
+
+QString PkiScanner::caCertificate() const {
+    return ca;
+}
+
+QList<PkiIdentity> PkiScanner::identities() const {
+    return pairs;
+}
+
+QStringList PkiScanner::unmatched() const {
+    return leftovers;
+}
+
+QString PkiScanner::errorString() const {
+    return error;
+}
@@ -0,0 +1,63 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef PKISCANNER_H
+#define PKISCANNER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// A user certificate with the private key that belongs to it.
+struct PkiIdentity
+{
+    QString name;
+    QString certificate;
+    QString key;
+};
+
+// Reads an easy-rsa style PKI tree (ca.crt, issued/*.crt, private/*.key).
+// All files are parsed in parallel and keys are paired with certificates by
+// the SHA-256 fingerprint of their public key, not by file name. Server
+// certificates never become identities, they and their keys are listed as
+// unmatched so a server key cannot end up in a client profile.
+class PkiScanner
+{
+public:
+    bool scan(const QString _pkiDir);
+
+    QString caCertificate() const;
+    QList<PkiIdentity> identities() const;
+    QStringList unmatched() const;
+    QString errorString() const;
+
+private:
+    struct ParsedFile {
+        QString path;
+        QString pem;
+        QByteArray fingerprint;
+        bool isKey;
+        bool serverOnly;    // cannot authenticate a TLS client
+    };
+
+    static ParsedFile parseFile(const QString &_path);
+
+    QString ca;
+    QList<PkiIdentity> pairs;
+    QStringList leftovers;
+    QString error;
+};
+
+#endif // PKISCANNER_H
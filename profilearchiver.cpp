@@ -0,0 +1,279 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "profilearchiver.h"
+#include <QDateTime>
+#include <QIODevice>
+#include <QThread>
+#include <QtConcurrent>
+#include <cstring>
+
+static void appendLE16(QByteArray &_out, quint16 _value) {
+    _out.append(char(_value & 0xff));
+    _out.append(char((_value >> 8) & 0xff));
+}
+
+static void appendLE32(QByteArray &_out, quint32 _value) {
+    appendLE16(_out, quint16(_value & 0xffff));
+    appendLE16(_out, quint16(_value >> 16));
+}
+
+static void putOctal(char *_field, int _width, quint64 _value) {
+    // width includes the terminating NUL
+    QByteArray octal = QByteArray::number(_value, 8).rightJustified(_width - 1, '0');
+    memcpy(_field, octal.constData(), _width - 1);
+    _field[_width - 1] = '\0';
+}
+
+ProfileArchiver::ProfileArchiver(QIODevice *_device, Format _format, int _maxPending)
+    : device(_device), format(_format), maxPending(_maxPending), entryCount(0), offset(0)
+{
+    if(maxPending <= 0) {
+        maxPending = QThread::idealThreadCount() * 4;
+    }
+
+    QDateTime now = QDateTime::currentDateTime();
+    mtime = now.toMSecsSinceEpoch() / 1000;
+    dosTime = quint16((now.time().hour() << 11) | (now.time().minute() << 5) | (now.time().second() / 2));
+    dosDate = quint16(((now.date().year() - 1980) << 9) | (now.date().month() << 5) | now.date().day());
+}
+
+ProfileArchiver::~ProfileArchiver() {
+    // never leave workers behind that still reference our data
+    while(!pending.isEmpty()) {
+        pending.dequeue().waitForFinished();
+    }
+}
+
+static bool fillCrcTable(quint32 *_table) {
+    for(quint32 i = 0; i < 256; ++i) {
+        quint32 c = i;
+        for(int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        _table[i] = c;
+    }
+    return true;
+}
+
+quint32 ProfileArchiver::crc32(const QByteArray &_data, quint32 _crc) {
+    // workers call this concurrently, the static init is thread-safe
+    static quint32 table[256];
+    static const bool tableReady = fillCrcTable(table);
+    Q_UNUSED(tableReady);
+
+    quint32 crc = _crc ^ 0xffffffffu;
+    const uchar *p = reinterpret_cast<const uchar *>(_data.constData());
+    for(int i = 0; i < _data.size(); ++i) {
+        crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffffu;
+}
+
+QByteArray ProfileArchiver::deflateRaw(const QByteArray &_data) {
+    // qCompress gives a 4 byte length, a 2 byte zlib header, the deflate
+    // stream and a 4 byte adler32 trailer; zip and gzip want the bare stream
+    QByteArray zlib = qCompress(_data, 6);
+    if(zlib.size() < 10) {
+        return QByteArray();
+    }
+    return zlib.mid(6, zlib.size() - 10);
+}
+
+QByteArray ProfileArchiver::gzipMember(const QByteArray &_data) {
+    QByteArray member;
+    member.reserve(_data.size() / 2 + 32);
+    member.append("\x1f\x8b\x08\x00", 4);
+    appendLE32(member, 0);          // mtime
+    member.append("\x00\x03", 2);   // no extra flags, unix
+    member.append(deflateRaw(_data));
+    appendLE32(member, crc32(_data));
+    appendLE32(member, quint32(_data.size()));
+    return member;
+}
+
+QByteArray ProfileArchiver::tarHeader(const QByteArray &_name, quint32 _size, qint64 _mtime) {
+    QByteArray header(512, '\0');
+    char *h = header.data();
+
+    QByteArray name = _name;
+    QByteArray prefix;
+    if(name.size() > 100) {
+        int split = name.lastIndexOf('/', 155);
+        if(split <= 0 || name.size() - split - 1 > 100) {
+            return QByteArray();
+        }
+        prefix = name.left(split);
+        name = name.mid(split + 1);
+    }
+
+    memcpy(h, name.constData(), name.size());
+    putOctal(h + 100, 8, 0644);
+    putOctal(h + 108, 8, 0);
+    putOctal(h + 116, 8, 0);
+    putOctal(h + 124, 12, _size);
+    putOctal(h + 136, 12, quint64(_mtime));
+    memset(h + 148, ' ', 8);
+    h[156] = '0';
+    memcpy(h + 257, "ustar", 6);
+    memcpy(h + 263, "00", 2);
+    memcpy(h + 345, prefix.constData(), prefix.size());
+
+    quint32 checksum = 0;
+    for(int i = 0; i < 512; ++i) {
+        checksum += uchar(h[i]);
+    }
+    putOctal(h + 148, 7, checksum);
+    h[155] = ' ';
+    return header;
+}
+
+ProfileArchiver::PackedEntry ProfileArchiver::pack(Format _format, const QString _path,
+                                                   const QByteArray _data, qint64 _mtime) {
+    PackedEntry entry;
+    entry.name = _path.toUtf8();
+    entry.size = quint32(_data.size());
+    entry.crc = 0;
+    entry.deflated = false;
+
+    if(_format == Zip) {
+        entry.crc = crc32(_data);
+        QByteArray deflated = deflateRaw(_data);
+        if(!deflated.isEmpty() && deflated.size() < _data.size()) {
+            entry.data = deflated;
+            entry.deflated = true;
+        }
+        else {
+            entry.data = _data;
+        }
+        return entry;
+    }
+
+    QByteArray header = tarHeader(entry.name, entry.size, _mtime);
+    if(header.isEmpty()) {
+        entry.name.clear(); // path does not fit into a ustar header
+        return entry;
+    }
+    QByteArray block = header + _data;
+    block.append(QByteArray((512 - _data.size() % 512) % 512, '\0'));
+    entry.data = (_format == TarGz) ? gzipMember(block) : block;
+    return entry;
+}
+
+bool ProfileArchiver::write(const QByteArray &_data) {
+    if(device->write(_data) != _data.size()) {
+        error = device->errorString();
+        return false;
+    }
+    offset += _data.size();
+    return true;
+}
+
+bool ProfileArchiver::writeNext() {
+    PackedEntry entry = pending.dequeue().result();
+    if(entry.name.isEmpty()) {
+        error = QObject::tr("Archive path is too long for a tar header.");
+        return false;
+    }
+
+    if(format != Zip) {
+        return write(entry.data);
+    }
+
+    if(entryCount >= 0xffff || offset + entry.data.size() >= Q_INT64_C(0xffffffff)) {
+        error = QObject::tr("Too many profiles for a zip archive, use tar instead.");
+        return false;
+    }
+
+    quint16 method = entry.deflated ? 8 : 0;
+    QByteArray local;
+    appendLE32(local, 0x04034b50);
+    appendLE16(local, 20);
+    appendLE16(local, 0x0800);      // names are UTF-8
+    appendLE16(local, method);
+    appendLE16(local, dosTime);
+    appendLE16(local, dosDate);
+    appendLE32(local, entry.crc);
+    appendLE32(local, quint32(entry.data.size()));
+    appendLE32(local, entry.size);
+    appendLE16(local, quint16(entry.name.size()));
+    appendLE16(local, 0);
+    local.append(entry.name);
+
+    appendLE32(centralDirectory, 0x02014b50);
+    appendLE16(centralDirectory, 0x0314);   // unix, zip 2.0
+    appendLE16(centralDirectory, 20);
+    appendLE16(centralDirectory, 0x0800);
+    appendLE16(centralDirectory, method);
+    appendLE16(centralDirectory, dosTime);
+    appendLE16(centralDirectory, dosDate);
+    appendLE32(centralDirectory, entry.crc);
+    appendLE32(centralDirectory, quint32(entry.data.size()));
+    appendLE32(centralDirectory, entry.size);
+    appendLE16(centralDirectory, quint16(entry.name.size()));
+    appendLE16(centralDirectory, 0);
+    appendLE16(centralDirectory, 0);
+    appendLE16(centralDirectory, 0);
+    appendLE16(centralDirectory, 0);
+    appendLE32(centralDirectory, 0100644u << 16);
+    appendLE32(centralDirectory, quint32(offset));
+    centralDirectory.append(entry.name);
+    ++entryCount;
+
+    return write(local) && write(entry.data);
+}
+
+bool ProfileArchiver::addFile(const QString _path, const QByteArray _data) {
+    if(!error.isEmpty()) {
+        return false;
+    }
+    pending.enqueue(QtConcurrent::run(&ProfileArchiver::pack, format, _path, _data, mtime));
+    while(pending.size() > maxPending) {
+        if(!writeNext()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ProfileArchiver::finish() {
+    while(!pending.isEmpty() && error.isEmpty()) {
+        writeNext();
+    }
+    if(!error.isEmpty()) {
+        return false;
+    }
+
+    if(format == Zip) {
+        qint64 directoryOffset = offset;
+        QByteArray end;
+        appendLE32(end, 0x06054b50);
+        appendLE16(end, 0);
+        appendLE16(end, 0);
+        appendLE16(end, quint16(entryCount));
+        appendLE16(end, quint16(entryCount));
+        appendLE32(end, quint32(centralDirectory.size()));
+        appendLE32(end, quint32(directoryOffset));
+        appendLE16(end, 0);
+        return write(centralDirectory) && write(end);
+    }
+
+    QByteArray trailer(1024, '\0');
+    return write(format == TarGz ? gzipMember(trailer) : trailer);
+}
+
+QString ProfileArchiver::errorString() const {
+    return error;
+}
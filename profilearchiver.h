@@ -0,0 +1,78 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef PROFILEARCHIVER_H
+#define PROFILEARCHIVER_H
+
+#include <QByteArray>
+#include <QFuture>
+#include <QQueue>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+// Streams files into a tar, tar.gz or zip archive without temporary files.
+// Entries are packed (and compressed) on the global thread pool while the
+// caller renders the next ones; at most maxPending entries are held in
+// memory. Entries are written in the order they were added.
+class ProfileArchiver
+{
+public:
+    enum Format { Tar, TarGz, Zip };
+
+    ProfileArchiver(QIODevice *_device, Format _format, int _maxPending = 0);
+    ~ProfileArchiver();
+
+    bool addFile(const QString _path, const QByteArray _data);
+    bool finish();
+    QString errorString() const;
+
+    static quint32 crc32(const QByteArray &_data, quint32 _crc = 0);
+
+private:
+    struct PackedEntry {
+        QByteArray name;
+        QByteArray data;
+        quint32 crc;
+        quint32 size;
+        bool deflated;
+    };
+
+    static PackedEntry pack(Format _format, const QString _path, const QByteArray _data,
+                            qint64 _mtime);
+    static QByteArray tarHeader(const QByteArray &_name, quint32 _size, qint64 _mtime);
+    static QByteArray deflateRaw(const QByteArray &_data);
+    static QByteArray gzipMember(const QByteArray &_data);
+
+    bool writeNext();
+    bool write(const QByteArray &_data);
+
+    QIODevice *device;
+    Format format;
+    int maxPending;
+    QQueue<QFuture<PackedEntry> > pending;
+    qint64 mtime;
+    quint16 dosTime;
+    quint16 dosDate;
+
+    // zip keeps one compact central directory record per entry
+    QByteArray centralDirectory;
+    quint32 entryCount;
+    qint64 offset;
+    QString error;
+};
+
+#endif // PROFILEARCHIVER_H
@@ -0,0 +1,303 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "profileserver.h"
+#include "statistics.h"
+#include "canonicalizer.h"
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QUrl>
+#include <algorithm>
+
+// requests larger than this are not profile downloads
+static const int maxRequestSize = 16 * 1024;
+static const int latencySamples = 4096;
+
+ProfileServer::ProfileServer(QObject *parent)
+    : QObject(parent), server(new QTcpServer(this)), latencyPos(0),
+      requestCount(0), cacheHits(0), notModified(0)
+{
+    // cost is counted in bytes of rendered profiles
+    cache.setMaxCost(64 * 1024 * 1024);
+    latencies.reserve(latencySamples);
+    connect(server, SIGNAL(newConnection()), this, SLOT(acceptConnection()));
+}
+
+bool ProfileServer::setTemplateFile(const QString _fileName) {
+    QFile file(_fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = file.errorString();
+        return false;
+    }
+    QTextStream in(&file);
+    profileTemplate = in.readAll();
+    // cosmetic edits to the template keep the rendered profiles cached
+    QByteArray canonicalHash = Canonicalizer::canonicalHash(profileTemplate);
+    if(canonicalHash != templateHash) {
+        templateHash = canonicalHash;
+        cache.clear();
+    }
+    return true;
+}
+
+bool ProfileServer::setUserListFile(const QString _fileName) {
+    QFile file(_fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = file.errorString();
+        return false;
+    }
+    users.clear();
+    QTextStream in(&file);
+    ProfileEntry entry;
+    while (!in.atEnd()) {
+        if(ProfileSet::parseUserLine(in.readLine(), &entry)) {
+            users.insert(entry.name, entry);
+        }
+    }
+    return true;
+}
+
+bool ProfileServer::listen(const QHostAddress &_address, quint16 _port) {
+    if(!server->listen(_address, _port)) {
+        error = server->errorString();
+        return false;
+    }
+    return true;
+}
+
+quint16 ProfileServer::serverPort() const {
+    return server->serverPort();
+}
+
+QString ProfileServer::errorString() const {
+    return error;
+}
+
+void ProfileServer::acceptConnection() {
+    while (server->hasPendingConnections()) {
+        QTcpSocket *socket = server->nextPendingConnection();
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(dropConnection()));
+    }
+}
+
+void ProfileServer::dropConnection() {
+    QTcpSocket *socket = static_cast<QTcpSocket *>(sender());
+    pendingInput.remove(socket);
+    socket->deleteLater();
+}
+
+void ProfileServer::readRequest() {
+    QTcpSocket *socket = static_cast<QTcpSocket *>(sender());
+    QByteArray &input = pendingInput[socket];
+    input.append(socket->readAll());
+
+    // a client may pipeline several requests
+    int headerEnd;
+    while ((headerEnd = input.indexOf("\r\n\r\n")) >= 0) {
+        QElapsedTimer timer;
+        timer.start();
+
+        QList<QByteArray> lines = input.left(headerEnd).split('\n');
+        input.remove(0, headerEnd + 4);
+
+        QList<QByteArray> requestLine = lines.takeFirst().trimmed().split(' ');
+        if(requestLine.size() != 3) {
+            Response bad = {400, "Bad Request", "text/plain", QByteArray(), "bad request\n"};
+            writeResponse(socket, bad, false, false);
+            return;
+        }
+
+        QByteArray ifNoneMatch;
+        bool keepAlive = requestLine.at(2) == "HTTP/1.1";
+        for(QList<QByteArray>::const_iterator line = lines.constBegin(); line != lines.constEnd(); ++line) {
+            int colon = line->indexOf(':');
+            if(colon <= 0) {
+                continue;
+            }
+            QByteArray name = line->left(colon).trimmed().toLower();
+            QByteArray value = line->mid(colon + 1).trimmed();
+            if(name == "if-none-match") {
+                ifNoneMatch = value;
+            }
+            else if(name == "connection") {
+                keepAlive = value.toLower() != "close";
+            }
+        }
+
+        QByteArray method = requestLine.at(0);
+        Response response = handle(method, requestLine.at(1), ifNoneMatch);
+        writeResponse(socket, response, method == "HEAD", keepAlive);
+        recordLatency(timer.nsecsElapsed());
+
+        if(!keepAlive) {
+            return;
+        }
+    }
+
+    if(input.size() > maxRequestSize) {
+        Response tooLarge = {431, "Request Header Fields Too Large", "text/plain", QByteArray(),
+                             "request too large\n"};
+        writeResponse(socket, tooLarge, false, false);
+    }
+}
+
+ProfileServer::Response ProfileServer::handle(const QByteArray &_method, const QByteArray &_path,
+                                              const QByteArray &_ifNoneMatch) {
+    if(_method != "GET" && _method != "HEAD") {
+        Response notAllowed = {405, "Method Not Allowed", "text/plain", QByteArray(),
+                               "only GET and HEAD are supported\n"};
+        return notAllowed;
+    }
+
+    QString path = QUrl::fromPercentEncoding(_path.left(_path.indexOf('?')));
+    if(path == "/stats") {
+        Response stats = {200, "OK", "application/json", QByteArray(), statsJson()};
+        return stats;
+    }
+    if(path.startsWith("/profiles/") && path.endsWith(".ovpn")) {
+        QString name = path.mid(10, path.length() - 10 - 5);
+        return profileResponse(name, _ifNoneMatch);
+    }
+
+    Response notFound = {404, "Not Found", "text/plain", QByteArray(), "not found\n"};
+    return notFound;
+}
+
+ProfileServer::Response ProfileServer::profileResponse(const QString _name,
+                                                       const QByteArray &_ifNoneMatch) {
+    QHash<QString, ProfileEntry>::const_iterator user = users.constFind(_name);
+    if(user == users.constEnd()) {
+        Response notFound = {404, "Not Found", "text/plain", QByteArray(), "unknown user\n"};
+        return notFound;
+    }
+
+    // the key covers everything the rendered profile depends on
+    QCryptographicHash keyHash(QCryptographicHash::Sha1);
+    keyHash.addData(templateHash);
+    keyHash.addData(user->name.toUtf8());
+    QMap<QString, QString>::const_iterator i = user->vars.constBegin();
+    while (i != user->vars.constEnd()) {
+        keyHash.addData("\0", 1);
+        keyHash.addData(i.key().toUtf8());
+        keyHash.addData("=", 1);
+        keyHash.addData(i.value().toUtf8());
+        ++i;
+    }
+    QByteArray key = keyHash.result();
+
+    CachedProfile *cached = cache.object(key);
+    if(cached) {
+        ++cacheHits;
+    }
+    else {
+        cached = new CachedProfile;
+        cached->body = ProfileSet::render(profileTemplate, user.value()).toUtf8();
+        cached->etag = "\"" + QCryptographicHash::hash(cached->body, QCryptographicHash::Sha1)
+                .toHex().left(32) + "\"";
+        QByteArray etag = cached->etag;
+        QByteArray body = cached->body;
+        if(!cache.insert(key, cached, body.size())) {
+            // larger than the whole cache, serve it uncached
+            Response uncached = {200, "OK", "application/x-openvpn-profile", etag, body};
+            return uncached;
+        }
+    }
+
+    if(etagMatches(_ifNoneMatch, cached->etag)) {
+        ++notModified;
+        Response unchanged = {304, "Not Modified", QByteArray(), cached->etag, QByteArray()};
+        return unchanged;
+    }
+    Response profile = {200, "OK", "application/x-openvpn-profile", cached->etag, cached->body};
+    return profile;
+}
+
+bool ProfileServer::etagMatches(const QByteArray &_ifNoneMatch, const QByteArray &_etag) {
+    // "*", or a list of strong or weak tags; If-None-Match compares weakly
+    QList<QByteArray> tags = _ifNoneMatch.split(',');
+    for(QList<QByteArray>::const_iterator tag = tags.constBegin(); tag != tags.constEnd(); ++tag) {
+        QByteArray candidate = tag->trimmed();
+        if(candidate == "*") {
+            return true;
+        }
+        if(candidate.startsWith("W/")) {
+            candidate = candidate.mid(2);
+        }
+        if(!candidate.isEmpty() && candidate == _etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ProfileServer::writeResponse(QTcpSocket *_socket, const Response &_response, bool _head,
+                                  bool _keepAlive) {
+    QByteArray header = "HTTP/1.1 " + QByteArray::number(_response.status) + " " +
+            _response.reason + "\r\n";
+    if(!_response.contentType.isEmpty()) {
+        header += "Content-Type: " + _response.contentType + "\r\n";
+    }
+    if(!_response.etag.isEmpty()) {
+        header += "ETag: " + _response.etag + "\r\nCache-Control: no-cache\r\n";
+    }
+    header += "Content-Length: " + QByteArray::number(_response.body.size()) + "\r\n";
+    header += _keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+
+    _socket->write(header);
+    if(!_head && _response.status != 304) {
+        _socket->write(_response.body);
+    }
+    if(!_keepAlive) {
+        _socket->disconnectFromHost();
+    }
+    ++requestCount;
+}
+
+void ProfileServer::recordLatency(qint64 _nsecs) {
+    if(latencies.size() < latencySamples) {
+        latencies.append(_nsecs);
+    }
+    else {
+        latencies[latencyPos] = _nsecs;
+        latencyPos = (latencyPos + 1) % latencySamples;
+    }
+}
+
+qint64 ProfileServer::percentile(QVector<qint64> &_samples, double _fraction) const {
+    if(_samples.isEmpty()) {
+        return 0;
+    }
+    QVector<qint64>::iterator nth = _samples.begin() + int(_fraction * (_samples.size() - 1));
+    std::nth_element(_samples.begin(), nth, _samples.end());
+    return *nth;
+}
+
+QByteArray ProfileServer::statsJson() const {
+    QVector<qint64> samples = latencies;
+    return "{\"requests\":" + QByteArray::number(requestCount) +
+           ",\"cache_hits\":" + QByteArray::number(cacheHits) +
+           ",\"not_modified\":" + QByteArray::number(notModified) +
+           ",\"cached_profiles\":" + QByteArray::number(cache.count()) +
+           ",\"latency_us\":{\"p50\":" + QByteArray::number(percentile(samples, 0.50) / 1000.0) +
+           ",\"p90\":" + QByteArray::number(percentile(samples, 0.90) / 1000.0) +
+           ",\"p99\":" + QByteArray::number(percentile(samples, 0.99) / 1000.0) +
+           ",\"samples\":" + QByteArray::number(samples.size()) + "}" +
+           ",\"registry\":" + Statistics::instance()->toJson() + "}\n";
+}
@@ -0,0 +1,97 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef PROFILESERVER_H
+#define PROFILESERVER_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QHostAddress>
+#include <QObject>
+#include <QVector>
+#include "profileset.h"
+
+QT_BEGIN_NAMESPACE
+class QTcpServer;
+class QTcpSocket;
+QT_END_NAMESPACE
+
+// Minimal HTTP/1.1 server rendering profiles on demand:
+//   GET /profiles/<name>.ovpn  the profile of one user of the user list
+//   GET /stats                 request counters and latency percentiles
+// Rendered profiles are cached by the hash of their inputs and carry an
+// ETag, so repeated downloads are answered from the cache or with a 304.
+class ProfileServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProfileServer(QObject *parent = 0);
+
+    bool setTemplateFile(const QString _fileName);
+    bool setUserListFile(const QString _fileName);
+    bool listen(const QHostAddress &_address, quint16 _port);
+    quint16 serverPort() const;
+    QString errorString() const;
+
+    QByteArray statsJson() const;
+
+private slots:
+    void acceptConnection();
+    void readRequest();
+    void dropConnection();
+
+private:
+    struct CachedProfile {
+        QByteArray body;
+        QByteArray etag;
+    };
+
+    struct Response {
+        int status;
+        QByteArray reason;
+        QByteArray contentType;
+        QByteArray etag;
+        QByteArray body;
+    };
+
+    Response handle(const QByteArray &_method, const QByteArray &_path,
+                    const QByteArray &_ifNoneMatch);
+    Response profileResponse(const QString _name, const QByteArray &_ifNoneMatch);
+    void writeResponse(QTcpSocket *_socket, const Response &_response, bool _head,
+                       bool _keepAlive);
+    void recordLatency(qint64 _nsecs);
+    qint64 percentile(QVector<qint64> &_sorted, double _fraction) const;
+    static bool etagMatches(const QByteArray &_ifNoneMatch, const QByteArray &_etag);
+
+    QTcpServer *server;
+    QString error;
+
+    QString profileTemplate;
+    QByteArray templateHash;
+    QHash<QString, ProfileEntry> users;
+
+    QCache<QByteArray, CachedProfile> cache;
+    QHash<QTcpSocket *, QByteArray> pendingInput;
+
+    // the most recent request latencies, used as a ring buffer
+    QVector<qint64> latencies;
+    int latencyPos;
+    quint64 requestCount;
+    quint64 cacheHits;
+    quint64 notModified;
+};
+
+#endif // PROFILESERVER_H
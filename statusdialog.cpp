@@ -0,0 +1,124 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#include <QtWidgets>
+
+#include "statusdialog.h"
+#include "statusmodel.h"
+
+StatusDialog::StatusDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    m_pModel = new StatusTableModel(this);
+    m_pTimer = new QTimer(this);
+    connect(m_pTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+
+    m_pStatusFileLabel = new QLabel(tr("Status file:"));
+    m_pStatusFileEdit = new QLineEdit;
+    m_pStatusFileBtn = new QPushButton(tr("Browse..."));
+    connect(m_pStatusFileBtn, SIGNAL(released()), this, SLOT(selectStatusFile()));
+    QHBoxLayout *statusFileLayout = new QHBoxLayout;
+    statusFileLayout->addWidget(m_pStatusFileEdit);
+    statusFileLayout->addWidget(m_pStatusFileBtn);
+
+    m_pIntervalLabel = new QLabel(tr("Refresh every (seconds):"));
+    m_pIntervalSpinBox = new QSpinBox;
+    m_pIntervalSpinBox->setRange(1, 3600);
+    m_pIntervalSpinBox->setValue(10);
+
+    m_pWatchBtn = new QPushButton(tr("Start"));
+    connect(m_pWatchBtn, SIGNAL(released()), this, SLOT(toggleWatching()));
+    m_pProfileDirBtn = new QPushButton(tr("Compare with profiles..."));
+    connect(m_pProfileDirBtn, SIGNAL(released()), this, SLOT(selectProfileDir()));
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(m_pWatchBtn);
+    buttonLayout->addWidget(m_pProfileDirBtn);
+
+    m_pSummaryLabel = new QLabel;
+
+    // only the visible rows are ever asked for, tens of thousands are fine
+    m_pTableView = new QTableView;
+    m_pTableView->setModel(m_pModel);
+    m_pTableView->verticalHeader()->setDefaultSectionSize(m_pTableView->fontMetrics().height() + 4);
+    m_pTableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_pTableView->horizontalHeader()->setStretchLastSection(true);
+
+    QFormLayout *formLayout = new QFormLayout;
+    formLayout->addRow(m_pStatusFileLabel, statusFileLayout);
+    formLayout->addRow(m_pIntervalLabel, m_pIntervalSpinBox);
+    formLayout->addRow(buttonLayout);
+    formLayout->addRow(m_pSummaryLabel);
+
+    QVBoxLayout *layout = new QVBoxLayout;
+    layout->addLayout(formLayout);
+    layout->addWidget(m_pTableView);
+    setLayout(layout);
+
+    setWindowTitle(tr("Server status"));
+    resize(800, 500);
+}
+
+void StatusDialog::selectStatusFile() {
+    QString fileName = QFileDialog::getOpenFileName(this,
+        "Select OpenVPN status file", "", "Status file (*.log *.txt *.status);;All Files (*.*)");
+    if(fileName.isEmpty())
+            return;
+    m_pStatusFileEdit->setText(fileName);
+    refresh();
+}
+
+void StatusDialog::selectProfileDir() {
+    QString dir = QFileDialog::getExistingDirectory(this, "Select profile or client config directory");
+    if(dir.isEmpty())
+            return;
+
+    // "<name>.ovpn" profiles as well as ccd files named after the client
+    QSet<QString> names;
+    QDirIterator it(dir, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QFileInfo info(it.next());
+        if(info.suffix() == "ovpn" || info.suffix().isEmpty()) {
+            names.insert(info.completeBaseName());
+        }
+    }
+    m_pModel->setKnownProfiles(names);
+}
+
+void StatusDialog::toggleWatching() {
+    if(m_pTimer->isActive()) {
+        m_pTimer->stop();
+        m_pWatchBtn->setText(tr("Start"));
+        return;
+    }
+    m_pTimer->start(m_pIntervalSpinBox->value() * 1000);
+    m_pWatchBtn->setText(tr("Stop"));
+    refresh();
+}
+
+void StatusDialog::refresh() {
+    if(m_pStatusFileEdit->text().isEmpty()) {
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    bool updated = m_pModel->refresh(m_pStatusFileEdit->text());
+    if(!m_pModel->errorString().isEmpty()) {
+        m_pSummaryLabel->setText(m_pModel->errorString());
+    }
+    else if(updated) {
+        m_pSummaryLabel->setText(tr("%1 clients (status version %2), %3 changed, refreshed in %4 ms")
+                                 .arg(m_pModel->rowCount()).arg(m_pModel->version())
+                                 .arg(m_pModel->changedLastRefresh()).arg(timer.elapsed()));
+    }
+}
@@ -0,0 +1,61 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef STATUSDIALOG_H
+#define STATUSDIALOG_H
+
+#include <QDialog>
+
+class StatusTableModel;
+
+QT_BEGIN_NAMESPACE
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QSpinBox;
+class QTableView;
+class QTimer;
+QT_END_NAMESPACE
+
+// Follows a server status file and lists the connected clients, optionally
+// next to the profiles generated for them.
+class StatusDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit StatusDialog(QWidget *parent = 0);
+
+public slots:
+    void selectStatusFile();
+    void selectProfileDir();
+    void toggleWatching();
+    void refresh();
+
+private:
+    StatusTableModel *m_pModel;
+    QTimer *m_pTimer;
+
+    QLabel *m_pStatusFileLabel;
+    QLineEdit *m_pStatusFileEdit;
+    QPushButton *m_pStatusFileBtn;
+    QLabel *m_pIntervalLabel;
+    QSpinBox *m_pIntervalSpinBox;
+    QPushButton *m_pWatchBtn;
+    QPushButton *m_pProfileDirBtn;
+    QLabel *m_pSummaryLabel;
+    QTableView *m_pTableView;
+};
+
+#endif // STATUSDIALOG_H
@@ -0,0 +1,43 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#include <QApplication>
+#include <QtTest>
+#include "tst_profileserver.h"
+#include "tst_managementclient.h"
+#include "tst_autosavejournal.h"
+#include "tst_mtucalculator.h"
+#include "tst_pemvalidator.h"
+
+int main(int argc, char *argv[])
+{
+    // the throughput graph is a widget, but nothing is ever shown
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    int failures = 0;
+    TestProfileServer profileServer;
+    failures += QTest::qExec(&profileServer, argc, argv);
+    TestManagementClient managementClient;
+    failures += QTest::qExec(&managementClient, argc, argv);
+    TestAutosaveJournal autosaveJournal;
+    failures += QTest::qExec(&autosaveJournal, argc, argv);
+    TestMtuCalculator mtuCalculator;
+    failures += QTest::qExec(&mtuCalculator, argc, argv);
+    TestPemValidator pemValidator;
+    failures += QTest::qExec(&pemValidator, argc, argv);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,29 @@
+# Tests against local stub servers and temporary files, run with
+#   qmake && make check
+TEMPLATE = app
+TARGET = openvpnui-tests
+QT = core concurrent network widgets testlib
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+include(../core/core.pri)
+
+HEADERS += \
+    tst_profileserver.h \
+    tst_managementclient.h \
+    tst_autosavejournal.h \
+    tst_mtucalculator.h \
+    tst_pemvalidator.h \
+    ../profileserver.h \
+    ../managementclient.h \
+    ../throughputgraph.h
+SOURCES += \
+    main.cpp \
+    tst_profileserver.cpp \
+    tst_managementclient.cpp \
+    tst_autosavejournal.cpp \
+    tst_mtucalculator.cpp \
+    tst_pemvalidator.cpp \
+    ../profileserver.cpp \
+    ../managementclient.cpp \
+    ../throughputgraph.cpp
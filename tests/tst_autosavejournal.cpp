@@ -0,0 +1,135 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "tst_autosavejournal.h"
+#include "autosavejournal.h"
+#include "configdocument.h"
+#include <QDir>
+#include <QFile>
+#include <QtTest>
+
+static const QString profile("client\ndev tun\nremote example.org 1194\n");
+
+QString TestAutosaveJournal::journalFile(const QString _directory) {
+    QStringList journals = QDir(_directory).entryList(QStringList() << "*.journal", QDir::Files);
+    return journals.size() == 1 ? QDir(_directory).filePath(journals.first()) : QString();
+}
+
+void TestAutosaveJournal::initTestCase() {
+    QVERIFY(dir.isValid());
+}
+
+void TestAutosaveJournal::replaysRecords() {
+    QString directory = dir.filePath("replay");
+    AutosaveJournal journal(directory);
+    QVERIFY2(journal.begin("/profiles/office.ovpn", profile), qPrintable(journal.errorString()));
+    QVERIFY(journal.isActive());
+
+    // the editor applies every record to its document right after logging it
+    ConfigDocument document;
+    document.parse(profile);
+    document.setFileContents(profile);
+    QVERIFY(journal.append(AutosaveJournal::AppendLine, "verb 4"));
+    document.addLine("verb 4", false);
+    QVERIFY(journal.append(AutosaveJournal::RemovePrefix, "dev "));
+    document.removeLinesStartingWith("dev ");
+    QString edited = document.getFileContents();
+    edited.replace("example.org", "vpn.example.org");
+    QVERIFY(journal.appendContents(document.getFileContents(), edited));
+    document.setFileContents(edited);
+
+    QList<RecoveredSession> sessions = AutosaveJournal::pending(directory);
+    QCOMPARE(sessions.size(), 1);
+    QCOMPARE(sessions.first().origin, QString("/profiles/office.ovpn"));
+    QCOMPARE(sessions.first().records, 3);
+    QCOMPARE(sessions.first().contents, document.getFileContents());
+    QVERIFY(sessions.first().contents.contains("remote vpn.example.org 1194\nverb 4\n"));
+    QVERIFY(!sessions.first().contents.contains("dev tun"));
+
+    journal.discard();
+    QVERIFY(AutosaveJournal::pending(directory).isEmpty());
+}
+
+void TestAutosaveJournal::stopsAtDamagedRecord_data() {
+    QTest::addColumn<bool>("torn");
+    QTest::newRow("torn") << true;
+    QTest::newRow("checksum") << false;
+}
+
+void TestAutosaveJournal::stopsAtDamagedRecord() {
+    QFETCH(bool, torn);
+    QString directory = dir.filePath(torn ? "torn" : "checksum");
+    AutosaveJournal journal(directory);
+    QVERIFY(journal.begin(QString(), profile));
+    QVERIFY(journal.append(AutosaveJournal::AppendLine, "verb 4"));
+    QVERIFY(journal.append(AutosaveJournal::AppendLine, "mute 20"));
+
+    // damage the last record, as a crash half way through the write would
+    QFile file(journalFile(directory));
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    if(torn) {
+        QVERIFY(file.resize(file.size() - 3));
+    }
+    else {
+        QVERIFY(file.seek(file.size() - 1));
+        char last;
+        QVERIFY(file.getChar(&last));
+        QVERIFY(file.seek(file.size() - 1));
+        QVERIFY(file.putChar(char(last ^ 0x20)));
+    }
+    file.close();
+
+    QList<RecoveredSession> sessions = AutosaveJournal::pending(directory);
+    QCOMPARE(sessions.size(), 1);
+    QVERIFY(sessions.first().origin.isEmpty());
+    QCOMPARE(sessions.first().records, 1);
+    QVERIFY(sessions.first().contents.contains("verb 4\n"));
+    QVERIFY(!sessions.first().contents.contains("mute"));
+}
+
+void TestAutosaveJournal::skipsFoldedGeneration() {
+    QString directory = dir.filePath("generation");
+    AutosaveJournal journal(directory);
+    QVERIFY(journal.begin(QString(), profile));
+    QVERIFY(journal.append(AutosaveJournal::AppendLine, "verb 4"));
+    QString folded = profile + "verb 4\n";
+
+    QFile oldJournal(journalFile(directory));
+    QVERIFY(oldJournal.open(QIODevice::ReadOnly));
+    QByteArray firstGeneration = oldJournal.readAll();
+    oldJournal.close();
+
+    QVERIFY(journal.compact(folded));
+    QList<RecoveredSession> sessions = AutosaveJournal::pending(directory);
+    QCOMPARE(sessions.size(), 1);
+    QCOMPARE(sessions.first().records, 0);
+    QCOMPARE(sessions.first().contents, folded);
+
+    QVERIFY(journal.append(AutosaveJournal::AppendLine, "mute 20"));
+    sessions = AutosaveJournal::pending(directory);
+    QCOMPARE(sessions.first().records, 1);
+    QCOMPARE(sessions.first().contents, folded + "mute 20\n");
+
+    // a crash after the new snapshot but before the journal was rewritten
+    // leaves the old records behind, they are already in the snapshot
+    QFile staleJournal(journalFile(directory));
+    QVERIFY(staleJournal.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(staleJournal.write(firstGeneration), qint64(firstGeneration.size()));
+    staleJournal.close();
+    sessions = AutosaveJournal::pending(directory);
+    QCOMPARE(sessions.first().records, 0);
+    QCOMPARE(sessions.first().contents, folded);
+    QCOMPARE(sessions.first().contents.count("verb 4"), 1);
+}
@@ -0,0 +1,40 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef TST_AUTOSAVEJOURNAL_H
+#define TST_AUTOSAVEJOURNAL_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+// Writes journals into a temporary directory and recovers them the way the
+// editor does after a crash.
+class TestAutosaveJournal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void replaysRecords();
+    void stopsAtDamagedRecord_data();
+    void stopsAtDamagedRecord();
+    void skipsFoldedGeneration();
+
+private:
+    static QString journalFile(const QString _directory);
+
+    QTemporaryDir dir;
+};
+
+#endif // TST_AUTOSAVEJOURNAL_H
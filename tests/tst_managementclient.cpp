@@ -0,0 +1,298 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "tst_managementclient.h"
+#include "managementclient.h"
+#include "throughputgraph.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtTest>
+
+static const QByteArray banner(">INFO:OpenVPN Management Interface Version 3 -- type 'help' for more info\r\n");
+
+// the stub lives in this thread, every wait has to run the event loop
+QByteArray TestManagementClient::readCommand(QIODevice *_stub) {
+    QSignalSpy readable(_stub, SIGNAL(readyRead()));
+    while (!_stub->canReadLine()) {
+        if(!readable.wait(5000)) {
+            return QByteArray();
+        }
+    }
+    return _stub->readLine().trimmed();
+}
+
+// accepts the client and returns the server side of the connection
+static QTcpSocket *acceptClient(QTcpServer &_server) {
+    if(!_server.hasPendingConnections()) {
+        QSignalSpy pending(&_server, SIGNAL(newConnection()));
+        if(!pending.wait(5000)) {
+            return 0;
+        }
+    }
+    return _server.nextPendingConnection();
+}
+
+void TestManagementClient::initTestCase() {
+    QVERIFY(dir.isValid());
+}
+
+void TestManagementClient::subscribesOverTcp() {
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+    ManagementClient client;
+    QSignalSpy connected(&client, SIGNAL(connected()));
+    client.connectTo("127.0.0.1:" + QString::number(server.serverPort()), QString(), 2);
+    QTcpSocket *stub = acceptClient(server);
+    QVERIFY(stub);
+    QVERIFY(connected.count() == 1 || connected.wait(5000));
+
+    // nothing is sent before the banner
+    stub->write(banner);
+    QCOMPARE(readCommand(stub), QByteArray("state on"));
+    QCOMPARE(readCommand(stub), QByteArray("state"));
+    QCOMPARE(readCommand(stub), QByteArray("bytecount 2"));
+
+    QSignalSpy state(&client, SIGNAL(stateChanged(QString,QString)));
+    QSignalSpy bytes(&client, SIGNAL(byteCount(qint64,qint64)));
+    stub->write("1700000000,CONNECTED,SUCCESS,10.8.0.2,192.0.2.1,1194,,\r\nEND\r\n"
+                ">BYTECOUNT:1000,2000\r\n");
+    QVERIFY(bytes.wait(5000));
+    QCOMPARE(state.count(), 1);
+    QCOMPARE(state.at(0).at(0).toString(), QString("CONNECTED"));
+    QCOMPARE(state.at(0).at(1).toString(), QString("SUCCESS"));
+    QCOMPARE(bytes.at(0).at(0).toLongLong(), qint64(1000));
+    QCOMPARE(bytes.at(0).at(1).toLongLong(), qint64(2000));
+    QVERIFY(client.isConnected());
+}
+
+void TestManagementClient::answersPasswordPrompt() {
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+    ManagementClient client;
+    client.connectTo("127.0.0.1:" + QString::number(server.serverPort()), "s3cret");
+    QTcpSocket *stub = acceptClient(server);
+    QVERIFY(stub);
+
+    // OpenVPN does not end the prompt with a line break
+    stub->write("ENTER PASSWORD:");
+    QCOMPARE(readCommand(stub), QByteArray("s3cret"));
+    stub->write("SUCCESS: password is correct\r\n" + banner);
+    QCOMPARE(readCommand(stub), QByteArray("state on"));
+
+    QSignalSpy error(&client, SIGNAL(errorOccurred(QString)));
+    stub->write("ERROR: bad password\r\n");
+    QVERIFY(error.wait(5000));
+}
+
+void TestManagementClient::measuresConnectLatency() {
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+    ManagementClient client;
+    client.connectTo("127.0.0.1:" + QString::number(server.serverPort()));
+    QTcpSocket *stub = acceptClient(server);
+    QVERIFY(stub);
+    stub->write(banner);
+    QCOMPARE(readCommand(stub), QByteArray("state on"));
+
+    QSignalSpy state(&client, SIGNAL(stateChanged(QString,QString)));
+    QSignalSpy latency(&client, SIGNAL(connectLatency(qint64)));
+    stub->write(">STATE:1700000000,RECONNECTING,ping-restart,,,,,\r\n");
+    QVERIFY(state.wait(5000));
+    QTest::qWait(200);
+    stub->write(">STATE:1700000001,WAIT,,,,,,\r\n"
+                ">STATE:1700000001,AUTH,,,,,,\r\n"
+                ">STATE:1700000002,CONNECTED,SUCCESS,10.8.0.2,192.0.2.1,1194,,\r\n");
+    QVERIFY(latency.wait(5000));
+    QCOMPARE(latency.count(), 1);
+    // measured from leaving CONNECTED, not from the last intermediate state
+    qint64 milliseconds = latency.at(0).at(0).toLongLong();
+    QVERIFY2(milliseconds >= 200 && milliseconds < 5000, qPrintable(QString::number(milliseconds)));
+    QCOMPARE(state.count(), 4);
+
+    // a second CONNECTED without a reconnect in between measures nothing
+    stub->write(">STATE:1700000003,CONNECTED,SUCCESS,10.8.0.2,192.0.2.1,1194,,\r\n");
+    QVERIFY(state.wait(5000));
+    QCOMPARE(latency.count(), 1);
+}
+
+void TestManagementClient::sumsClientCounters() {
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+    ManagementClient client;
+    client.connectTo("127.0.0.1:" + QString::number(server.serverPort()));
+    QTcpSocket *stub = acceptClient(server);
+    QVERIFY(stub);
+    stub->write(banner);
+    QCOMPARE(readCommand(stub), QByteArray("state on"));
+
+    QSignalSpy bytes(&client, SIGNAL(byteCount(qint64,qint64)));
+    stub->write(">BYTECOUNT_CLI:1,100,1000\r\n"
+                ">BYTECOUNT_CLI:2,50,500\r\n"
+                ">BYTECOUNT_CLI:1,300,1500\r\n");
+    QVERIFY(bytes.wait(5000));
+    QTest::qWait(100);
+    // one sum for the whole round, an update replaces the counters of that
+    // client instead of adding up
+    QCOMPARE(bytes.count(), 1);
+    QCOMPARE(bytes.at(0).at(0).toLongLong(), qint64(350));
+    QCOMPARE(bytes.at(0).at(1).toLongLong(), qint64(2000));
+
+    stub->write(">CLIENT:DISCONNECT,1\r\n>CLIENT:ENV,END\r\n"
+                ">BYTECOUNT_CLI:2,60,600\r\n");
+    QVERIFY(bytes.wait(5000));
+    QCOMPARE(bytes.count(), 2);
+    QCOMPARE(bytes.at(1).at(0).toLongLong(), qint64(60));
+    QCOMPARE(bytes.at(1).at(1).toLongLong(), qint64(600));
+}
+
+void TestManagementClient::talksToUnixSocket() {
+    QLocalServer server;
+    QString path = dir.filePath("management.sock");
+    QLocalServer::removeServer(path);
+    QVERIFY2(server.listen(path), qPrintable(server.errorString()));
+
+    ManagementClient client;
+    QSignalSpy connected(&client, SIGNAL(connected()));
+    client.connectTo(path, "s3cret");
+    if(!server.hasPendingConnections()) {
+        QSignalSpy pending(&server, SIGNAL(newConnection()));
+        QVERIFY(pending.wait(5000));
+    }
+    QLocalSocket *stub = server.nextPendingConnection();
+    QVERIFY(stub);
+    QVERIFY(connected.count() == 1 || connected.wait(5000));
+
+    stub->write("ENTER PASSWORD:");
+    QCOMPARE(readCommand(stub), QByteArray("s3cret"));
+    stub->write("SUCCESS: password is correct\r\n" + banner);
+    QCOMPARE(readCommand(stub), QByteArray("state on"));
+    QCOMPARE(readCommand(stub), QByteArray("state"));
+    QCOMPARE(readCommand(stub), QByteArray("bytecount 1"));
+
+    QSignalSpy bytes(&client, SIGNAL(byteCount(qint64,qint64)));
+    stub->write(">BYTECOUNT:4096,8192\r\n");
+    QVERIFY(bytes.wait(5000));
+    QCOMPARE(bytes.at(0).at(0).toLongLong(), qint64(4096));
+    QCOMPARE(bytes.at(0).at(1).toLongLong(), qint64(8192));
+}
+
+void TestManagementClient::computesRates() {
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+    ManagementClient client;
+    client.connectTo("127.0.0.1:" + QString::number(server.serverPort()));
+    QTcpSocket *stub = acceptClient(server);
+    QVERIFY(stub);
+    stub->write(banner);
+    QCOMPARE(readCommand(stub), QByteArray("state on"));
+
+    QSignalSpy bytes(&client, SIGNAL(byteCount(qint64,qint64)));
+    stub->write(">BYTECOUNT:1000,5000\r\n"
+                ">BYTECOUNT:3000,6000\r\n"
+                ">BYTECOUNT:3500,6000\r\n"
+                ">BYTECOUNT:200,100\r\n"      // the tunnel restarted
+                ">BYTECOUNT:1200,2100\r\n");
+    while (bytes.count() < 5) {
+        QVERIFY(bytes.wait(5000));
+    }
+
+    // the counters arrive one interval apart, here fixed to 1 and 0.5 s
+    static const qint64 elapsed[] = {1000, 1000, 500, 1000, 1000};
+    static const bool sampled[] = {false, true, true, false, true};
+    ThroughputGraph graph(10);
+    for(int i = 0; i < bytes.count(); ++i) {
+        QCOMPARE(graph.addCounters(bytes.at(i).at(0).toLongLong(), bytes.at(i).at(1).toLongLong(),
+                                   elapsed[i]), sampled[i]);
+    }
+    QCOMPARE(graph.samples(), 3);
+    QCOMPARE(graph.inRate(2), 2000.0);
+    QCOMPARE(graph.outRate(2), 1000.0);
+    QCOMPARE(graph.inRate(1), 1000.0);
+    QCOMPARE(graph.outRate(1), 0.0);
+    QCOMPARE(graph.inRate(0), 1000.0);
+    QCOMPARE(graph.outRate(0), 2000.0);
+
+    graph.clear();
+    QCOMPARE(graph.samples(), 0);
+    QCOMPARE(graph.addCounters(5000, 5000, 1000), false);
+}
+
+// wired like MonitorDialog, the graph times the counters itself
+void TestManagementClient::ratesFromServerRounds() {
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+    ManagementClient client;
+    ThroughputGraph graph(10);
+    connect(&client, SIGNAL(byteCount(qint64,qint64)), &graph, SLOT(addByteCount(qint64,qint64)));
+    client.connectTo("127.0.0.1:" + QString::number(server.serverPort()));
+    QTcpSocket *stub = acceptClient(server);
+    QVERIFY(stub);
+    stub->write(banner);
+    QCOMPARE(readCommand(stub), QByteArray("state on"));
+
+    QSignalSpy samples(&graph, SIGNAL(sampleAdded()));
+    QSignalSpy bytes(&client, SIGNAL(byteCount(qint64,qint64)));
+    stub->write(">BYTECOUNT_CLI:1,0,0\r\n"
+                ">BYTECOUNT_CLI:2,0,0\r\n"
+                ">BYTECOUNT_CLI:3,0,0\r\n");
+    QVERIFY(bytes.wait(5000));
+    QTest::qWait(500);
+    // each client moved 100 kB in and 10 kB out over half a second
+    stub->write(">BYTECOUNT_CLI:1,100000,10000\r\n"
+                ">BYTECOUNT_CLI:2,100000,10000\r\n"
+                ">BYTECOUNT_CLI:3,100000,10000\r\n");
+    QVERIFY(samples.wait(5000));
+    QTest::qWait(100);
+    QCOMPARE(graph.samples(), 1);
+    // 600 kB/s, a sample per client line would report up to 1000 times that
+    double rate = graph.inRate(0);
+    QVERIFY2(rate > 150000 && rate <= 600000, qPrintable(QString::number(rate)));
+    QVERIFY2(qAbs(graph.outRate(0) * 10 - rate) < 1, qPrintable(QString::number(graph.outRate(0))));
+}
+
+void TestManagementClient::ringKeepsNewestSamples() {
+    ThroughputGraph graph(3);
+    for(int i = 1; i <= 5; ++i) {
+        graph.addSample(i * 100, i * 10);
+    }
+    QCOMPARE(graph.samples(), 3);
+    QCOMPARE(graph.inRate(0), 500.0);
+    QCOMPARE(graph.inRate(1), 400.0);
+    QCOMPARE(graph.inRate(2), 300.0);
+    QCOMPARE(graph.outRate(2), 30.0);
+    // older samples have been overwritten
+    QCOMPARE(graph.inRate(3), 0.0);
+}
+
+void TestManagementClient::marksReconnects() {
+    ThroughputGraph graph(3);
+    graph.addSample(100, 10);
+    graph.addLatency(1500);
+    QCOMPARE(graph.latency(0), qint64(0));
+    // the latency belongs to the first sample after the reconnect
+    graph.addSample(200, 20);
+    graph.addSample(300, 30);
+    QCOMPARE(graph.latency(0), qint64(0));
+    QCOMPARE(graph.latency(1), qint64(1500));
+    QCOMPARE(graph.latency(2), qint64(0));
+    // and leaves the ring with it
+    graph.addSample(400, 40);
+    graph.addSample(500, 50);
+    QCOMPARE(graph.latency(2), qint64(0));
+    QCOMPARE(graph.latency(3), qint64(0));
+}
@@ -0,0 +1,49 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef TST_MANAGEMENTCLIENT_H
+#define TST_MANAGEMENTCLIENT_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+// Plays an OpenVPN management interface on a QTcpServer and a QLocalServer
+// and feeds what ManagementClient reports into a ThroughputGraph.
+class TestManagementClient : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void subscribesOverTcp();
+    void answersPasswordPrompt();
+    void measuresConnectLatency();
+    void sumsClientCounters();
+    void talksToUnixSocket();
+    void computesRates();
+    void ratesFromServerRounds();
+    void ringKeepsNewestSamples();
+    void marksReconnects();
+
+private:
+    static QByteArray readCommand(QIODevice *_stub);
+
+    QTemporaryDir dir;
+};
+
+#endif // TST_MANAGEMENTCLIENT_H
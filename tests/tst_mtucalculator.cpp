@@ -0,0 +1,68 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "tst_mtucalculator.h"
+#include "mtucalculator.h"
+#include <QtTest>
+
+void TestMtuCalculator::countsOverhead_data() {
+    QTest::addColumn<QString>("proto");
+    QTest::addColumn<QString>("dev");
+    QTest::addColumn<int>("tunMtu");
+    QTest::addColumn<int>("mssfix");
+    QTest::addColumn<int>("fragment");
+
+    // AES-256-GCM on a 1500 byte path: opcode, packet id and tag take 24
+    QTest::newRow("udp") << "udp" << "tun" << 1448 << 1472 << 0;
+    QTest::newRow("udp6") << "udp6" << "tun" << 1428 << 1452 << 0;
+    QTest::newRow("tcp-client") << "tcp-client" << "tun" << 1434 << 1460 << 0;
+    QTest::newRow("tcp6-client") << "tcp6-client" << "tun" << 1414 << 1440 << 0;
+    QTest::newRow("tcp6-server") << "tcp6-server" << "tun" << 1414 << 1440 << 0;
+    QTest::newRow("udp tap") << "udp" << "tap" << 1434 << 1472 << 1472;
+}
+
+void TestMtuCalculator::countsOverhead() {
+    QFETCH(QString, proto);
+    QFETCH(QString, dev);
+    QFETCH(int, tunMtu);
+    QFETCH(int, mssfix);
+    QFETCH(int, fragment);
+
+    MtuCalculator::Input input;
+    input.pathMtu = 1500;
+    input.proto = proto;
+    input.dev = dev;
+    input.cipher = "AES-256-GCM";
+    MtuCalculator::Result result = MtuCalculator::calculate(input);
+    QCOMPARE(result.tunMtu, tunMtu);
+    QCOMPARE(result.mssfix, mssfix);
+    QCOMPARE(result.fragment, fragment);
+    QCOMPARE(result.overhead, 1500 - tunMtu);
+    QVERIFY(result.breakdown.first().contains(proto.section('-', 0, 0).endsWith('6') ? "IPv6" : "IPv4"));
+}
+
+void TestMtuCalculator::readsDirectives() {
+    MtuCalculator::Input input = MtuCalculator::fromDirectives(
+                QStringList() << "proto tcp6-client" << "dev tun" << "data-ciphers CHACHA20-POLY1305:AES-256-GCM"
+                              << "comp-lzo no", 1400);
+    QCOMPARE(input.proto, QString("tcp6-client"));
+    QCOMPARE(input.cipher, QString("CHACHA20-POLY1305"));
+    QCOMPARE(input.compression, QString("comp-lzo"));
+
+    // IPv6, TCP with length prefix, opcode, packet id, tag and one byte of v1 framing
+    MtuCalculator::Result result = MtuCalculator::calculate(input);
+    QCOMPARE(result.overhead, 40 + 22 + 4 + 4 + 16 + 1);
+    QCOMPARE(result.mssfix, 1400 - 40 - 20);
+}
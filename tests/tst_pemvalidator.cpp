@@ -0,0 +1,112 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include "tst_pemvalidator.h"
+#include "pemvalidator.h"
+#include <QtTest>
+
+Q_DECLARE_METATYPE(PemValidator::Result)
+
+// a SEQUENCE with a two byte length and _size bytes of content
+static QByteArray derSequence(int _size) {
+    QByteArray der;
+    der.append(char(0x30)).append(char(0x82)).append(char(_size >> 8)).append(char(_size & 0xff));
+    for(int i = 0; i < _size; ++i) {
+        der.append(char(i * 7));
+    }
+    return der;
+}
+
+static QByteArray armor(const QByteArray _label, const QByteArray _body, const QByteArray _headers = QByteArray()) {
+    QByteArray base64 = _body.toBase64();
+    QByteArray pem = "-----BEGIN " + _label + "-----\n" + _headers;
+    for(int i = 0; i < base64.size(); i += 64) {
+        pem += base64.mid(i, 64) + "\n";
+    }
+    return pem + "-----END " + _label + "-----\n";
+}
+
+void TestPemValidator::decodesBase64_data() {
+    QTest::addColumn<QByteArray>("text");
+
+    // lengths around the 16 character vectors, with and without line breaks
+    QByteArray bytes;
+    for(int i = 0; i < 200; ++i) {
+        bytes.append(char(i * 13 + 5));
+    }
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("one group") << bytes.left(3).toBase64();
+    QTest::newRow("one vector") << bytes.left(12).toBase64();
+    QTest::newRow("vector and tail") << bytes.left(14).toBase64();
+    QTest::newRow("long line") << bytes.toBase64();
+    QByteArray lines = armor("CERTIFICATE", bytes).split('\n').mid(1, 4).join("\n");
+    QTest::newRow("lines") << lines;
+    QTest::newRow("crlf lines") << QByteArray(lines).replace("\n", "\r\n");
+    QTest::newRow("blank inside a group") << QByteArray("QU J D\tREVG");
+}
+
+void TestPemValidator::decodesBase64() {
+    QFETCH(QByteArray, text);
+    QByteArray expected = QByteArray::fromBase64(text);
+    // padding is stripped by the caller
+    QByteArray body = text;
+    while (body.endsWith('=')) {
+        body.chop(1);
+    }
+    QByteArray decoded(body.size() * 3 / 4, 0);
+    qint64 chars = PemValidator::decodeBase64(body.constData(), body.size(), decoded.data());
+    QVERIFY(chars >= 0);
+    QCOMPARE(decoded.left(int(chars * 3 / 4)), expected);
+}
+
+void TestPemValidator::validatesBlocks_data() {
+    QTest::addColumn<QString>("tag");
+    QTest::addColumn<QByteArray>("content");
+    QTest::addColumn<PemValidator::Result>("result");
+
+    QByteArray cert = armor("CERTIFICATE", derSequence(300));
+    QByteArray key = armor("PRIVATE KEY", derSequence(120));
+    QTest::newRow("certificate") << "ca" << cert << PemValidator::Valid;
+    QTest::newRow("chain") << "ca" << cert + armor("CERTIFICATE", derSequence(1000)) << PemValidator::Valid;
+    QTest::newRow("key") << "key" << key << PemValidator::Valid;
+    QTest::newRow("key in ca") << "ca" << key << PemValidator::WrongBlockType;
+    QTest::newRow("crlf armor") << "cert" << QByteArray(cert).replace("\n", "\r\n") << PemValidator::Valid;
+
+    // a lost last line still leaves whole base64 groups
+    QList<QByteArray> lines = cert.split('\n');
+    lines.removeAt(lines.size() - 3);
+    QTest::newRow("truncated certificate") << "ca" << lines.join("\n") << PemValidator::NotDer;
+    QByteArray shortened = cert;
+    shortened.remove(shortened.indexOf("\n-----END") - 1, 1);
+    QTest::newRow("cut inside a group") << "ca" << shortened << PemValidator::BadLength;
+    QTest::newRow("not a sequence") << "ca" << armor("CERTIFICATE", QByteArray(48, 'x')) << PemValidator::NotDer;
+    QTest::newRow("bad alphabet") << "ca" << QByteArray(cert).replace("MIIB", "MI*B") << PemValidator::BadAlphabet;
+
+    // the body of a legacy encrypted key is ciphertext
+    QByteArray headers = "Proc-Type: 4,ENCRYPTED\nDEK-Info: AES-256-CBC,00112233445566778899AABBCCDDEEFF\n\n";
+    QByteArray encrypted = armor("RSA PRIVATE KEY", QByteArray(64, char(0xa5)), headers);
+    QTest::newRow("legacy encrypted key") << "key" << encrypted << PemValidator::Valid;
+    QTest::newRow("legacy encrypted key, crlf") << "key" << QByteArray(encrypted).replace("\n", "\r\n")
+                                                << PemValidator::Valid;
+    QTest::newRow("unencrypted garbage") << "key" << armor("RSA PRIVATE KEY", QByteArray(64, char(0xa5)))
+                                         << PemValidator::NotDer;
+}
+
+void TestPemValidator::validatesBlocks() {
+    QFETCH(QString, tag);
+    QFETCH(QByteArray, content);
+    QFETCH(PemValidator::Result, result);
+    QCOMPARE(PemValidator::validate(tag, content), result);
+}
@@ -0,0 +1,33 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef TST_PEMVALIDATOR_H
+#define TST_PEMVALIDATOR_H
+
+#include <QObject>
+
+// Feeds armored blocks built from synthetic DER structures through the
+// checks an inline block passes before it is added to a profile.
+class TestPemValidator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void decodesBase64_data();
+    void decodesBase64();
+    void validatesBlocks_data();
+    void validatesBlocks();
+};
+
+#endif // TST_PEMVALIDATOR_H
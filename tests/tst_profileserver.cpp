@@ -0,0 +1,128 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#include "tst_profileserver.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QTcpSocket>
+#include <QtTest>
+
+static bool writeFile(const QString _fileName, const QByteArray _contents) {
+    QFile file(_fileName);
+    return file.open(QIODevice::WriteOnly) && file.write(_contents) == _contents.size();
+}
+
+void TestProfileServer::initTestCase() {
+    QVERIFY(dir.isValid());
+    QVERIFY(writeFile(dir.filePath("client.ovpn"), "client\ndev tun\nremote ${host} 1194\n"));
+    QVERIFY(writeFile(dir.filePath("users.txt"), "alice host=a.example.org\nbob host=b.example.org\n"));
+    QVERIFY(server.setTemplateFile(dir.filePath("client.ovpn")));
+    QVERIFY(server.setUserListFile(dir.filePath("users.txt")));
+    QVERIFY2(server.listen(QHostAddress::LocalHost, 0), qPrintable(server.errorString()));
+    QVERIFY(server.serverPort() != 0);
+}
+
+QByteArray TestProfileServer::get(const QByteArray &_path, const QByteArray &_headers) {
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, server.serverPort());
+    if(!socket.waitForConnected(5000)) {
+        return QByteArray();
+    }
+    // the server lives in this thread, wait through the event loop
+    QSignalSpy closed(&socket, SIGNAL(disconnected()));
+    socket.write("GET " + _path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n" +
+                 _headers + "\r\n");
+    if(!closed.wait(5000)) {
+        return QByteArray();
+    }
+    return socket.readAll();
+}
+
+int TestProfileServer::status(const QByteArray &_response) {
+    return _response.left(_response.indexOf("\r\n")).split(' ').value(1).toInt();
+}
+
+QByteArray TestProfileServer::header(const QByteArray &_response, const QByteArray &_name) {
+    QList<QByteArray> lines = _response.left(_response.indexOf("\r\n\r\n")).split('\n');
+    for(QList<QByteArray>::const_iterator line = lines.constBegin(); line != lines.constEnd(); ++line) {
+        int colon = line->indexOf(':');
+        if(colon > 0 && line->left(colon).trimmed().toLower() == _name.toLower()) {
+            return line->mid(colon + 1).trimmed();
+        }
+    }
+    return QByteArray();
+}
+
+QByteArray TestProfileServer::body(const QByteArray &_response) {
+    return _response.mid(_response.indexOf("\r\n\r\n") + 4);
+}
+
+qint64 TestProfileServer::cacheHits() {
+    QByteArray response = get("/stats");
+    return qint64(QJsonDocument::fromJson(body(response)).object().value("cache_hits").toDouble(-1));
+}
+
+void TestProfileServer::rendersProfile() {
+    QByteArray response = get("/profiles/alice.ovpn");
+    QCOMPARE(status(response), 200);
+    QVERIFY(body(response).contains("remote a.example.org 1194"));
+    QCOMPARE(header(response, "Content-Length").toInt(), body(response).size());
+    etag = header(response, "ETag");
+    QVERIFY(etag.startsWith('"') && etag.endsWith('"') && etag.size() > 2);
+}
+
+void TestProfileServer::answersNotModified_data() {
+    QTest::addColumn<QByteArray>("ifNoneMatch");
+    QTest::addColumn<int>("expected");
+    QTest::newRow("strong") << QByteArray("%1") << 304;
+    QTest::newRow("weak") << QByteArray("W/%1") << 304;
+    QTest::newRow("list") << QByteArray("\"stale\", W/\"older\", %1") << 304;
+    QTest::newRow("any") << QByteArray("*") << 304;
+    QTest::newRow("other") << QByteArray("\"stale\"") << 200;
+}
+
+void TestProfileServer::answersNotModified() {
+    QFETCH(QByteArray, ifNoneMatch);
+    QFETCH(int, expected);
+    QVERIFY(!etag.isEmpty());
+    ifNoneMatch.replace("%1", etag);
+
+    QByteArray response = get("/profiles/alice.ovpn", "If-None-Match: " + ifNoneMatch + "\r\n");
+    QCOMPARE(status(response), expected);
+    QCOMPARE(header(response, "ETag"), etag);
+    if(expected == 304) {
+        QVERIFY(body(response).isEmpty());
+    }
+}
+
+void TestProfileServer::countsCacheHits() {
+    qint64 before = cacheHits();
+    QVERIFY(before >= 0);
+    QCOMPARE(status(get("/profiles/alice.ovpn")), 200);
+    QCOMPARE(status(get("/profiles/alice.ovpn", "If-None-Match: " + etag + "\r\n")), 304);
+    QCOMPARE(cacheHits(), before + 2);
+
+    // a new user is rendered once, then served from the cache
+    QCOMPARE(status(get("/profiles/bob.ovpn")), 200);
+    QCOMPARE(cacheHits(), before + 2);
+    QCOMPARE(status(get("/profiles/bob.ovpn")), 200);
+    QCOMPARE(cacheHits(), before + 3);
+}
+
+void TestProfileServer::unknownUser() {
+    QCOMPARE(status(get("/profiles/mallory.ovpn")), 404);
+    QCOMPARE(status(get("/elsewhere")), 404);
+}
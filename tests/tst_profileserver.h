@@ -0,0 +1,48 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef TST_PROFILESERVER_H
+#define TST_PROFILESERVER_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include "profileserver.h"
+
+// Runs ProfileServer on 127.0.0.1 with an ephemeral port and talks plain
+// HTTP/1.1 to it.
+class TestProfileServer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void rendersProfile();
+    void answersNotModified_data();
+    void answersNotModified();
+    void countsCacheHits();
+    void unknownUser();
+
+private:
+    QByteArray get(const QByteArray &_path, const QByteArray &_headers = QByteArray());
+    static int status(const QByteArray &_response);
+    static QByteArray header(const QByteArray &_response, const QByteArray &_name);
+    static QByteArray body(const QByteArray &_response);
+    qint64 cacheHits();
+
+    QTemporaryDir dir;
+    ProfileServer server;
+    QByteArray etag;
+};
+
+#endif // TST_PROFILESERVER_H
@@ -0,0 +1,141 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+
+#include <QtWidgets>
+
+#include "throughputgraph.h"
+
+QString ThroughputGraph::formatRate(double _bytesPerSecond) {
+    double bits = _bytesPerSecond * 8;
+    if(bits >= 1e6) {
+        return QString("%1 Mbit/s").arg(bits / 1e6, 0, 'f', 1);
+    }
+    return QString("%1 kbit/s").arg(bits / 1e3, 0, 'f', 1);
+}
+
+ThroughputGraph::ThroughputGraph(int _capacity, QWidget *parent)
+    : QWidget(parent), inRates(_capacity, 0), outRates(_capacity, 0), latencies(_capacity, 0),
+      head(0), count(0), lastBytesIn(-1), lastBytesOut(-1), pendingLatency(0)
+{
+    setMinimumSize(400, 150);
+}
+
+void ThroughputGraph::addSample(double _bytesInPerSecond, double _bytesOutPerSecond) {
+    inRates[head] = _bytesInPerSecond;
+    outRates[head] = _bytesOutPerSecond;
+    latencies[head] = pendingLatency;
+    pendingLatency = 0;
+    head = (head + 1) % inRates.size();
+    count = qMin(count + 1, inRates.size());
+    update();
+    emit sampleAdded();
+}
+
+bool ThroughputGraph::addCounters(qint64 _bytesIn, qint64 _bytesOut, qint64 _elapsedMs) {
+    // counters restart with the tunnel, a drop starts a new baseline
+    bool added = lastBytesIn >= 0 && _bytesIn >= lastBytesIn && _bytesOut >= lastBytesOut;
+    if(added) {
+        double seconds = qMax<qint64>(_elapsedMs, 1) / 1000.0;
+        addSample((_bytesIn - lastBytesIn) / seconds, (_bytesOut - lastBytesOut) / seconds);
+    }
+    lastBytesIn = _bytesIn;
+    lastBytesOut = _bytesOut;
+    return added;
+}
+
+void ThroughputGraph::addByteCount(qint64 _bytesIn, qint64 _bytesOut) {
+    qint64 elapsed = sampleTimer.isValid() ? sampleTimer.elapsed() : 0;
+    sampleTimer.start();
+    addCounters(_bytesIn, _bytesOut, elapsed);
+}
+
+void ThroughputGraph::addLatency(qint64 _milliseconds) {
+    pendingLatency = qMax<qint64>(_milliseconds, 1);
+}
+
+void ThroughputGraph::clear() {
+    head = 0;
+    count = 0;
+    lastBytesIn = -1;
+    lastBytesOut = -1;
+    pendingLatency = 0;
+    sampleTimer.invalidate();
+    update();
+}
+
+int ThroughputGraph::samples() const {
+    return count;
+}
+
+int ThroughputGraph::slot(int _age) const {
+    return (head - 1 - _age + 2 * inRates.size()) % inRates.size();
+}
+
+double ThroughputGraph::inRate(int _age) const {
+    return _age >= 0 && _age < count ? inRates.at(slot(_age)) : 0;
+}
+
+double ThroughputGraph::outRate(int _age) const {
+    return _age >= 0 && _age < count ? outRates.at(slot(_age)) : 0;
+}
+
+qint64 ThroughputGraph::latency(int _age) const {
+    return _age >= 0 && _age < count ? latencies.at(slot(_age)) : 0;
+}
+
+void ThroughputGraph::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+    painter.setPen(palette().mid().color());
+    painter.drawRect(rect().adjusted(0, 0, -1, -1));
+    if(count < 2) {
+        return;
+    }
+
+    int capacity = inRates.size();
+    int first = (head - count + capacity) % capacity;
+    double peak = 1;
+    for(int i = 0; i < count; ++i) {
+        int slot = (first + i) % capacity;
+        peak = qMax(peak, qMax(inRates.at(slot), outRates.at(slot)));
+    }
+
+    // newest sample on the right edge
+    double step = double(width() - 1) / (capacity - 1);
+    double offset = (capacity - count) * step;
+    QPolygonF in;
+    QPolygonF out;
+    for(int i = 0; i < count; ++i) {
+        int slot = (first + i) % capacity;
+        double x = offset + i * step;
+        in << QPointF(x, height() - 1 - inRates.at(slot) / peak * (height() - 20));
+        out << QPointF(x, height() - 1 - outRates.at(slot) / peak * (height() - 20));
+        // a reconnect finished just before this sample
+        if(latencies.at(slot) > 0) {
+            painter.setPen(QPen(Qt::darkRed, 1, Qt::DashLine));
+            painter.drawLine(QPointF(x, 18), QPointF(x, height() - 1));
+            painter.drawText(QPointF(x + 3, 30), tr("%1 ms").arg(latencies.at(slot)));
+        }
+    }
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(Qt::darkGreen, 1.5));
+    painter.drawPolyline(in);
+    painter.setPen(QPen(Qt::darkBlue, 1.5));
+    painter.drawPolyline(out);
+
+    painter.setPen(palette().text().color());
+    painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignTop | Qt::AlignLeft,
+                     tr("peak %1 (in: green, out: blue, reconnect: red)").arg(formatRate(peak)));
+}
@@ -0,0 +1,70 @@
+/*  Copyright 2016 Volkan Gezer
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//  http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License. */
+
+#ifndef THROUGHPUTGRAPH_H
+#define THROUGHPUTGRAPH_H
+
+#include <QElapsedTimer>
+#include <QVector>
+#include <QWidget>
+
+// Plots the last samples of incoming and outgoing throughput and marks the
+// samples after a reconnect with its setup latency. Samples live in a fixed
+// ring, so a monitor left open for days uses no more memory.
+class ThroughputGraph : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ThroughputGraph(int _capacity = 300, QWidget *parent = 0);
+    void addSample(double _bytesInPerSecond, double _bytesOutPerSecond);
+    // turns two byte counters _elapsedMs apart into a sample; false for the
+    // first reading and after the counters restarted with the tunnel
+    bool addCounters(qint64 _bytesIn, qint64 _bytesOut, qint64 _elapsedMs);
+    void clear();
+
+    int samples() const;
+    double inRate(int _age) const;      // bytes per second, 0 is the newest sample
+    double outRate(int _age) const;
+    qint64 latency(int _age) const;     // milliseconds, 0 without a reconnect
+
+    static QString formatRate(double _bytesPerSecond);
+
+public slots:
+    // addCounters() timed by the arrival of the counters
+    void addByteCount(qint64 _bytesIn, qint64 _bytesOut);
+    // marks the next sample
+    void addLatency(qint64 _milliseconds);
+
+signals:
+    void sampleAdded();
+
+protected:
+    virtual void paintEvent(QPaintEvent *event);
+
+private:
+    int slot(int _age) const;
+
+    QVector<double> inRates;
+    QVector<double> outRates;
+    QVector<qint64> latencies;
+    int head;       // next slot to write
+    int count;
+    qint64 lastBytesIn;
+    qint64 lastBytesOut;
+    qint64 pendingLatency;
+    QElapsedTimer sampleTimer;
+};
+
+#endif // THROUGHPUTGRAPH_H
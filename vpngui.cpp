@@ -19,6 +19,16 @@
 #include "vpngui.h"
 #include "defines.h"
 #include "configparser.h"
+#include "pemvalidator.h"
+#include "statistics.h"
+#include "mtucalculator.h"
+#include "cipherbenchmark.h"
+#include "compressionbenchmark.h"
+#include "performancepresets.h"
+#include "failoverestimator.h"
+#include "monitordialog.h"
+#include "statusdialog.h"
+#include "backgroundtask.h"
 
 VPNGui::VPNGui(ConfigParser *_configParser, QWidget *parent)
     : QDialog(parent)
@@ -26,6 +36,7 @@ VPNGui::VPNGui(ConfigParser *_configParser, QWidget *parent)
     tabWidget = new QTabWidget;
     tabWidget->addTab(new QuickSettingsTab(_configParser), tr("Basic"));
     tabWidget->addTab(new GeneralSettingsTab(_configParser), tr("General"));
+    tabWidget->addTab(new ResilienceTab(_configParser), tr("Connection"));
     tabWidget->addTab(new ManualEditTab(_configParser), tr("Manual Configuration Editor"));
 
     buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok
@@ -68,6 +79,17 @@ GeneralSettingsTab::GeneralSettingsTab(ConfigParser *_configParser, QWidget *par
     setLayout(layout);
 }
 
+ResilienceTab::ResilienceTab(ConfigParser *_configParser, QWidget *parent)
+    : QWidget(parent)
+{
+    m_pConfigParser = _configParser;
+    createResilienceOptions();
+    connect(_configParser, SIGNAL(configFileOpened()), this, SLOT(updateValues()));
+    QVBoxLayout *layout = new QVBoxLayout;
+    layout->addWidget(m_pResilienceSettingsLayout);
+    setLayout(layout);
+}
+
 ManualEditTab::ManualEditTab(ConfigParser *_configParser, QWidget *parent)
     : QWidget(parent)
 {
@@ -89,13 +111,26 @@ void VPNGui::createMenu(ConfigParser *_configParser)
     newConfigAction = fileMenu->addAction(tr("&Create blank configuration"));
     openConfigAction = fileMenu->addAction(tr("&Open configuration..."));
     saveCreatedConfigAction = fileMenu->addAction(tr("&Save configuration..."));
+    exportProfileSetAction = fileMenu->addAction(tr("&Export profile set..."));
     exitAction = fileMenu->addAction(tr("E&xit"));
 
     configMenu = new QMenu(tr("&Configuration"), this);
     createDefaultConfigAction = configMenu->addAction(tr("&Create default configuration"));
     updateConfigAction = configMenu->addAction(tr("&Update modified configuration"));
+    configMenu->addSeparator();
+    createDefaultServerConfigAction = configMenu->addAction(tr("Create default &server configuration"));
+    generateClientConfigDirAction = configMenu->addAction(tr("&Generate client config dir..."));
+    optimizeRoutesAction = configMenu->addAction(tr("&Optimize routes..."));
+    scaleOutServerAction = configMenu->addAction(tr("Scale out server to &multiple cores..."));
+    configMenu->addSeparator();
+    analyzeLogAction = configMenu->addAction(tr("&Analyze OpenVPN log..."));
+    monitorAction = configMenu->addAction(tr("&Live monitor..."));
+    monitorDialog = new MonitorDialog(_configParser, this);
+    serverStatusAction = configMenu->addAction(tr("Server s&tatus..."));
+    statusDialog = new StatusDialog(this);
 
     helpMenu = new QMenu(tr("&Help"), this);
+    statisticsAction = helpMenu->addAction(tr("&Statistics"));
     aboutAction = helpMenu->addAction(tr("&About %1").arg(APPNAME));
 
     menuBar->addMenu(fileMenu);
@@ -105,12 +140,23 @@ void VPNGui::createMenu(ConfigParser *_configParser)
     connect(newConfigAction, SIGNAL(triggered()), _configParser, SLOT(cleanConfig()));
     connect(openConfigAction, SIGNAL(triggered()), _configParser, SLOT(readConfig()));
     connect(saveCreatedConfigAction, SIGNAL(triggered()), _configParser, SLOT(saveConfig()));
+    connect(exportProfileSetAction, SIGNAL(triggered()), _configParser, SLOT(exportProfileSet()));
     connect(exitAction, SIGNAL(triggered()), this, SLOT(exit()));
 
     connect(createDefaultConfigAction, SIGNAL(triggered()), _configParser,
             SLOT(createDefaultConfig()));
     connect(updateConfigAction, SIGNAL(triggered()), _configParser, SLOT(updateManual()));
-
+    connect(createDefaultServerConfigAction, SIGNAL(triggered()), _configParser,
+            SLOT(createDefaultServerConfig()));
+    connect(generateClientConfigDirAction, SIGNAL(triggered()), _configParser,
+            SLOT(generateClientConfigDir()));
+    connect(optimizeRoutesAction, SIGNAL(triggered()), _configParser, SLOT(optimizeRoutes()));
+    connect(scaleOutServerAction, SIGNAL(triggered()), _configParser, SLOT(scaleOutServer()));
+    connect(analyzeLogAction, SIGNAL(triggered()), _configParser, SLOT(analyzeLog()));
+    connect(monitorAction, SIGNAL(triggered()), monitorDialog, SLOT(show()));
+    connect(serverStatusAction, SIGNAL(triggered()), statusDialog, SLOT(show()));
+
+    connect(statisticsAction, SIGNAL(triggered()), this, SLOT(showStatisticsDlg()));
     connect(aboutAction, SIGNAL(triggered()), this, SLOT(showAboutDlg()));
 }
 
@@ -127,6 +173,16 @@ void VPNGui::showAboutDlg() {
 
 }
 
+void VPNGui::showStatisticsDlg() {
+    QMessageBox statisticsMsg(QMessageBox::Information,
+                              tr("%1 Statistics").arg(APPNAME),
+                              Statistics::instance()->toText());
+
+    statisticsMsg.setDetailedText(QString::fromUtf8(Statistics::instance()->toJson()));
+    statisticsMsg.exec();
+
+}
+
 void VPNGui::exit() {
 
     QMessageBox confirmationMsg(
@@ -188,6 +244,10 @@ void QuickSettingsTab::createQuickOptions()
     m_pLoadUserKeyBtn = new QPushButton(tr("Browse..."));
     connect(m_pLoadUserKeyBtn, SIGNAL(released()), this, SLOT(addCertKey()));
 
+    m_pLoadPkiDirLabel = new QLabel(tr("Export profiles for a PKI directory:"));
+    m_pLoadPkiDirBtn = new QPushButton(tr("Browse..."));
+    connect(m_pLoadPkiDirBtn, SIGNAL(released()), m_pConfigParser, SLOT(exportPkiProfiles()));
+
 
     layout->addRow(m_pProfileLabel, m_pProfileEdit);
     layout->addRow(m_pRemoteHostLabel, m_pRemoteHostEdit);
@@ -197,6 +257,7 @@ void QuickSettingsTab::createQuickOptions()
     layout->addRow(m_pLoadServerCertLabel, m_pLoadServerCertBtn);
     layout->addRow(m_pLoadUserCertLabel, m_pLoadUserCertBtn);
     layout->addRow(m_pLoadUserKeyLabel, m_pLoadUserKeyBtn);
+    layout->addRow(m_pLoadPkiDirLabel, m_pLoadPkiDirBtn);
 
     m_pQuickSettingsLayout->setLayout(layout);
 }
@@ -214,10 +275,36 @@ QString QuickSettingsTab::readContents() {
 }
 
 
+bool QuickSettingsTab::confirmBlock(const QString _tag, const QString _value) {
+    PemValidator::Result result = PemValidator::validate(_tag, _value.toLatin1());
+    if(result == PemValidator::Valid) {
+        return true;
+    }
+
+    QMessageBox confirmationMsg(
+                QMessageBox::Warning,
+                tr("Confirmation"),
+                tr("The selected file does not look like a valid <%1> block: %2"
+                   " Add it anyway?").arg(_tag).arg(PemValidator::describe(result)),
+                QMessageBox::Yes | QMessageBox::No);
+
+    confirmationMsg.setButtonText(QMessageBox::Yes, tr("Yes"));
+    confirmationMsg.setButtonText(QMessageBox::No, tr("No"));
+
+    return confirmationMsg.exec() == QMessageBox::Yes;
+}
+
 void QuickSettingsTab::addCertKey() {
+    Statistics::instance()->increment("user_actions");
     QObject* option = sender();
     QString value = readContents();
 
+    QString tag = (option == m_pLoadServerCertBtn) ? "ca" :
+                  (option == m_pLoadUserCertBtn) ? "cert" : "key";
+    if(!value.contains("N/A") && !confirmBlock(tag, value)) {
+        return;
+    }
+
     if(option == m_pLoadServerCertBtn) {
         m_pConfigParser->addTags("ca", value);
         if(!value.contains("N/A")) m_pLoadServerCertBtn->setText(tr("ADDED"));
@@ -271,6 +358,7 @@ void QuickSettingsTab::updateValues() {
 }
 
 void QuickSettingsTab::setConfig() {
+    Statistics::instance()->increment("user_actions");
 
     m_pConfigParser->addLine("proto " + m_pProtocolComboBox->currentText().toLower());
     if(!m_pRemoteHostEdit->text().isEmpty()) {
@@ -294,37 +382,33 @@ void GeneralSettingsTab::createGeneralOptions()
     QGridLayout *layout = new QGridLayout;
 
     m_pFloatBox = new QCheckBox(tr("Float"));
-    connect(m_pFloatBox, SIGNAL(stateChanged(int)), this, SLOT(setConfig(int)));
-
-    m_pCompLzoBox = new QCheckBox(tr("Compression LZO"));
-    connect(m_pCompLzoBox, SIGNAL(stateChanged(int)), this, SLOT(setConfig(int)));
+    bindSetting(m_pFloatBox, "float", SettingBinding::Flag);
 
     m_pNoBindBox = new QCheckBox(tr("No bind"));
-    connect(m_pNoBindBox, SIGNAL(stateChanged(int)), this, SLOT(setConfig(int)));
+    bindSetting(m_pNoBindBox, "nobind", SettingBinding::Flag);
 
     m_pPersistKeyBox = new QCheckBox(tr("Persist key"));
-    connect(m_pPersistKeyBox, SIGNAL(stateChanged(int)), this, SLOT(setConfig(int)));
+    bindSetting(m_pPersistKeyBox, "persist-key", SettingBinding::Flag);
 
     m_pPersistTunBox = new QCheckBox(tr("Persist tun"));
-    connect(m_pPersistTunBox, SIGNAL(stateChanged(int)), this, SLOT(setConfig(int)));
+    bindSetting(m_pPersistTunBox, "persist-tun", SettingBinding::Flag);
 
     m_pAuthNoCacheBox = new QCheckBox(tr("Auth no-cache"));
-    connect(m_pAuthNoCacheBox, SIGNAL(stateChanged(int)), this, SLOT(setConfig(int)));
+    bindSetting(m_pAuthNoCacheBox, "auth-nocache", SettingBinding::Flag);
 
     m_pAuthUserBox = new QCheckBox(tr("Auth user/pass"));
-    connect(m_pAuthUserBox, SIGNAL(stateChanged(int)), this, SLOT(setConfig(int)));
+    bindSetting(m_pAuthUserBox, "auth-user-pass", SettingBinding::Flag);
 
     m_pRedirectGWBox = new QCheckBox(tr("Redirect gateway"));
-    connect(m_pRedirectGWBox, SIGNAL(stateChanged(int)), this, SLOT(setConfig(int)));
+    bindSetting(m_pRedirectGWBox, "redirect-gateway", SettingBinding::Flag);
 
     layout->addWidget(m_pFloatBox, 0, 0);
-    layout->addWidget(m_pCompLzoBox, 0, 1);
-    layout->addWidget(m_pNoBindBox, 0, 2);
-    layout->addWidget(m_pPersistKeyBox, 0, 3);
-    layout->addWidget(m_pPersistTunBox, 1, 0);
-    layout->addWidget(m_pAuthNoCacheBox, 1, 1);
-    layout->addWidget(m_pAuthUserBox, 1, 2);
-    layout->addWidget(m_pRedirectGWBox, 1, 3);
+    layout->addWidget(m_pNoBindBox, 0, 1);
+    layout->addWidget(m_pPersistKeyBox, 0, 2);
+    layout->addWidget(m_pPersistTunBox, 0, 3);
+    layout->addWidget(m_pAuthNoCacheBox, 1, 0);
+    layout->addWidget(m_pAuthUserBox, 1, 1);
+    layout->addWidget(m_pRedirectGWBox, 1, 2);
     // Device Settings
 
     m_pDeviceLabel = new QLabel(tr("Device:"));
@@ -332,19 +416,88 @@ void GeneralSettingsTab::createGeneralOptions()
     m_pDeviceComboBox->addItem("tap");
     m_pDeviceComboBox->addItem("tun");
     m_pDeviceComboBox->setCurrentIndex(1);
-    connect(m_pDeviceComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(setConfig()));
+    bindSetting(m_pDeviceComboBox, "dev", SettingBinding::Choice);
 
     m_pDeviceMTULabel = new QLabel(tr("Device MTU:"));
     m_pDeviceMTUEdit = new QLineEdit;
-    connect(m_pDeviceMTUEdit, SIGNAL(editingFinished()), this, SLOT(setConfig()));
+    bindSetting(m_pDeviceMTUEdit, "tun-mtu", SettingBinding::Text);
+    m_pMtuCalculatorButton = new QPushButton(tr("Calculate..."));
+    m_pMtuCalculatorButton->setToolTip(tr("Derive tun-mtu, mssfix and fragment from the path MTU"));
+    connect(m_pMtuCalculatorButton, SIGNAL(released()), this, SLOT(showMtuCalculator()));
+    QHBoxLayout *deviceMtuLayout = new QHBoxLayout;
+    deviceMtuLayout->addWidget(m_pDeviceMTUEdit);
+    deviceMtuLayout->addWidget(m_pMtuCalculatorButton);
 
     QGroupBox *m_pDeviceSettingsGroup = new QGroupBox(tr("Device Settings"));
     QFormLayout *deviceFormLayout = new QFormLayout;
     deviceFormLayout->addRow(m_pDeviceLabel, m_pDeviceComboBox);
-    deviceFormLayout->addRow(m_pDeviceMTULabel, m_pDeviceMTUEdit);
+    deviceFormLayout->addRow(m_pDeviceMTULabel, deviceMtuLayout);
     m_pDeviceSettingsGroup->setLayout(deviceFormLayout);
     layout->addWidget(m_pDeviceSettingsGroup, 2, 0, 1, 4);
 
+    // Data channel
+
+    m_pDataCiphersLabel = new QLabel(tr("Data ciphers:"));
+    m_pDataCiphersEdit = new QLineEdit;
+    m_pDataCiphersEdit->setPlaceholderText("AES-256-GCM:AES-128-GCM:CHACHA20-POLY1305");
+    bindSetting(m_pDataCiphersEdit, "data-ciphers", SettingBinding::Text);
+
+    m_pCipherLabel = new QLabel(tr("Fallback cipher:"));
+    m_pCipherEdit = new QLineEdit;
+    bindSetting(m_pCipherEdit, "cipher", SettingBinding::Text);
+
+    m_pCipherBenchmarkButton = new QPushButton(tr("Benchmark ciphers..."));
+    m_pCipherBenchmarkButton->setToolTip(tr("Measure cipher throughput on this machine"));
+    connect(m_pCipherBenchmarkButton, SIGNAL(released()), this, SLOT(runCipherBenchmark()));
+
+    QGroupBox *pDataChannelGroup = new QGroupBox(tr("Data channel"));
+    QFormLayout *pDataChannelFormLayout = new QFormLayout;
+    pDataChannelFormLayout->addRow(m_pDataCiphersLabel, m_pDataCiphersEdit);
+    pDataChannelFormLayout->addRow(m_pCipherLabel, m_pCipherEdit);
+    pDataChannelFormLayout->addRow(m_pCipherBenchmarkButton);
+
+    // the item data is the directive written for each mode
+    m_pCompressionLabel = new QLabel(tr("Compression:"));
+    m_pCompressionComboBox = new QComboBox;
+    m_pCompressionComboBox->addItem(tr("off"), QString());
+    m_pCompressionComboBox->addItem("stub-v2", "compress stub-v2");
+    m_pCompressionComboBox->addItem("lz4-v2", "compress lz4-v2");
+    m_pCompressionComboBox->addItem("lzo", "compress lzo");
+    m_pCompressionComboBox->addItem(tr("comp-lzo (legacy)"), "comp-lzo");
+    connect(m_pCompressionComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(setCompression(int)));
+
+    m_pCompressionBenchmarkButton = new QPushButton(tr("Benchmark compression..."));
+    connect(m_pCompressionBenchmarkButton, SIGNAL(released()), this, SLOT(runCompressionBenchmark()));
+
+    pDataChannelFormLayout->addRow(m_pCompressionLabel, m_pCompressionComboBox);
+    pDataChannelFormLayout->addRow(m_pCompressionBenchmarkButton);
+    pDataChannelGroup->setLayout(pDataChannelFormLayout);
+    layout->addWidget(pDataChannelGroup, 3, 0, 1, 4);
+
+    // Performance
+
+    m_pPresetLabel = new QLabel(tr("Preset:"));
+    m_pPresetComboBox = new QComboBox;
+    QList<PerformancePreset> presets = PerformancePresets::all();
+    for(QList<PerformancePreset>::const_iterator preset = presets.constBegin(); preset != presets.constEnd(); ++preset) {
+        m_pPresetComboBox->addItem(preset->name);
+    }
+    m_pPresetDescriptionLabel = new QLabel;
+    m_pPresetDescriptionLabel->setWordWrap(true);
+    connect(m_pPresetComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(showPresetDescription(int)));
+    showPresetDescription(0);
+
+    m_pApplyPresetButton = new QPushButton(tr("Apply preset"));
+    connect(m_pApplyPresetButton, SIGNAL(released()), this, SLOT(applyPerformancePreset()));
+
+    QGroupBox *pPerformanceGroup = new QGroupBox(tr("Performance"));
+    QFormLayout *pPerformanceFormLayout = new QFormLayout;
+    pPerformanceFormLayout->addRow(m_pPresetLabel, m_pPresetComboBox);
+    pPerformanceFormLayout->addRow(m_pPresetDescriptionLabel);
+    pPerformanceFormLayout->addRow(m_pApplyPresetButton);
+    pPerformanceGroup->setLayout(pPerformanceFormLayout);
+    layout->addWidget(pPerformanceGroup, 4, 0, 1, 4);
+
     // User downgrade
 
     QGroupBox *pUserDowngradeGroup = new QGroupBox(tr("Downgrade user privileges to:"));
@@ -352,16 +505,16 @@ void GeneralSettingsTab::createGeneralOptions()
 
     m_pUserLabel = new QLabel(tr("User:"));
     m_pUserEdit = new QLineEdit();
-    connect(m_pUserEdit, SIGNAL(editingFinished()), this, SLOT(setConfig()));
+    bindSetting(m_pUserEdit, "user", SettingBinding::Text);
 
     m_pGroupLabel = new QLabel(tr("Group:"));
     m_pGroupEdit = new QLineEdit();
-    connect(m_pGroupEdit, SIGNAL(editingFinished()), this, SLOT(setConfig()));
+    bindSetting(m_pGroupEdit, "group", SettingBinding::Text);
 
     pUserFormLayout->addRow(m_pUserLabel, m_pUserEdit);
     pUserFormLayout->addRow(m_pGroupLabel, m_pGroupEdit);
     pUserDowngradeGroup->setLayout(pUserFormLayout);
-    layout->addWidget(pUserDowngradeGroup, 3, 0, 1, 4);
+    layout->addWidget(pUserDowngradeGroup, 5, 0, 1, 4);
 
     // Other
 
@@ -370,30 +523,30 @@ void GeneralSettingsTab::createGeneralOptions()
 
     m_pRouteDelayLabel = new QLabel(tr("Route delay:"));
     m_pRouteDelayEdit = new QLineEdit();
-    connect(m_pRouteDelayEdit, SIGNAL(editingFinished()), this, SLOT(setConfig()));
+    bindSetting(m_pRouteDelayEdit, "route-delay", SettingBinding::Text);
 
     m_pVerbosityLevelLabel = new QLabel(tr("Log verbosity:"));
     m_pVerbosityLevelSpinBox = new QSpinBox();
     m_pVerbosityLevelSpinBox->setRange(0, 11);
     m_pVerbosityLevelSpinBox->setValue(3);
-    connect(m_pVerbosityLevelSpinBox, SIGNAL(editingFinished()), this, SLOT(setConfig()));
+    bindSetting(m_pVerbosityLevelSpinBox, "verb", SettingBinding::Number);
 
 
     m_pMuteLabel = new QLabel(tr("Mute log:"));
     m_pMuteEdit = new QLineEdit();
-    connect(m_pMuteEdit, SIGNAL(editingFinished()), this, SLOT(setConfig()));
+    bindSetting(m_pMuteEdit, "mute", SettingBinding::Text);
 
     m_pMuteReplayWarningsCheckBox = new QCheckBox(tr("Mute replay warnings"));
-    connect(m_pMuteReplayWarningsCheckBox, SIGNAL(stateChanged(int)), this, SLOT(setConfig()));
+    bindSetting(m_pMuteReplayWarningsCheckBox, "mute-replay-warnings", SettingBinding::Flag);
 
     m_pRemoteRandomCheckBox = new QCheckBox(tr("Connect servers randomly"));
-    connect(m_pRemoteRandomCheckBox, SIGNAL(stateChanged(int)), this, SLOT(setConfig()));
+    bindSetting(m_pRemoteRandomCheckBox, "remote-random", SettingBinding::Flag);
 
     m_pNsCertTypeLabel = new QLabel(tr("Certificate Type:"));
     m_pNsCertTypeComboBox = new QComboBox();
     m_pNsCertTypeComboBox->addItem(tr("server"));
     m_pNsCertTypeComboBox->addItem(tr("client"));
-    connect(m_pNsCertTypeComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(setConfig()));
+    bindSetting(m_pNsCertTypeComboBox, "ns-cert-type", SettingBinding::Choice);
 
 
     pOtherFormLayout->addRow(m_pRouteDelayLabel, m_pRouteDelayEdit);
@@ -403,190 +556,573 @@ void GeneralSettingsTab::createGeneralOptions()
     pOtherFormLayout->addRow(m_pNsCertTypeLabel, m_pNsCertTypeComboBox);
 
     pOtherGroup->setLayout(pOtherFormLayout);
-    layout->addWidget(pOtherGroup, 4, 0, 1, 4);
+    layout->addWidget(pOtherGroup, 6, 0, 1, 4);
 
     m_pGeneralSettingsLayout->setLayout(layout);
 }
 
-void GeneralSettingsTab::setConfig() {
-    m_pConfigParser->addLine("dev " + m_pDeviceComboBox->currentText().toLower());
+void GeneralSettingsTab::bindSetting(QWidget *_widget, const QString _directive,
+                                     SettingBinding::Kind _kind) {
+    SettingBinding binding;
+    binding.widget = _widget;
+    binding.directive = _directive;
+    binding.kind = _kind;
+    m_settingBindings.insert(_widget, binding);
+
+    switch(_kind) {
+    case SettingBinding::Flag:
+        connect(_widget, SIGNAL(stateChanged(int)), this, SLOT(setConfig(int)));
+        break;
+    case SettingBinding::Choice:
+        connect(_widget, SIGNAL(currentIndexChanged(int)), this, SLOT(setConfig(int)));
+        break;
+    case SettingBinding::Text:
+    case SettingBinding::Number:
+        connect(_widget, SIGNAL(editingFinished()), this, SLOT(setConfig()));
+        break;
+    }
+}
 
-    if(!m_pDeviceMTUEdit->text().isEmpty()) {
-        m_pConfigParser->addLine("tun-mtu " + m_pDeviceMTUEdit->text());
+QString GeneralSettingsTab::bindingValue(const SettingBinding &_binding) const {
+    switch(_binding.kind) {
+    case SettingBinding::Flag:
+        return QString();
+    case SettingBinding::Choice:
+        return static_cast<QComboBox *>(_binding.widget)->currentText().toLower();
+    case SettingBinding::Text:
+        return static_cast<QLineEdit *>(_binding.widget)->text();
+    case SettingBinding::Number:
+        return static_cast<QSpinBox *>(_binding.widget)->text();
     }
-    else {
-        m_pConfigParser->removeLine("tun-mtu");
+    return QString();
+}
+
+void GeneralSettingsTab::applyBinding(const SettingBinding &_binding) {
+    // only the directive behind the widget is written, and only if it changed
+    if(_binding.kind == SettingBinding::Flag) {
+        bool checked = static_cast<QCheckBox *>(_binding.widget)->isChecked();
+        if(checked == m_pConfigParser->isConfigActive(_binding.directive)) {
+            return;
+        }
+        if(checked) {
+            m_pConfigParser->addLine(_binding.directive);
+        }
+        else {
+            m_pConfigParser->removeLine(_binding.directive);
+        }
+        return;
     }
-    if(!m_pUserEdit->text().isEmpty()) {
-        m_pConfigParser->addLine("user " + m_pUserEdit->text());
+
+    QString value = bindingValue(_binding);
+    bool active = m_pConfigParser->isConfigActive(_binding.directive);
+    if(value.isEmpty()) {
+        if(active) {
+            m_pConfigParser->removeLine(_binding.directive);
+        }
     }
-    else {
-        m_pConfigParser->removeLine("user");
+    else if(!active || m_pConfigParser->getConfigValue(_binding.directive) != value) {
+        m_pConfigParser->addLine(_binding.directive + " " + value);
     }
-    if(!m_pGroupEdit->text().isEmpty()) {
-        m_pConfigParser->addLine("group " + m_pGroupEdit->text());
+}
+
+void GeneralSettingsTab::setConfig() {
+    Statistics::instance()->increment("user_actions");
+    QHash<QObject *, SettingBinding>::const_iterator binding = m_settingBindings.constFind(sender());
+    if(binding != m_settingBindings.constEnd()) {
+        applyBinding(binding.value());
     }
-    else {
-        m_pConfigParser->removeLine("group");
+}
+
+void GeneralSettingsTab::setConfig(int) {
+    setConfig();
+}
+
+void GeneralSettingsTab::showMtuCalculator() {
+    Statistics::instance()->increment("user_actions");
+
+    bool ok;
+    int pathMtu = QInputDialog::getInt(this, tr("MTU calculator"),
+                                       tr("Path MTU between client and server:"),
+                                       1500, 576, 9000, 1, &ok);
+    if(!ok)
+            return;
+
+    QStringList lines = m_pConfigParser->renderConfig().split('\n');
+    MtuCalculator::Result result = MtuCalculator::calculate(
+                MtuCalculator::fromDirectives(lines, pathMtu));
+    if(result.tunMtu < 576) {
+        QMessageBox::warning(this, tr("MTU calculator"),
+                             tr("A path MTU of %1 leaves no usable room for the tunnel.").arg(pathMtu));
+        return;
     }
 
-    if(!m_pRouteDelayEdit->text().isEmpty()) {
-        m_pConfigParser->addLine("route-delay " + m_pRouteDelayEdit->text());
+    QString summary = tr("Per packet overhead: %1 bytes\n\ntun-mtu %2\nmssfix %3\n%4\n\nWrite these values?")
+            .arg(result.overhead).arg(result.tunMtu).arg(result.mssfix)
+            .arg(result.fragment > 0 ? tr("fragment %1").arg(result.fragment)
+                                     : tr("fragment is not needed"));
+    QMessageBox confirmationMsg(
+                QMessageBox::Question,
+                tr("MTU calculator"),
+                summary,
+                QMessageBox::Yes | QMessageBox::No);
+
+    confirmationMsg.setDetailedText(result.breakdown.join("\n"));
+    confirmationMsg.setButtonText(QMessageBox::Yes, tr("Yes"));
+    confirmationMsg.setButtonText(QMessageBox::No, tr("No"));
+
+    if (confirmationMsg.exec() == QMessageBox::No) {
+        return;
     }
-    else {
-        m_pConfigParser->removeLine("route-delay");
+
+    m_pConfigParser->addLine("tun-mtu " + QString::number(result.tunMtu));
+    m_pConfigParser->addLine("mssfix " + QString::number(result.mssfix));
+    if(result.fragment > 0) {
+        m_pConfigParser->addLine("fragment " + QString::number(result.fragment));
     }
-    if(!m_pVerbosityLevelSpinBox->text().isEmpty()) {
-        m_pConfigParser->addLine("verb " + m_pVerbosityLevelSpinBox->text());
+    else if(m_pConfigParser->isConfigActive("fragment")) {
+        m_pConfigParser->removeLine("fragment");
     }
-    else {
-        m_pConfigParser->removeLine("verb");
+    m_pDeviceMTUEdit->setText(QString::number(result.tunMtu));
+}
+
+void GeneralSettingsTab::runCipherBenchmark() {
+    Statistics::instance()->increment("user_actions");
+
+    QList<CipherScore> scores = runInBackground<QList<CipherScore> >(
+                this, tr("Measuring cipher throughput..."), [] { return CipherBenchmark().run(); });
+
+    QStringList dataCiphers = CipherBenchmark::dataCiphers(scores);
+    if(dataCiphers.isEmpty()) {
+        QMessageBox::warning(this, tr("Cipher benchmark"),
+                             tr("The crypto library does not provide any AEAD cipher."));
+        return;
     }
-    if(!m_pMuteEdit->text().isEmpty()) {
-        m_pConfigParser->addLine("mute " + m_pMuteEdit->text());
+
+    QString ranking;
+    for(QList<CipherScore>::const_iterator score = scores.constBegin(); score != scores.constEnd(); ++score) {
+        ranking += tr("%1: %2 MB/s per core%3\n").arg(score->name)
+                .arg(score->megabytesPerSecond, 0, 'f', 0)
+                .arg(score->aead ? QString() : tr(" (legacy, not negotiable)"));
     }
-    else {
-        m_pConfigParser->removeLine("mute");
+    if(CipherBenchmark::aesSupport() == CipherBenchmark::AesSoftware) {
+        ranking += tr("\nThis CPU has no AES instructions, AES ciphers run in software. "
+                      "Peers with AES hardware may still rank them differently.\n");
     }
-    if(m_pMuteReplayWarningsCheckBox->checkState() == Qt::Checked) {
-        m_pConfigParser->addLine("mute-replay-warnings");
+
+    QMessageBox confirmationMsg(
+                QMessageBox::Question,
+                tr("Cipher benchmark"),
+                ranking + tr("\nWrite \"data-ciphers %1\"?").arg(dataCiphers.join(":")),
+                QMessageBox::Yes | QMessageBox::No);
+
+    confirmationMsg.setButtonText(QMessageBox::Yes, tr("Yes"));
+    confirmationMsg.setButtonText(QMessageBox::No, tr("No"));
+
+    if (confirmationMsg.exec() == QMessageBox::No) {
+        return;
     }
-    else {
-        m_pConfigParser->removeLine("mute-replay-warnings");
+
+    // peers without cipher negotiation fall back to the single cipher
+    m_pConfigParser->addLine("data-ciphers " + dataCiphers.join(":"));
+    m_pConfigParser->addLine("cipher " + dataCiphers.first());
+    m_pDataCiphersEdit->setText(dataCiphers.join(":"));
+    m_pCipherEdit->setText(dataCiphers.first());
+}
+
+void GeneralSettingsTab::setCompression(int _index) {
+    Statistics::instance()->increment("user_actions");
+
+    QString directive = m_pCompressionComboBox->itemData(_index).toString();
+    if(m_pConfigParser->isConfigActive("comp-lzo") && directive != "comp-lzo") {
+        m_pConfigParser->removeLine("comp-lzo");
     }
-    if(m_pRemoteRandomCheckBox->checkState() == Qt::Checked) {
-        m_pConfigParser->addLine("remote-random");
+    if(directive.startsWith("compress ")) {
+        if(m_pConfigParser->getConfigValue("compress") != directive.mid(9)) {
+            m_pConfigParser->addLine(directive);
+        }
+        return;
     }
-    else {
-        m_pConfigParser->removeLine("remote-random");
+    if(m_pConfigParser->isConfigActive("compress")) {
+        m_pConfigParser->removeLine("compress");
+    }
+    if(directive == "comp-lzo" && !m_pConfigParser->isConfigActive("comp-lzo")) {
+        m_pConfigParser->addLine(directive);
     }
-    m_pConfigParser->addLine("ns-cert-type " + m_pNsCertTypeComboBox->currentText().toLower());
-
 }
 
-void GeneralSettingsTab::setConfig(int _state) {
-    QObject* option = sender();
+void GeneralSettingsTab::runCompressionBenchmark() {
+    Statistics::instance()->increment("user_actions");
 
-    if(option == m_pFloatBox) {
-            if(_state) {
-                m_pConfigParser->addLine("float");
-            }
-            else {
-                m_pConfigParser->removeLine("float");
-            }
-    }
-    if(option == m_pCompLzoBox) {
-            if(_state) {
-                m_pConfigParser->addLine("comp-lzo");
-            }
-            else {
-                m_pConfigParser->removeLine("comp-lzo");
-            }
+    QMessageBox sourceMsg(
+                QMessageBox::Question,
+                tr("Compression benchmark"),
+                tr("Benchmark with your own sample payloads or with a synthetic mix of"
+                   " text and already encrypted data?"),
+                QMessageBox::Yes | QMessageBox::No);
+
+    sourceMsg.setButtonText(QMessageBox::Yes, tr("Sample files..."));
+    sourceMsg.setButtonText(QMessageBox::No, tr("Synthetic mix"));
+
+    QList<QByteArray> samples;
+    if (sourceMsg.exec() == QMessageBox::Yes) {
+        QStringList files = QFileDialog::getOpenFileNames(this, tr("Select sample payloads"));
+        if(files.isEmpty())
+                return;
+        samples = CompressionBenchmark::loadSamples(files);
     }
-    if(option == m_pNoBindBox) {
-            if(_state) {
-                m_pConfigParser->addLine("nobind");
-            }
-            else {
-                m_pConfigParser->removeLine("nobind");
-            }
+    else {
+        samples = CompressionBenchmark::syntheticSamples();
     }
-    if(option == m_pPersistKeyBox) {
-            if(_state) {
-                m_pConfigParser->addLine("persist-key");
-            }
-            else {
-                m_pConfigParser->removeLine("persist-key");
-            }
+
+    QList<CompressionScore> scores = runInBackground<QList<CompressionScore> >(
+                this, tr("Measuring compression..."),
+                [samples] { return CompressionBenchmark().run(samples); });
+
+    QString report;
+    for(QList<CompressionScore>::const_iterator score = scores.constBegin(); score != scores.constEnd(); ++score) {
+        if(!score->available) {
+            report += tr("%1: not available in this build\n").arg(score->name);
+            continue;
+        }
+        report += tr("%1: %2% of original size, %3 MB/s per core, %4% of packets incompressible\n")
+                .arg(score->name)
+                .arg(score->ratio * 100, 0, 'f', 1)
+                .arg(score->megabytesPerSecond, 0, 'f', 0)
+                .arg(score->incompressible * 100, 0, 'f', 0);
     }
-    if(option == m_pPersistTunBox) {
-            if(_state) {
-                m_pConfigParser->addLine("persist-tun");
-            }
-            else {
-                m_pConfigParser->removeLine("persist-tun");
-            }
+    report += tr("\nIf little is saved, prefer \"stub-v2\" or off: compressing encrypted"
+                 " traffic only costs CPU time.");
+
+    QMessageBox::information(this, tr("Compression benchmark"), report);
+}
+
+void GeneralSettingsTab::showPresetDescription(int _index) {
+    QList<PerformancePreset> presets = PerformancePresets::all();
+    if(_index < 0 || _index >= presets.size()) {
+        return;
     }
-    if(option == m_pAuthNoCacheBox) {
-            if(_state) {
-                m_pConfigParser->addLine("auth-nocache");
-            }
-            else {
-                m_pConfigParser->removeLine("auth-nocache");
-            }
+    QStringList warnings;
+    QStringList lines = PerformancePresets::plan(presets.at(_index),
+                                                 m_pConfigParser->getConfigValue("proto"),
+                                                 m_pConfigParser->isConfigActive("server"),
+                                                 &warnings);
+    m_pPresetDescriptionLabel->setText(tr("%1\nWrites: %2").arg(presets.at(_index).description)
+                                       .arg(lines.join(", ")));
+}
+
+void GeneralSettingsTab::applyPerformancePreset() {
+    Statistics::instance()->increment("user_actions");
+
+    QList<PerformancePreset> presets = PerformancePresets::all();
+    int index = m_pPresetComboBox->currentIndex();
+    if(index < 0 || index >= presets.size()) {
+        return;
     }
-    if(option == m_pAuthUserBox) {
-            if(_state) {
-                m_pConfigParser->addLine("auth-user-pass");
-            }
-            else {
-                m_pConfigParser->removeLine("auth-user-pass");
-            }
+    QStringList warnings;
+    QStringList lines = PerformancePresets::plan(presets.at(index),
+                                                 m_pConfigParser->getConfigValue("proto"),
+                                                 m_pConfigParser->isConfigActive("server"),
+                                                 &warnings);
+
+    QMessageBox confirmationMsg(
+                QMessageBox::Question,
+                tr("Confirmation"),
+                tr("Replace the buffer, queue and logging directives with:\n\n%1\n\n%2Continue?")
+                    .arg(lines.join("\n"))
+                    .arg(warnings.isEmpty() ? QString() : warnings.join("\n") + "\n\n"),
+                QMessageBox::Yes | QMessageBox::No);
+
+    confirmationMsg.setButtonText(QMessageBox::Yes, tr("Yes"));
+    confirmationMsg.setButtonText(QMessageBox::No, tr("No"));
+
+    if (confirmationMsg.exec() == QMessageBox::No) {
+        return;
     }
-    if(option == m_pRedirectGWBox) {
-            if(_state) {
-                m_pConfigParser->addLine("redirect-gateway");
-            }
-            else {
-                m_pConfigParser->removeLine("redirect-gateway");
+    m_pConfigParser->replaceDirectives(PerformancePresets::managedPrefixes(), lines);
+}
+
+void GeneralSettingsTab::updateValues() {
+
+    QHash<QObject *, SettingBinding>::const_iterator i = m_settingBindings.constBegin();
+    while (i != m_settingBindings.constEnd()) {
+        const SettingBinding &binding = i.value();
+        // refreshing the widgets must not write the values straight back
+        QSignalBlocker blocker(binding.widget);
+        QString origin = m_pConfigParser->directiveOrigin(binding.directive);
+        // inherited directives can only be changed in the file that sets them
+        binding.widget->setEnabled(origin.isEmpty());
+        binding.widget->setToolTip(origin.isEmpty() ? QString()
+                                                    : tr("Inherited from %1").arg(origin));
+        switch(binding.kind) {
+        case SettingBinding::Flag:
+            static_cast<QCheckBox *>(binding.widget)->setChecked(
+                        m_pConfigParser->isConfigActive(binding.directive));
+            break;
+        case SettingBinding::Choice: {
+            QComboBox *comboBox = static_cast<QComboBox *>(binding.widget);
+            int index = comboBox->findText(m_pConfigParser->getConfigValue(binding.directive));
+            if (index != -1) { // -1 for not found
+               comboBox->setCurrentIndex(index);
             }
+            break;
+        }
+        case SettingBinding::Text:
+            static_cast<QLineEdit *>(binding.widget)->setText(
+                        m_pConfigParser->getConfigValue(binding.directive));
+            break;
+        case SettingBinding::Number:
+            static_cast<QSpinBox *>(binding.widget)->setValue(
+                        m_pConfigParser->getConfigValue(binding.directive).toInt());
+            break;
+        }
+        ++i;
     }
-    if(option == m_pMuteReplayWarningsCheckBox) {
-            if(_state) {
-                m_pConfigParser->addLine("mute-replay-warnings");
-            }
-            else {
-                m_pConfigParser->removeLine("mute-replay-warnings");
-            }
+
+    QSignalBlocker blocker(m_pCompressionComboBox);
+    QString compression;
+    if(m_pConfigParser->isConfigActive("comp-lzo")) {
+        compression = "comp-lzo";
     }
-    if(option == m_pRemoteRandomCheckBox) {
-            if(_state) {
-                m_pConfigParser->addLine("remote-random");
-            }
-            else {
-                m_pConfigParser->removeLine("remote-random");
-            }
+    else if(m_pConfigParser->isConfigActive("compress")) {
+        compression = "compress " + m_pConfigParser->getConfigValue("compress");
     }
+    int index = m_pCompressionComboBox->findData(compression);
+    m_pCompressionComboBox->setCurrentIndex(index != -1 ? index : 0);
 
+    // what a preset writes depends on proto and client/server mode
+    showPresetDescription(m_pPresetComboBox->currentIndex());
 }
 
-void GeneralSettingsTab::updateValues() {
-
-    m_pFloatBox->setChecked(m_pConfigParser->isConfigActive("float"));
-    m_pCompLzoBox->setChecked(m_pConfigParser->isConfigActive("comp-lzo"));
-    m_pNoBindBox->setChecked(m_pConfigParser->isConfigActive("nobind"));
-    m_pPersistKeyBox->setChecked(m_pConfigParser->isConfigActive("persist-key"));
-    m_pPersistTunBox->setChecked(m_pConfigParser->isConfigActive("persist-tun"));
-    m_pAuthNoCacheBox->setChecked(m_pConfigParser->isConfigActive("auth-nocache"));
-    m_pAuthUserBox->setChecked(m_pConfigParser->isConfigActive("auth-user-pass"));
-    m_pRedirectGWBox->setChecked(m_pConfigParser->isConfigActive("redirect-gateway"));
+void ResilienceTab::createResilienceOptions()
+{
+    m_pResilienceSettingsLayout = new QGroupBox(tr("Connection Resilience"));
+    QVBoxLayout *layout = new QVBoxLayout;
 
-    int index = m_pDeviceComboBox->findText(m_pConfigParser->getConfigValue("dev"));
-    if (index != -1) { // -1 for not found
-       m_pDeviceComboBox->setCurrentIndex(index);
+    // Remotes
+
+    QGroupBox *pRemotesGroup = new QGroupBox(tr("Remote servers, tried in order:"));
+    QGridLayout *pRemotesLayout = new QGridLayout;
+    m_pRemotesTable = new QTableWidget(0, 3);
+    m_pRemotesTable->setHorizontalHeaderLabels(QStringList() << tr("Host") << tr("Port") << tr("Protocol"));
+    m_pRemotesTable->horizontalHeader()->setStretchLastSection(true);
+    connect(m_pRemotesTable, SIGNAL(itemChanged(QTableWidgetItem*)), this, SLOT(updateEstimate()));
+
+    m_pAddRemoteBtn = new QPushButton(tr("Add"));
+    connect(m_pAddRemoteBtn, SIGNAL(released()), this, SLOT(addRemote()));
+    m_pRemoveRemoteBtn = new QPushButton(tr("Remove"));
+    connect(m_pRemoveRemoteBtn, SIGNAL(released()), this, SLOT(removeRemote()));
+
+    pRemotesLayout->addWidget(m_pRemotesTable, 0, 0, 3, 1);
+    pRemotesLayout->addWidget(m_pAddRemoteBtn, 0, 1);
+    pRemotesLayout->addWidget(m_pRemoveRemoteBtn, 1, 1);
+    pRemotesGroup->setLayout(pRemotesLayout);
+    layout->addWidget(pRemotesGroup);
+
+    // Timing
+
+    QGroupBox *pTimingGroup = new QGroupBox(tr("Timing (seconds):"));
+    QFormLayout *pTimingFormLayout = new QFormLayout;
+
+    m_pConnectRetryLabel = new QLabel(tr("Connect retry, initial and maximum delay:"));
+    m_pConnectRetrySpinBox = new QSpinBox;
+    m_pConnectRetrySpinBox->setRange(1, 3600);
+    m_pConnectRetrySpinBox->setValue(5);
+    m_pConnectRetryMaxDelaySpinBox = new QSpinBox;
+    m_pConnectRetryMaxDelaySpinBox->setRange(1, 3600);
+    m_pConnectRetryMaxDelaySpinBox->setValue(300);
+    QHBoxLayout *pConnectRetryLayout = new QHBoxLayout;
+    pConnectRetryLayout->addWidget(m_pConnectRetrySpinBox);
+    pConnectRetryLayout->addWidget(m_pConnectRetryMaxDelaySpinBox);
+
+    m_pConnectRetryMaxLabel = new QLabel(tr("Attempts per remote (0 = unlimited):"));
+    m_pConnectRetryMaxSpinBox = new QSpinBox;
+    m_pConnectRetryMaxSpinBox->setRange(0, 1000);
+
+    m_pServerPollTimeoutLabel = new QLabel(tr("Server poll timeout:"));
+    m_pServerPollTimeoutSpinBox = new QSpinBox;
+    m_pServerPollTimeoutSpinBox->setRange(1, 3600);
+    m_pServerPollTimeoutSpinBox->setValue(120);
+
+    m_pHandWindowLabel = new QLabel(tr("Handshake window:"));
+    m_pHandWindowSpinBox = new QSpinBox;
+    m_pHandWindowSpinBox->setRange(1, 3600);
+    m_pHandWindowSpinBox->setValue(60);
+
+    m_pKeepaliveLabel = new QLabel(tr("Keepalive ping and restart (0 = off):"));
+    m_pPingSpinBox = new QSpinBox;
+    m_pPingSpinBox->setRange(0, 3600);
+    m_pPingRestartSpinBox = new QSpinBox;
+    m_pPingRestartSpinBox->setRange(0, 3600);
+    QHBoxLayout *pKeepaliveLayout = new QHBoxLayout;
+    pKeepaliveLayout->addWidget(m_pPingSpinBox);
+    pKeepaliveLayout->addWidget(m_pPingRestartSpinBox);
+
+    m_pExplicitExitNotifyBox = new QCheckBox(tr("Notify the peer on exit (UDP only)"));
+
+    QList<QSpinBox *> spinBoxes;
+    spinBoxes << m_pConnectRetrySpinBox << m_pConnectRetryMaxDelaySpinBox << m_pConnectRetryMaxSpinBox
+              << m_pServerPollTimeoutSpinBox << m_pHandWindowSpinBox << m_pPingSpinBox
+              << m_pPingRestartSpinBox;
+    for(QList<QSpinBox *>::const_iterator spinBox = spinBoxes.constBegin(); spinBox != spinBoxes.constEnd(); ++spinBox) {
+        connect(*spinBox, SIGNAL(valueChanged(int)), this, SLOT(updateEstimate()));
     }
+    connect(m_pExplicitExitNotifyBox, SIGNAL(stateChanged(int)), this, SLOT(updateEstimate()));
+
+    pTimingFormLayout->addRow(m_pConnectRetryLabel, pConnectRetryLayout);
+    pTimingFormLayout->addRow(m_pConnectRetryMaxLabel, m_pConnectRetryMaxSpinBox);
+    pTimingFormLayout->addRow(m_pServerPollTimeoutLabel, m_pServerPollTimeoutSpinBox);
+    pTimingFormLayout->addRow(m_pHandWindowLabel, m_pHandWindowSpinBox);
+    pTimingFormLayout->addRow(m_pKeepaliveLabel, pKeepaliveLayout);
+    pTimingFormLayout->addRow(m_pExplicitExitNotifyBox);
+    pTimingGroup->setLayout(pTimingFormLayout);
+    layout->addWidget(pTimingGroup);
+
+    // Estimate
+
+    m_pEstimateLabel = new QLabel;
+    m_pEstimateLabel->setWordWrap(true);
+    layout->addWidget(m_pEstimateLabel);
+
+    m_pFastReconnectBtn = new QPushButton(tr("Fast reconnect preset"));
+    connect(m_pFastReconnectBtn, SIGNAL(released()), this, SLOT(useFastReconnect()));
+    m_pApplyBtn = new QPushButton(tr("Apply"));
+    connect(m_pApplyBtn, SIGNAL(released()), this, SLOT(setConfig()));
+    QHBoxLayout *pButtonLayout = new QHBoxLayout;
+    pButtonLayout->addWidget(m_pFastReconnectBtn);
+    pButtonLayout->addWidget(m_pApplyBtn);
+    layout->addLayout(pButtonLayout);
+
+    m_pResilienceSettingsLayout->setLayout(layout);
+    updateEstimate();
+}
 
-    m_pDeviceMTUEdit->setText(m_pConfigParser->getConfigValue("tun-mtu"));
+QStringList ResilienceTab::directiveLines() const {
+    QStringList lines;
+    for(int row = 0; row < m_pRemotesTable->rowCount(); ++row) {
+        // host, port, protocol; the arguments of remote are positional
+        QString fields[3];
+        for(int column = 0; column < 3; ++column) {
+            QTableWidgetItem *item = m_pRemotesTable->item(row, column);
+            fields[column] = item ? item->text().trimmed() : QString();
+        }
+        if(fields[0].isEmpty()) {
+            // a row that is still being filled in
+            continue;
+        }
+        QString remote = "remote " + fields[0];
+        if(!fields[1].isEmpty() || !fields[2].isEmpty()) {
+            remote += " " + (fields[1].isEmpty() ? QString("1194") : fields[1]);
+        }
+        if(!fields[2].isEmpty()) {
+            remote += " " + fields[2];
+        }
+        lines << remote;
+    }
+    lines << QString("connect-retry %1 %2").arg(m_pConnectRetrySpinBox->value())
+                                           .arg(m_pConnectRetryMaxDelaySpinBox->value());
+    if(m_pConnectRetryMaxSpinBox->value() > 0) {
+        lines << "connect-retry-max " + QString::number(m_pConnectRetryMaxSpinBox->value());
+    }
+    lines << "server-poll-timeout " + QString::number(m_pServerPollTimeoutSpinBox->value())
+          << "hand-window " + QString::number(m_pHandWindowSpinBox->value());
+    if(m_pPingSpinBox->value() > 0 && m_pPingRestartSpinBox->value() > 0) {
+        lines << QString("keepalive %1 %2").arg(m_pPingSpinBox->value()).arg(m_pPingRestartSpinBox->value());
+    }
+    else if(m_pPingSpinBox->value() > 0) {
+        lines << "ping " + QString::number(m_pPingSpinBox->value());
+    }
+    else if(m_pPingRestartSpinBox->value() > 0) {
+        lines << "ping-restart " + QString::number(m_pPingRestartSpinBox->value());
+    }
+    if(m_pExplicitExitNotifyBox->isChecked()) {
+        lines << "explicit-exit-notify 2";
+    }
+    return lines;
+}
 
-    m_pUserEdit->setText(m_pConfigParser->getConfigValue("user"));
-    m_pGroupEdit->setText(m_pConfigParser->getConfigValue("group"));
+void ResilienceTab::updateEstimate() {
+    QStringList lines = directiveLines();
+    lines << "proto " + m_pConfigParser->getConfigValue("proto");
+    FailoverEstimate estimate = FailoverEstimator::estimate(FailoverEstimator::fromDirectives(lines));
 
+    QString text;
+    if(estimate.crashSeconds >= 0) {
+        text = tr("Worst case failover: %1 s after a crash, %2 s after a planned shutdown.")
+                .arg(estimate.crashSeconds).arg(estimate.plannedSeconds);
+    }
+    else {
+        text = tr("Worst case failover: the client does not fail over on its own.");
+    }
+    text += "\n" + estimate.breakdown.join("\n");
+    if(!estimate.warnings.isEmpty()) {
+        text += "\n\n" + estimate.warnings.join("\n");
+    }
+    m_pEstimateLabel->setText(text);
+}
 
-    m_pRouteDelayEdit->setText(m_pConfigParser->getConfigValue("route-delay"));
+void ResilienceTab::addRemote() {
+    int row = m_pRemotesTable->rowCount();
+    m_pRemotesTable->insertRow(row);
+    m_pRemotesTable->setItem(row, 1, new QTableWidgetItem("1194"));
+    m_pRemotesTable->setItem(row, 2, new QTableWidgetItem(m_pConfigParser->getConfigValue("proto")));
+    m_pRemotesTable->setItem(row, 0, new QTableWidgetItem);
+    m_pRemotesTable->editItem(m_pRemotesTable->item(row, 0));
+}
 
-    m_pVerbosityLevelSpinBox->setValue(m_pConfigParser->getConfigValue("verb").toInt());
+void ResilienceTab::removeRemote() {
+    if(m_pRemotesTable->currentRow() >= 0) {
+        m_pRemotesTable->removeRow(m_pRemotesTable->currentRow());
+        updateEstimate();
+    }
+}
 
-    m_pMuteEdit->setText(m_pConfigParser->getConfigValue("mute"));
+void ResilienceTab::useFastReconnect() {
+    // short timeouts only pay off when there is somewhere else to go
+    m_pConnectRetrySpinBox->setValue(2);
+    m_pConnectRetryMaxDelaySpinBox->setValue(10);
+    m_pConnectRetryMaxSpinBox->setValue(0);
+    m_pServerPollTimeoutSpinBox->setValue(10);
+    m_pHandWindowSpinBox->setValue(20);
+    m_pPingSpinBox->setValue(5);
+    m_pPingRestartSpinBox->setValue(20);
+    m_pExplicitExitNotifyBox->setChecked(!m_pConfigParser->getConfigValue("proto").startsWith("tcp"));
+    updateEstimate();
+}
 
-    m_pMuteReplayWarningsCheckBox->setChecked(m_pConfigParser->isConfigActive("mute-replay-warnings"));
+void ResilienceTab::setConfig() {
+    Statistics::instance()->increment("user_actions");
 
-    m_pRemoteRandomCheckBox->setChecked(m_pConfigParser->isConfigActive("remote-random"));
+    QStringList prefixes;
+    prefixes << "remote " << "connect-retry " << "connect-retry-max " << "server-poll-timeout "
+             << "connect-timeout " << "hand-window " << "keepalive " << "ping " << "ping-restart "
+             << "explicit-exit-notify";
+    m_pConfigParser->replaceDirectives(prefixes, directiveLines());
+}
 
-    index = m_pNsCertTypeComboBox->findText(m_pConfigParser->getConfigValue("ns-cert-type"));
-    if (index != -1) { // -1 for not found
-       m_pNsCertTypeComboBox->setCurrentIndex(index);
+void ResilienceTab::updateValues() {
+    QStringList remotes = m_pConfigParser->linesStartingWith("remote ");
+    ResilienceSettings settings = FailoverEstimator::fromDirectives(
+                m_pConfigParser->getFileContents().split('\n'));
+
+    QSignalBlocker tableBlocker(m_pRemotesTable);
+    m_pRemotesTable->setRowCount(0);
+    for(QStringList::const_iterator remote = remotes.constBegin(); remote != remotes.constEnd(); ++remote) {
+        QStringList fields = remote->simplified().split(' ');
+        int row = m_pRemotesTable->rowCount();
+        m_pRemotesTable->insertRow(row);
+        for(int column = 0; column < 3 && column + 1 < fields.size(); ++column) {
+            m_pRemotesTable->setItem(row, column, new QTableWidgetItem(fields.at(column + 1)));
+        }
     }
-
+    m_pConnectRetrySpinBox->setValue(settings.connectRetry);
+    m_pConnectRetryMaxDelaySpinBox->setValue(settings.connectRetryMaxDelay);
+    m_pConnectRetryMaxSpinBox->setValue(settings.connectRetryMax);
+    m_pServerPollTimeoutSpinBox->setValue(settings.serverPollTimeout);
+    m_pHandWindowSpinBox->setValue(settings.handWindow);
+    m_pPingSpinBox->setValue(settings.pingInterval);
+    m_pPingRestartSpinBox->setValue(settings.pingRestart);
+    m_pExplicitExitNotifyBox->setChecked(settings.explicitExitNotify);
+    updateEstimate();
 }
 
 void ManualEditTab::createManualEditOptions() {
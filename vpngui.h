@@ -18,8 +18,11 @@
 
 
 #include <QDialog>
+#include <QHash>
 
 class ConfigParser;
+class MonitorDialog;
+class StatusDialog;
 
 QT_BEGIN_NAMESPACE
 class QDialogButtonBox;
@@ -36,6 +39,7 @@ class QTextEdit;
 class QCheckBox;
 class QComboBox;
 class QSpinBox;
+class QTableWidget;
 QT_END_NAMESPACE
 
 class VPNGui : public QDialog
@@ -49,6 +53,7 @@ public:
 public slots:
     void exit();
     void showAboutDlg();
+    void showStatisticsDlg();
 
 protected:
     virtual void keyPressEvent(QKeyEvent *event);
@@ -69,12 +74,24 @@ private:
     QAction *openConfigAction;
     QAction *createDefaultConfigAction;
     QAction *saveCreatedConfigAction;
+    QAction *exportProfileSetAction;
     QAction *exitAction;
 
     QMenu *configMenu;
     QAction *updateConfigAction;
+    QAction *createDefaultServerConfigAction;
+    QAction *generateClientConfigDirAction;
+    QAction *optimizeRoutesAction;
+    QAction *scaleOutServerAction;
+    QAction *analyzeLogAction;
+
+    QAction *monitorAction;
+    MonitorDialog *monitorDialog;
+    QAction *serverStatusAction;
+    StatusDialog *statusDialog;
 
     QMenu *helpMenu;
+    QAction *statisticsAction;
     QAction *aboutAction;
 };
 
@@ -93,6 +110,7 @@ public slots:
 
 private:
     void createQuickOptions();
+    bool confirmBlock(const QString _tag, const QString _value);
     QGroupBox *m_pQuickSettingsLayout;
 
     QLabel *m_pProfileLabel;
@@ -122,9 +140,23 @@ private:
     QLabel *m_pLoadUserKeyLabel;
     QPushButton *m_pLoadUserKeyBtn;
 
+    QLabel *m_pLoadPkiDirLabel;
+    QPushButton *m_pLoadPkiDirBtn;
+
 
 };
 
+// Maps a settings widget to the directive it edits. Flags add or remove a
+// single-word directive, the other kinds write "<directive> <value>" and
+// remove the directive when the value is empty.
+struct SettingBinding
+{
+    enum Kind { Flag, Text, Choice, Number };
+    QWidget *widget;
+    QString directive;
+    Kind kind;
+};
+
 class GeneralSettingsTab : public QWidget
 {
     Q_OBJECT
@@ -137,13 +169,22 @@ public slots:
     void updateValues();
     void setConfig(int);
     void setConfig();
+    void showMtuCalculator();
+    void runCipherBenchmark();
+    void setCompression(int _index);
+    void runCompressionBenchmark();
+    void showPresetDescription(int _index);
+    void applyPerformancePreset();
 
 private:
     void createGeneralOptions();
+    void bindSetting(QWidget *_widget, const QString _directive, SettingBinding::Kind _kind);
+    QString bindingValue(const SettingBinding &_binding) const;
+    void applyBinding(const SettingBinding &_binding);
+    QHash<QObject *, SettingBinding> m_settingBindings;
     // general options
     ConfigParser *m_pConfigParser;
     QGroupBox *m_pGeneralSettingsLayout;
-    QCheckBox *m_pCompLzoBox;
     QCheckBox *m_pFloatBox;
     QCheckBox *m_pPersistKeyBox;
     QCheckBox *m_pPersistTunBox;
@@ -178,6 +219,65 @@ private:
     QComboBox *m_pDeviceComboBox;
     QLabel *m_pDeviceMTULabel;
     QLineEdit *m_pDeviceMTUEdit;
+    QPushButton *m_pMtuCalculatorButton;
+
+    QLabel *m_pDataCiphersLabel;
+    QLineEdit *m_pDataCiphersEdit;
+    QLabel *m_pCipherLabel;
+    QLineEdit *m_pCipherEdit;
+    QPushButton *m_pCipherBenchmarkButton;
+    QLabel *m_pCompressionLabel;
+    QComboBox *m_pCompressionComboBox;
+    QPushButton *m_pCompressionBenchmarkButton;
+
+    QLabel *m_pPresetLabel;
+    QComboBox *m_pPresetComboBox;
+    QLabel *m_pPresetDescriptionLabel;
+    QPushButton *m_pApplyPresetButton;
+};
+
+class ResilienceTab : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ResilienceTab(ConfigParser *_configParser, QWidget *parent = 0);
+
+public slots:
+    void updateValues();
+    void updateEstimate();
+    void addRemote();
+    void removeRemote();
+    void useFastReconnect();
+    void setConfig();
+
+private:
+    void createResilienceOptions();
+    QStringList directiveLines() const;
+    ConfigParser *m_pConfigParser;
+    QGroupBox *m_pResilienceSettingsLayout;
+
+    QTableWidget *m_pRemotesTable;
+    QPushButton *m_pAddRemoteBtn;
+    QPushButton *m_pRemoveRemoteBtn;
+
+    QLabel *m_pConnectRetryLabel;
+    QSpinBox *m_pConnectRetrySpinBox;
+    QSpinBox *m_pConnectRetryMaxDelaySpinBox;
+    QLabel *m_pConnectRetryMaxLabel;
+    QSpinBox *m_pConnectRetryMaxSpinBox;
+    QLabel *m_pServerPollTimeoutLabel;
+    QSpinBox *m_pServerPollTimeoutSpinBox;
+    QLabel *m_pHandWindowLabel;
+    QSpinBox *m_pHandWindowSpinBox;
+    QLabel *m_pKeepaliveLabel;
+    QSpinBox *m_pPingSpinBox;
+    QSpinBox *m_pPingRestartSpinBox;
+    QCheckBox *m_pExplicitExitNotifyBox;
+
+    QLabel *m_pEstimateLabel;
+    QPushButton *m_pFastReconnectBtn;
+    QPushButton *m_pApplyBtn;
 };
 
 class ManualEditTab : public QWidget